@@ -0,0 +1,211 @@
+// JSON 解析与序列化基准：小命令报文与多 MB 文档
+// 用法: json_bench [iterations_scale]
+
+#include "JsonBind.h"
+#include "JsonDocument.h"
+#include "JsonLazy.h"
+#include "JsonStructural.h"
+#include "JsonValue.h"
+#include "JsonWriter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <malloc.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 绑定测试用的命令结构，args 不绑定，解码时整体跳过
+struct Command {
+    std::string host;
+    std::string command;
+    bool dry_run = false;
+    int64_t priority = 0;
+};
+JSON_BIND(Command, host, command, dry_run, priority)
+
+std::string make_command(int i) {
+    return "{\"host\":\"10.0." + std::to_string(i % 256) + "." +
+           std::to_string(i % 100) +
+           "\",\"command\":\"restart\",\"args\":[\"--force\",\"--timeout\"," +
+           std::to_string(i % 60) + "],\"dry_run\":false,\"priority\":" +
+           std::to_string(i % 10) + "}";
+}
+
+// 记录数组，字符串、数字、嵌套对象混合
+std::string make_records(size_t target_bytes) {
+    std::string s = "[";
+    for (int i = 0; s.size() < target_bytes; i++) {
+        if (i) {
+            s += ",\n  ";
+        }
+        s += "{\"id\": " + std::to_string(i) +
+             ", \"name\": \"record-" + std::to_string(i) +
+             "\", \"tags\": [\"alpha\", \"beta\", \"gamma\"], \"score\": " +
+             std::to_string(i * 0.37) +
+             ", \"active\": true, \"owner\": null, \"meta\": {\"path\": "
+             "\"/var/lib/data/" +
+             std::to_string(i) + "\\n\", \"size\": " +
+             std::to_string(i * 131) + "}}";
+    }
+    s += "]";
+    return s;
+}
+
+// 以数字为主的文档：整数与小数各占一半
+std::string make_numbers(size_t target_bytes) {
+    std::string s = "[";
+    for (int64_t i = 0; s.size() < target_bytes; i++) {
+        if (i) {
+            s += ",";
+        }
+        s += "[" + std::to_string(i * 7919) + "," +
+             std::to_string(-i * 31) + "," + std::to_string(i * 0.001) +
+             "," + std::to_string(i / 3.0) + "e-2]";
+    }
+    s += "]";
+    return s;
+}
+
+// 以长字符串为主的文档
+std::string make_text(size_t target_bytes) {
+    std::string s = "[";
+    std::string line(400, 'x');
+    for (int i = 0; s.size() < target_bytes; i++) {
+        if (i) {
+            s += ",";
+        }
+        s += "\"" + line + std::to_string(i) + "\"";
+    }
+    s += "]";
+    return s;
+}
+
+void run(const char *name, const std::vector<std::string> &inputs,
+         int iterations, const std::function<void(const std::string &)> &fn) {
+    size_t bytes = 0;
+    for (auto &in : inputs) {
+        bytes += in.size();
+    }
+
+    for (auto &in : inputs) {
+        fn(in); // 预热
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (auto &in : inputs) {
+            fn(in);
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    double mb = static_cast<double>(bytes) * iterations / (1024.0 * 1024.0);
+    std::printf("  %-28s %9.1f MB/s  %10.0f docs/s\n", name, mb / seconds,
+                inputs.size() * iterations / seconds);
+}
+
+void run_suite(const char *title, const std::vector<std::string> &inputs,
+               int iterations) {
+    std::printf("%s (%zu docs, %zu bytes each)\n", title, inputs.size(),
+                inputs.front().size());
+    run("JsonValue::parse", inputs, iterations,
+        [](const std::string &in) { JsonValue::parse(in); });
+    run("JsonDocument::parse", inputs, iterations,
+        [](const std::string &in) { JsonDocument::parse(in); });
+    // 按需访问：校验并建索引后只取一个字段
+    run("JsonLazyDocument + pointer", inputs, iterations,
+        [](const std::string &in) {
+            JsonLazyDocument::parse(in).find_pointer("/host");
+        });
+
+    // 序列化：输入预先解析好，只计时输出（吞吐按输入字节计）
+    std::vector<JsonValue> values;
+    for (auto &in : inputs) {
+        values.push_back(JsonValue::parse(in));
+    }
+    size_t next = 0;
+    std::string out;
+    run("JsonWriter", inputs, iterations, [&](const std::string &) {
+        out.clear();
+        JsonWriter(out).write(values[next++ % values.size()]);
+    });
+
+    // 只运行第一阶段，比较各 SIMD 实现
+    std::vector<uint32_t> index;
+    std::vector<json::SimdLevel> levels = {json::SimdLevel::Scalar};
+    if (json::best_simd_level() != json::SimdLevel::Scalar) {
+#if defined(__x86_64__)
+        levels.push_back(json::SimdLevel::SSE2);
+#endif
+        if (json::best_simd_level() != json::SimdLevel::SSE2) {
+            levels.push_back(json::best_simd_level());
+        }
+    }
+    for (auto level : levels) {
+        std::string name =
+            std::string("stage 1 (") + json::simd_level_name(level) + ")";
+        run(name.c_str(), inputs, iterations,
+            [&](const std::string &in) {
+                json::build_structural_index(in, index, level);
+            });
+    }
+}
+
+// 已分配的堆内存，包括直接 mmap 的大块
+size_t heap_in_use() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// 解析结果占用的堆内存
+void footprint(const char *title, const std::string &doc) {
+    std::printf("%s (%zu bytes), sizeof(JsonValue) = %zu\n", title,
+                doc.size(), sizeof(JsonValue));
+
+    size_t before = heap_in_use();
+    {
+        JsonValue value = JsonValue::parse(doc);
+        size_t held = heap_in_use() - before;
+        std::printf("  %-28s %9.1f MB  %8.2f bytes/input byte\n",
+                    "JsonValue::parse", held / (1024.0 * 1024.0),
+                    static_cast<double>(held) / doc.size());
+    }
+
+    before = heap_in_use();
+    {
+        JsonDocument document = JsonDocument::parse(doc);
+        size_t held = heap_in_use() - before;
+        std::printf("  %-28s %9.1f MB  %8.2f bytes/input byte\n",
+                    "JsonDocument::parse", held / (1024.0 * 1024.0),
+                    static_cast<double>(held) / doc.size());
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int scale = argc > 1 ? std::atoi(argv[1]) : 1;
+
+    std::vector<std::string> commands;
+    for (int i = 0; i < 1000; i++) {
+        commands.push_back(make_command(i));
+    }
+
+    run_suite("small command payloads", commands, 200 * scale);
+    Command command;
+    run("json::from_json<Command>", commands, 200 * scale,
+        [&](const std::string &in) { json::from_json(in, command); });
+    run("json::to_json<Command>", commands, 200 * scale,
+        [&](const std::string &) { json::to_json(command); });
+    run_suite("records document", {make_records(4 << 20)}, 5 * scale);
+    run_suite("number-heavy document", {make_numbers(4 << 20)}, 5 * scale);
+    run_suite("string-heavy document", {make_text(4 << 20)}, 5 * scale);
+    footprint("memory footprint, number-heavy document",
+              make_numbers(100 << 20));
+    return 0;
+}
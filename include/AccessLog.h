@@ -0,0 +1,111 @@
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include "Method.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace access_log {
+class BinaryEncoder;
+}
+
+// 一条访问记录，定长且可以按位复制，I/O 线程只填字段不做格式化
+struct AccessRecord {
+    static constexpr size_t kMaxTarget = 128;
+    static constexpr size_t kMaxExtension = 16;
+
+    int64_t time_us = 0;    // 响应结束的时间，Unix 时间戳（微秒）
+    uint64_t bytes = 0;     // 写入套接字的字节数，含头部
+    uint32_t latency_us = 0;
+    uint16_t status = 0;
+    Method method = Method::Extension;
+    uint8_t target_size = 0;
+    uint8_t extension_size = 0;
+    char target[kMaxTarget]; // 路径与查询串，超长部分截断
+    char extension[kMaxExtension]; // method 为 Extension 时的原始方法名
+    // 匹配的路由模式，指向 Router 中的字符串，路由表在服务期间不变
+    std::string_view route;
+
+    void set_target(std::string_view path, std::string_view query);
+    void set_method(Method m, std::string_view extension_method);
+    // 日志中显示的方法名，未知的扩展方法写 "-"
+    std::string_view method_view() const;
+    std::string_view target_view() const {
+        return std::string_view(target, target_size);
+    }
+};
+
+// 异步访问日志
+//
+// 各 I/O 线程把记录放入一个无锁的有界环形队列（多生产者、单消费者），
+// 后台线程取出后格式化为文本行或编码为二进制条目（见 BinaryAccessLog.h），
+// 攒到 64 KB 或空闲超过 100 ms 时一次 write() 追加到文件。
+// 队列满时按 Overflow 处理：Drop 丢弃并计数，丢弃的条数由后台线程
+// 写入日志；Block 让出 CPU 直到有空位。析构时写完队列中剩余的记录。
+class AccessLog {
+  public:
+    enum class Overflow : uint8_t { Drop, Block };
+    enum class Format : uint8_t { Text, Binary };
+
+    // capacity 向上取 2 的幂；文件无法打开时抛出 std::runtime_error
+    explicit AccessLog(const std::string &path, size_t capacity = 8192,
+                       Overflow overflow = Overflow::Drop,
+                       Format format = Format::Text);
+    ~AccessLog();
+
+    AccessLog(const AccessLog &) = delete;
+    AccessLog &operator=(const AccessLog &) = delete;
+
+    // 可以在任意线程调用，不加锁、不分配、不做系统调用
+    void record(const AccessRecord &record);
+
+    // 因队列满被丢弃的总条数
+    uint64_t dropped() const { return dropped_total_.load(); }
+
+  private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        AccessRecord record;
+    };
+
+    bool try_push(const AccessRecord &record);
+    bool try_pop(AccessRecord &record);
+    void run();
+    void format(const AccessRecord &record, std::string &out);
+    void write_out(std::string &out);
+
+    int fd_ = -1;
+    Overflow overflow_;
+    std::unique_ptr<access_log::BinaryEncoder> encoder_; // 二进制格式时有效
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> head_{0}; // 下一个写入位置
+    alignas(64) size_t tail_ = 0;             // 下一个读取位置，只由后台线程访问
+    std::atomic<uint64_t> dropped_{0};        // 尚未报告的丢弃条数
+    std::atomic<uint64_t> dropped_total_{0};
+    std::atomic<bool> stop_{false};
+    int64_t cached_second_ = -1; // 上次格式化的秒及其文本
+    char cached_time_[32] = {};
+    std::thread thread_;
+};
+
+// 错误日志限流：每秒最多放行 per_second 次，多个线程共用
+class RateLimiter {
+  public:
+    explicit RateLimiter(uint32_t per_second) : limit_(per_second) {}
+
+    // 返回 true 时可以记录，suppressed 为上次放行以来被抑制的次数
+    bool allow(uint64_t &suppressed);
+
+  private:
+    uint32_t limit_;
+    std::atomic<int64_t> window_{-1};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// 单调递增的 bump 分配器
+// 只分配不释放，内存块在 reset() 或析构时一次性回收；
+// 因此只能存放平凡析构的对象。
+class Arena {
+  public:
+    explicit Arena(size_t initial_block_size = 4096);
+
+    Arena(Arena &&other) noexcept;
+    Arena &operator=(Arena &&other) noexcept;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        uintptr_t current = reinterpret_cast<uintptr_t>(cursor_);
+        uintptr_t aligned = (current + align - 1) & ~(uintptr_t(align) - 1);
+        if (aligned + size <= reinterpret_cast<uintptr_t>(limit_)) {
+            cursor_ = reinterpret_cast<char *>(aligned + size);
+            return reinterpret_cast<void *>(aligned);
+        }
+        return allocate_slow(size, align);
+    }
+
+    template <typename T>
+    T *allocate_array(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    std::string_view copy_string(std::string_view s);
+
+    // 保留最大的内存块，其余归还给系统
+    void reset();
+
+    size_t bytes_reserved() const { return bytes_reserved_; }
+    size_t block_count() const { return blocks_.size(); }
+
+  private:
+    void *allocate_slow(size_t size, size_t align);
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    char *cursor_ = nullptr;
+    char *limit_ = nullptr;
+    size_t next_block_size_;
+    size_t bytes_reserved_ = 0;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef BINARY_ACCESS_LOG_H
+#define BINARY_ACCESS_LOG_H
+
+#include "AccessLog.h"
+#include "Method.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 二进制访问日志格式
+//
+// 文件由 8 字节对齐的条目组成，首字节是条目类型，整数都是小端序：
+//   Header  16 字节：类型、版本、保留 2 字节、"DSAL"、开始时间（i64 微秒）。
+//           每次打开日志以及字符串表清空时写入，之后字符串重新编号
+//   String  8 字节头（类型、保留、长度 u16、编号 u32）后接内容，
+//           补齐到 8 字节；编号从 1 开始，0 表示没有
+//   Access  32 字节：类型、方法、状态码 u16、耗时 u32（微秒）、
+//           时间 i64（微秒）、字节数 u64、目标编号 u32、路由编号 u32
+//   Dropped 16 字节：类型、保留 7 字节、因队列满丢弃的条数 u64
+//
+// 路径和路由模式各自只在第一次出现时写出内容，之后的记录只写编号。
+namespace access_log {
+
+enum class EntryKind : uint8_t { Header = 0, String = 1, Access = 2,
+                                 Dropped = 3 };
+
+constexpr uint8_t kFormatVersion = 1;
+constexpr size_t kAccessEntrySize = 32;
+
+// 由 AccessLog 的后台线程使用，把记录编码后追加到 out
+class BinaryEncoder {
+  public:
+    // 字符串表超过这个大小就清空，内存占用不随不同路径的数量增长
+    static constexpr size_t kMaxStrings = 1 << 16;
+
+    // 写入 Header 并清空字符串表
+    void begin(int64_t time_us, std::string &out);
+    void encode(const AccessRecord &record, std::string &out);
+    void dropped(uint64_t count, std::string &out);
+
+  private:
+    uint32_t intern(std::string_view s, std::string &out);
+
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::string key_; // 查找用，避免每次构造临时字符串
+    uint32_t next_id_ = 1;
+};
+
+// 解码后的一条访问记录，字符串视图只在回调期间有效
+struct DecodedRecord {
+    int64_t time_us = 0;
+    uint64_t bytes = 0;
+    uint32_t latency_us = 0;
+    uint16_t status = 0;
+    Method method = Method::Extension;
+    std::string_view target;
+    std::string_view route; // 没有匹配的路由时为空
+};
+
+// 可以分段输入的解码器，数据损坏时抛出 std::runtime_error
+class BinaryDecoder {
+  public:
+    using RecordCallback = std::function<void(const DecodedRecord &)>;
+    using DroppedCallback = std::function<void(uint64_t)>;
+
+    explicit BinaryDecoder(RecordCallback on_record,
+                           DroppedCallback on_dropped = {});
+
+    void feed(std::string_view data);
+
+    // 输入结束，最后一个条目不完整时抛出 std::runtime_error
+    void finish();
+
+  private:
+    // 解析 data 开头的一个完整条目，返回其长度；不完整时返回 0
+    size_t parse_entry(std::string_view data);
+    std::string_view lookup(uint32_t id) const;
+
+    RecordCallback on_record_;
+    DroppedCallback on_dropped_;
+    std::string pending_;
+    uint64_t offset_ = 0; // pending_ 开头在输入中的位置
+    std::unordered_map<uint32_t, std::string> strings_;
+};
+
+} // namespace access_log
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef HEADER_MAP_H
+#define HEADER_MAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 常用头部的编号，查找时通过完美哈希直接定位
+enum class Header : uint8_t {
+    Host,
+    ContentLength,
+    ContentType,
+    Connection,
+    Accept,
+    AcceptEncoding,
+    AcceptLanguage,
+    UserAgent,
+    TransferEncoding,
+    ContentEncoding,
+    Cookie,
+    SetCookie,
+    Authorization,
+    CacheControl,
+    IfNoneMatch,
+    IfModifiedSince,
+    LastModified,
+    ETag,
+    Range,
+    Referer,
+    Origin,
+    Expect,
+    Upgrade,
+    KeepAlive,
+    Date,
+    Server,
+    Location,
+    Allow,
+    Vary,
+    Unknown,
+};
+
+constexpr size_t kKnownHeaderCount = static_cast<size_t>(Header::Unknown);
+
+// 大小写无关地识别头部名，非常用头部返回 Header::Unknown
+Header lookup_header(std::string_view name);
+
+std::string_view header_name(Header id);
+
+bool iequals(std::string_view a, std::string_view b);
+
+// 紧凑的头部容器
+// 所有名字和值连续存放在同一块缓冲区中，条目只保存偏移量；
+// 前 kInlineEntries 个条目内联存储，常用头部可 O(1) 查找，
+// 其余头部按大小写无关方式线性比较。
+// 缓冲区从构造时给定的内存资源分配，请求与响应使用请求级 arena。
+class HeaderMap {
+  public:
+    static constexpr size_t kInlineEntries = 16;
+
+    explicit HeaderMap(std::pmr::memory_resource *resource =
+                           std::pmr::get_default_resource())
+        : overflow_(resource), bytes_(resource) {}
+
+    // 追加一个头部，允许重名（解析请求时使用）
+    void add(std::string_view name, std::string_view value);
+
+    // 设置头部，已存在时覆盖第一个同名头部的值
+    void set(std::string_view name, std::string_view value);
+    void set(Header id, std::string_view value);
+
+    bool contains(Header id) const;
+    bool contains(std::string_view name) const;
+
+    // 不存在时返回空视图
+    std::string_view get(Header id) const;
+    std::string_view get(std::string_view name) const;
+
+    void erase(Header id);
+    void erase(std::string_view name);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear();
+
+    // 清空并归还缓冲区（clear() 会保留），所在 arena 回收前调用
+    void release();
+
+    class const_iterator {
+      public:
+        using value_type = std::pair<std::string_view, std::string_view>;
+
+        const_iterator(const HeaderMap *map, size_t index)
+            : map_(map), index_(index) {}
+
+        value_type operator*() const { return map_->field(index_); }
+        const_iterator &operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator!=(const const_iterator &other) const {
+            return index_ != other.index_;
+        }
+
+      private:
+        const HeaderMap *map_;
+        size_t index_;
+    };
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, size_}; }
+
+  private:
+    struct Entry {
+        uint32_t name_offset;
+        uint32_t value_offset;
+        uint32_t value_length;
+        uint16_t name_length; // 常用头部不保存名字，长度为 0
+        Header id;
+    };
+
+    Entry &entry(size_t index) {
+        return index < kInlineEntries ? inline_[index]
+                                      : overflow_[index - kInlineEntries];
+    }
+    const Entry &entry(size_t index) const {
+        return index < kInlineEntries ? inline_[index]
+                                      : overflow_[index - kInlineEntries];
+    }
+
+    std::pair<std::string_view, std::string_view> field(size_t index) const;
+    std::string_view name_of(const Entry &e) const;
+    std::string_view value_of(const Entry &e) const;
+
+    size_t find(Header id, std::string_view name) const;
+    void append(Header id, std::string_view name, std::string_view value);
+    void assign(Header id, std::string_view name, std::string_view value);
+    void remove(size_t index);
+    void reindex();
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    std::array<Entry, kInlineEntries> inline_;
+    std::pmr::vector<Entry> overflow_;
+    size_t size_ = 0;
+
+    // 常用头部 -> 条目下标 + 1，0 表示不存在
+    std::array<uint16_t, kKnownHeaderCount> known_{};
+
+    std::pmr::string bytes_;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HTTP_ERROR_H
+#define HTTP_ERROR_H
+
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+// 以错误响应结束请求时抛出，携带响应的状态码，如 HttpError(400)。
+// what() 默认是 "400 Bad Request" 形式的状态文本，给出 detail 时为
+// detail，只用于日志；响应正文总是状态文本
+class HttpError : public std::runtime_error {
+  public:
+    explicit HttpError(int status, const std::string &detail = {});
+
+    int status() const { return status_; }
+
+  private:
+    int status_;
+};
+
+// "404 Not Found"
+std::string status_text(int status);
+
+// 异常对应的响应状态码，HttpError 以外的异常都是 500
+int error_status(const std::exception &e);
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef HTTPSERVER_H
 #define HTTPSERVER_H
 
+#include "AccessLog.h"
 #include "Request.h"
 #include "Response.h"
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <spdlog/spdlog.h>
 
 namespace fs = std::filesystem;
@@ -13,12 +16,36 @@ namespace fs = std::filesystem;
 struct Config {
     int port = 8080;
     fs::path root_dir = "www";
+    fs::path upload_dir = "uploads"; // multipart 上传的文件保存在这里
     int thread_pool_size = 4;
     int max_connections = 100;
+    int keep_alive_timeout = 5; // 空闲连接保持的秒数
+    // 请求体的最大字节数，Content-Length 更大的请求在读取请求体之前
+    // 以 413 拒绝
+    size_t max_body_size = 64 << 20;
     bool enable_directory_listing = true;
     bool enable_logging = true;
+    // 访问日志文件，enable_logging 为 false 或路径为空时不记录
+    std::string access_log = "access.log";
+    size_t access_log_capacity = 8192; // 队列中最多等待写出的记录数
+    AccessLog::Overflow access_log_overflow = AccessLog::Overflow::Drop;
+    // Binary 时写定长二进制记录，用 access_log_tool 解码
+    AccessLog::Format access_log_format = AccessLog::Format::Text;
+    // Prometheus 指标的路径，只响应来自本机的 GET，不经过路由也不记入
+    // 访问日志；为空时关闭
+    std::string metrics_path = "/metrics";
+    // 从收到请求的第一个字节到响应发完超过这么多毫秒时，记录各阶段的
+    // 耗时；为 0 时不记录
+    int slow_request_ms = 1000;
 };
 
+// 解析 received 开头以空行结束的请求头部并填入 req，随头部收到的请求体
+// 前缀也交给 req；返回 received 中属于本请求的字节数，其后是下一个请求。
+// 请求体只按 Content-Length 划分：带 Transfer-Encoding 或多个取值不同的
+// Content-Length 时抛出 HttpError（501 或 400），超过 max_body_size 时为 413
+size_t parse_request(std::string_view received, Request &req,
+                     size_t max_body_size = SIZE_MAX);
+
 class HttpServer {
   public:
     explicit HttpServer(const Config &config = {});
@@ -31,7 +58,8 @@ class HttpServer {
     void run();
     void set_root_directory(const std::string &path);
 
-    using RequestHandler = std::function<void(Request, Response)>;
+    // 请求与响应归连接所有，在同一连接的各个请求之间复用
+    using RequestHandler = std::function<void(Request &, Response &)>;
     void set_request_handler(RequestHandler handler);
 
     using ErrorHandler = std::function<void(const Request& req, Response& res, const std::exception& e)>;
@@ -0,0 +1,28 @@
+#ifndef JSON_BINARY_H
+#define JSON_BINARY_H
+
+#include "JsonValue.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// JsonValue 的二进制编码：MessagePack 与 CBOR (RFC 8949)
+//
+// 解码只接受能表示为 JSON 的数据：映射的键必须是字符串，字符串和
+// 字节串都必须是合法的 UTF-8；超出 int64 的整数按浮点数处理。
+// MessagePack 的扩展类型不支持；CBOR 的标签被忽略，只保留内容，
+// undefined 视为 null。数据不完整或不合法时抛出 std::runtime_error。
+namespace json {
+
+// 请求体与响应体可以使用的格式
+enum class Format : uint8_t { Json, MsgPack, Cbor };
+
+JsonValue decode_msgpack(std::string_view data);
+void encode_msgpack(const JsonValue &value, std::string &out);
+
+JsonValue decode_cbor(std::string_view data);
+void encode_cbor(const JsonValue &value, std::string &out);
+
+} // namespace json
+
+#endif
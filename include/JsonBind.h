@@ -0,0 +1,354 @@
+#ifndef JSON_BIND_H
+#define JSON_BIND_H
+
+#include "JsonValue.h"
+#include "JsonWriter.h"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// JSON 与结构体之间的声明式绑定
+//
+//   struct Command {
+//       std::string host;
+//       std::vector<std::string> args;
+//       bool dry_run = false;
+//   };
+//   JSON_BIND(Command, host, args, dry_run)
+//
+//   Command cmd;
+//   std::string error;
+//   if (!json::from_json(text, cmd, &error)) { ... }
+//   std::string text = json::to_json(cmd);
+//
+// 解码直接沿结构索引写入字段，不构建 DOM；未知的键整体跳过，缺失的字段
+// 保留默认值。类型不匹配与未知键都通过返回值处理，不抛出异常。
+// 已经解码为 JsonValue 的数据（如 MessagePack 请求体）用 from_value 绑定。
+namespace json {
+
+// 沿结构索引读取的游标，所有读取失败时返回 false 并记录第一个错误
+class Reader {
+  public:
+    explicit Reader(std::string_view json);
+    // 释放超大输入留下的线程索引缓冲区
+    ~Reader();
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    bool ok() const { return error_.empty(); }
+    const std::string &error() const { return error_; }
+
+    // 下一个值的首字符，已到末尾时返回 '\0'
+    char peek() const;
+
+    bool read_null();
+    bool read(bool &out);
+    bool read(int64_t &out);
+    bool read(double &out);
+    bool read(std::string &out);
+
+    // first 由调用方持有，初始为 true；容器结束时返回 false
+    bool begin_object();
+    bool next_key(std::string_view &key, bool &first);
+    bool begin_array();
+    bool next_element(bool &first);
+
+    // 跳过一个值，与读取时一样校验其中的全部语法
+    bool skip_value();
+
+    // 确认整个输入已读完
+    bool finish();
+
+    // 类型不匹配，记录期望的类型和出错位置
+    bool fail(const char *expected);
+
+  private:
+    bool skip_value(size_t depth);
+    bool syntax_error(std::string_view what);
+
+    std::string_view json_;
+    const std::vector<uint32_t> *index_ = nullptr;
+    size_t pos_ = 0;
+    std::string scratch_;
+    std::string error_;
+};
+
+// 沿已有的 JsonValue 读取，接口与 Reader 相同
+class ValueReader {
+  public:
+    explicit ValueReader(const JsonValue &root) : current_(&root) {}
+
+    bool ok() const { return error_.empty(); }
+    const std::string &error() const { return error_; }
+
+    // 与 JSON 文本中该值的首字符对应，数字返回 '0'
+    char peek() const;
+
+    bool read_null();
+    bool read(bool &out);
+    bool read(int64_t &out);
+    bool read(double &out);
+    bool read(std::string &out);
+
+    bool begin_object();
+    bool next_key(std::string_view &key, bool &first);
+    bool begin_array();
+    bool next_element(bool &first);
+
+    bool skip_value();
+    bool finish() { return true; }
+
+    bool fail(const char *expected);
+
+  private:
+    struct Frame {
+        const JsonValue *container;
+        size_t index;
+        JsonValue::Object::const_iterator member;
+    };
+
+    // 下一个要读取的值，读取后为空
+    const JsonValue *current_;
+    std::vector<Frame> frames_;
+    std::string error_;
+};
+
+template <typename T, typename M> struct Field {
+    std::string_view name;
+    M T::*member;
+};
+
+template <typename T, typename M>
+constexpr Field<T, M> field(std::string_view name, M T::*member) {
+    return {name, member};
+}
+
+namespace detail {
+
+template <typename T, typename = void> struct has_fields : std::false_type {};
+
+template <typename T>
+struct has_fields<
+    T, std::void_t<decltype(json_fields(static_cast<const T *>(nullptr)))>>
+    : std::true_type {};
+
+} // namespace detail
+
+// 容器与结构体的重载相互递归，先声明再定义
+template <typename R, typename T>
+bool decode(R &r, std::optional<T> &value);
+template <typename R, typename T> bool decode(R &r, std::vector<T> &value);
+template <typename R, typename T>
+std::enable_if_t<detail::has_fields<T>::value, bool> decode(R &r, T &value);
+template <typename T>
+void encode(JsonWriter &w, const std::optional<T> &value);
+template <typename T> void encode(JsonWriter &w, const std::vector<T> &value);
+template <typename T>
+std::enable_if_t<detail::has_fields<T>::value> encode(JsonWriter &w,
+                                                      const T &value);
+
+// R 是 Reader 或 ValueReader
+template <typename R> bool decode(R &r, bool &value) { return r.read(value); }
+template <typename R> bool decode(R &r, int64_t &value) {
+    return r.read(value);
+}
+template <typename R> bool decode(R &r, double &value) {
+    return r.read(value);
+}
+template <typename R> bool decode(R &r, std::string &value) {
+    return r.read(value);
+}
+
+template <typename R> bool decode(R &r, int &value) {
+    int64_t wide = 0;
+    if (!r.read(wide)) {
+        return false;
+    }
+    if (wide < std::numeric_limits<int>::min() ||
+        wide > std::numeric_limits<int>::max()) {
+        return r.fail("32-bit integer");
+    }
+    value = static_cast<int>(wide);
+    return true;
+}
+
+template <typename R, typename T>
+bool decode(R &r, std::optional<T> &value) {
+    if (r.peek() == 'n') {
+        value.reset();
+        return r.read_null();
+    }
+    return decode(r, value.emplace());
+}
+
+template <typename R, typename T> bool decode(R &r, std::vector<T> &value) {
+    if (!r.begin_array()) {
+        return false;
+    }
+    value.clear();
+    bool first = true;
+    while (r.next_element(first)) {
+        if (!decode(r, value.emplace_back())) {
+            return false;
+        }
+    }
+    return r.ok();
+}
+
+template <typename R, typename T>
+std::enable_if_t<detail::has_fields<T>::value, bool> decode(R &r, T &value) {
+    if (!r.begin_object()) {
+        return false;
+    }
+
+    const auto fields = json_fields(static_cast<const T *>(nullptr));
+    std::string_view key;
+    bool first = true;
+    while (r.next_key(key, first)) {
+        bool matched = false;
+        bool ok = true;
+        std::apply(
+            [&](const auto &...f) {
+                ((!matched && key == f.name
+                      ? (matched = true, ok = decode(r, value.*(f.member)))
+                      : false),
+                 ...);
+            },
+            fields);
+        if (!matched) {
+            ok = r.skip_value();
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return r.ok();
+}
+
+inline void encode(JsonWriter &w, bool value) { w.value(value); }
+inline void encode(JsonWriter &w, int value) { w.value(value); }
+inline void encode(JsonWriter &w, int64_t value) { w.value(value); }
+inline void encode(JsonWriter &w, double value) { w.value(value); }
+inline void encode(JsonWriter &w, const std::string &value) {
+    w.value(std::string_view(value));
+}
+
+template <typename T>
+void encode(JsonWriter &w, const std::optional<T> &value) {
+    if (value) {
+        encode(w, *value);
+    } else {
+        w.null();
+    }
+}
+
+template <typename T> void encode(JsonWriter &w, const std::vector<T> &value) {
+    w.begin_array();
+    for (const T &element : value) {
+        encode(w, element);
+    }
+    w.end_array();
+}
+
+template <typename T>
+std::enable_if_t<detail::has_fields<T>::value> encode(JsonWriter &w,
+                                                      const T &value) {
+    w.begin_object();
+    std::apply(
+        [&](const auto &...f) {
+            ((w.key(f.name), encode(w, value.*(f.member))), ...);
+        },
+        json_fields(static_cast<const T *>(nullptr)));
+    w.end_object();
+}
+
+// 失败时 out 可能只写入了一部分字段
+template <typename T>
+bool from_json(std::string_view json, T &out, std::string *error = nullptr) {
+    Reader r(json);
+    bool ok = r.ok() && decode(r, out) && r.finish();
+    if (!ok && error) {
+        *error = r.error();
+    }
+    return ok;
+}
+
+template <typename T>
+bool from_value(const JsonValue &value, T &out, std::string *error = nullptr) {
+    ValueReader r(value);
+    bool ok = decode(r, out) && r.finish();
+    if (!ok && error) {
+        *error = r.error();
+    }
+    return ok;
+}
+
+template <typename T> std::string to_json(const T &value, bool pretty = false) {
+    std::string out;
+    JsonWriter w(out, pretty);
+    encode(w, value);
+    return out;
+}
+
+} // namespace json
+
+// 为结构体生成字段描述，需与结构体位于同一命名空间，最多 16 个字段
+#define JSON_BIND(Type, ...)                                                   \
+    [[maybe_unused]] inline auto json_fields(const Type *) {                   \
+        return std::make_tuple(                                                \
+            JSON_BIND_FOR_EACH(JSON_BIND_FIELD, Type, __VA_ARGS__));           \
+    }
+
+#define JSON_BIND_FIELD(Type, name) ::json::field(#name, &Type::name)
+
+#define JSON_BIND_COUNT(...)                                                   \
+    JSON_BIND_COUNT_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5,  \
+                     4, 3, 2, 1)
+#define JSON_BIND_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12,    \
+                         _13, _14, _15, _16, N, ...)                           \
+    N
+#define JSON_BIND_CAT(a, b) JSON_BIND_CAT_(a, b)
+#define JSON_BIND_CAT_(a, b) a##b
+#define JSON_BIND_FOR_EACH(M, T, ...)                                          \
+    JSON_BIND_CAT(JSON_BIND_EACH_, JSON_BIND_COUNT(__VA_ARGS__))(M, T,         \
+                                                                 __VA_ARGS__)
+
+#define JSON_BIND_EACH_1(M, T, a) M(T, a)
+#define JSON_BIND_EACH_2(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_1(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_3(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_2(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_4(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_3(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_5(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_4(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_6(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_5(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_7(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_6(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_8(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_7(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_9(M, T, a, ...)                                         \
+    M(T, a), JSON_BIND_EACH_8(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_10(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_9(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_11(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_10(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_12(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_11(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_13(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_12(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_14(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_13(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_15(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_14(M, T, __VA_ARGS__)
+#define JSON_BIND_EACH_16(M, T, a, ...)                                        \
+    M(T, a), JSON_BIND_EACH_15(M, T, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef JSON_DOCUMENT_H
+#define JSON_DOCUMENT_H
+
+#include "Arena.h"
+#include "JsonValue.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+struct JsonMember;
+
+// 基于 Arena 的只读 JSON 节点
+// 数组元素和对象成员都是 arena 中连续存放的平坦数组，
+// 字符串是指向输入或 arena 的视图，节点本身平凡析构。
+class JsonNode {
+  public:
+    enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+
+    JsonNode() : type_(Type::Null), integral_(false), size_(0), number_(0) {}
+
+    Type type() const { return type_; }
+
+    bool is_null() const { return type_ == Type::Null; }
+    bool is_bool() const { return type_ == Type::Bool; }
+    // 整数也是数字；is_integer() 表示可以无损地取得 int64
+    bool is_number() const { return type_ == Type::Number; }
+    bool is_integer() const { return type_ == Type::Number && integral_; }
+    bool is_string() const { return type_ == Type::String; }
+    bool is_array() const { return type_ == Type::Array; }
+    bool is_object() const { return type_ == Type::Object; }
+
+    // 类型不匹配时抛出 std::runtime_error
+    bool as_bool() const;
+    double as_number() const;
+    int64_t as_integer() const;
+    std::string_view as_string() const;
+
+    // 数组元素个数或对象成员个数
+    size_t size() const { return size_; }
+
+    const JsonNode *begin() const;
+    const JsonNode *end() const;
+    const JsonNode &operator[](size_t index) const;
+
+    const JsonMember *members_begin() const;
+    const JsonMember *members_end() const;
+
+    // 对象成员线性查找，不存在时返回 nullptr
+    const JsonNode *find(std::string_view key) const;
+    const JsonNode &at(std::string_view key) const;
+
+    // 转换为独立的 JsonValue，脱离文档的生命周期
+    JsonValue to_value() const;
+
+  private:
+    friend class JsonDocumentParser;
+
+    Type type_;
+    bool integral_; // Number 时区分 integer_ 与 number_
+    uint32_t size_;
+    union {
+        bool boolean_;
+        int64_t integer_;
+        double number_;
+        const char *string_;
+        const JsonNode *elements_;
+        const JsonMember *members_;
+    };
+};
+
+struct JsonMember {
+    std::string_view key;
+    JsonNode value;
+};
+
+// 一个 JSON 文档及其独占的 Arena
+// 无转义的字符串直接引用输入，因此输入必须比文档活得更久。
+class JsonDocument {
+  public:
+    JsonDocument() = default;
+
+    static JsonDocument parse(std::string_view json);
+
+    const JsonNode &root() const { return root_; }
+
+    const Arena &arena() const { return arena_; }
+
+  private:
+    explicit JsonDocument(size_t input_size);
+
+    Arena arena_;
+    JsonNode root_;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef JSON_LAZY_H
+#define JSON_LAZY_H
+
+#include "JsonValue.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class JsonLazyDocument;
+
+// 按需访问的 JSON 值：只是文档中的一个索引位置，
+// 访问时才解码字符串和数字，跳过子树只需查一次配对表
+class JsonLazyValue {
+  public:
+    enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+
+    Type type() const;
+
+    bool is_null() const { return type() == Type::Null; }
+    bool is_bool() const { return type() == Type::Bool; }
+    bool is_number() const { return type() == Type::Number; }
+    bool is_string() const { return type() == Type::String; }
+    bool is_array() const { return type() == Type::Array; }
+    bool is_object() const { return type() == Type::Object; }
+
+    // 类型不匹配时抛出 std::runtime_error
+    bool as_bool() const;
+    double as_number() const;
+    int64_t as_integer() const;
+    std::string as_string() const;
+
+    // 数组元素个数或对象成员个数，需要遍历一层
+    size_t size() const;
+
+    // 数组下标或对象成员查找，不存在时返回 std::nullopt
+    std::optional<JsonLazyValue> find(size_t index) const;
+    std::optional<JsonLazyValue> find(std::string_view key) const;
+    JsonLazyValue at(size_t index) const;
+    JsonLazyValue at(std::string_view key) const;
+
+    // RFC 6901 JSON Pointer，相对于当前值，如 "/targets/3/ip"。
+    // 路径不存在时返回 std::nullopt；指针本身格式错误（不以 '/' 开头，
+    // 或 '~' 后不是 0 或 1）时无论路径是否存在都抛出 std::runtime_error
+    std::optional<JsonLazyValue> find_pointer(std::string_view pointer) const;
+    JsonLazyValue at_pointer(std::string_view pointer) const;
+
+    // 该值在输入中的原始文本
+    std::string_view raw_json() const;
+
+    // 物化为独立的 JsonValue
+    JsonValue to_value() const;
+
+  private:
+    friend class JsonLazyDocument;
+
+    JsonLazyValue(const JsonLazyDocument *doc, uint32_t at)
+        : doc_(doc), at_(at) {}
+
+    char first_char() const;
+    // 同一层中下一个结构位置（跳过整个子树）
+    uint32_t skip() const;
+    std::string_view raw_string(bool &has_escape) const;
+
+    const JsonLazyDocument *doc_;
+    uint32_t at_; // 在结构索引中的下标
+};
+
+// 校验一次并保存结构索引，之后按需访问
+// 文档引用输入，输入必须比文档活得更久；值对象引用文档。
+class JsonLazyDocument {
+  public:
+    JsonLazyDocument() = default;
+
+    // 语法错误时抛出 std::runtime_error，错误信息与 JsonValue::parse 相同
+    static JsonLazyDocument parse(std::string_view json);
+
+    JsonLazyValue root() const { return JsonLazyValue(this, 0); }
+
+    std::optional<JsonLazyValue> find_pointer(std::string_view pointer) const {
+        return root().find_pointer(pointer);
+    }
+    JsonLazyValue at_pointer(std::string_view pointer) const {
+        return root().at_pointer(pointer);
+    }
+
+  private:
+    friend class JsonLazyValue;
+    friend class JsonLazyValidator;
+
+    std::string_view json_;
+    std::vector<uint32_t> index_;
+    // 容器起始位置对应的结束位置下标，其他位置不使用
+    std::vector<uint32_t> close_;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include "JsonValue.h"
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 流式解析出错时抛出，便于和事件回调中抛出的异常区分
+class JsonParseError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// SAX 事件接口，字符串视图只在回调期间有效
+class JsonHandler {
+  public:
+    virtual ~JsonHandler() = default;
+
+    virtual void on_null() {}
+    virtual void on_bool(bool) {}
+    virtual void on_number(double) {}
+    // 没有小数和指数部分且在 int64 范围内的数字，默认按浮点数处理
+    virtual void on_integer(int64_t n) { on_number(static_cast<double>(n)); }
+    virtual void on_string(std::string_view) {}
+    virtual void on_key(std::string_view) {}
+    virtual void on_begin_object() {}
+    virtual void on_end_object() {}
+    virtual void on_begin_array() {}
+    virtual void on_end_array() {}
+};
+
+// 可恢复的流式 JSON 解析器
+//
+// 输入可以任意切分后多次 feed()，跨段的 token 暂存在内部缓冲区中，
+// 其余情况直接引用输入。内存占用只与嵌套深度和单个 token 的长度有关，
+// 与文档大小无关；暂存的 token 超过 max_token 字节时抛出 JsonParseError。
+// 语法与 JsonValue::parse 相同。
+class JsonStreamParser {
+  public:
+    explicit JsonStreamParser(JsonHandler &handler,
+                              size_t max_token = 1 << 20)
+        : handler_(handler), max_token_(max_token) {}
+
+    void feed(std::string_view chunk);
+
+    // 输入结束，文档不完整时抛出 JsonParseError
+    void finish();
+
+    // 顶层值已经完整解析
+    bool done() const { return state_ == State::Done; }
+
+    void reset();
+
+  private:
+    enum class State : uint8_t {
+        Value,
+        FirstValueOrEnd,
+        FirstKeyOrEnd,
+        Key,
+        Colon,
+        CommaOrEnd,
+        Done
+    };
+    enum class Token : uint8_t { None, String, Number, Literal };
+
+    size_t begin_value(std::string_view chunk, size_t i);
+    size_t continue_string(std::string_view chunk, size_t i);
+    size_t continue_scalar(std::string_view chunk, size_t i);
+    void buffer(std::string_view piece);
+    void finish_string(std::string_view raw);
+    void finish_scalar(std::string_view token);
+    void open_container(char c);
+    void close_container();
+    void after_value();
+
+    JsonHandler &handler_;
+    size_t max_token_;
+    State state_ = State::Value;
+    Token token_ = Token::None;
+    bool is_key_ = false;
+    bool escape_pending_ = false;
+    bool has_escape_ = false;
+
+    // 当前嵌套的容器，'{' 或 '['
+    std::vector<char> stack_;
+    // 跨段 token 的已接收部分，以及转义解码的输出
+    std::string partial_;
+    std::string decoded_;
+};
+
+// 顶层是数组时逐个构建并交出其元素，否则把顶层值作为唯一元素交出。
+// 同一时刻只持有一个元素，适合逐条处理大批量记录。
+class JsonElementReader : public JsonHandler {
+  public:
+    using Callback = std::function<void(const JsonValue &)>;
+
+    explicit JsonElementReader(Callback callback)
+        : callback_(std::move(callback)) {}
+
+    void on_null() override { add(JsonValue()); }
+    void on_bool(bool b) override { add(JsonValue(b)); }
+    void on_number(double n) override { add(JsonValue(n)); }
+    void on_integer(int64_t n) override { add(JsonValue(n)); }
+    void on_string(std::string_view s) override {
+        add(JsonValue(std::string(s)));
+    }
+    void on_key(std::string_view key) override { frames_.back().key = key; }
+    void on_begin_object() override;
+    void on_end_object() override;
+    void on_begin_array() override;
+    void on_end_array() override;
+
+    // 已交出的元素个数
+    size_t count() const { return count_; }
+
+  private:
+    struct Frame {
+        bool is_object;
+        JsonValue::Array array;
+        JsonValue::Object object;
+        std::string key;
+    };
+
+    void add(JsonValue &&value);
+
+    Callback callback_;
+    std::vector<Frame> frames_;
+    bool top_level_array_ = false;
+    size_t count_ = 0;
+};
+
+// 顶层是数组时逐个交出元素的原始 JSON 文本，否则把整个输入作为唯一元素
+// 交出，适合配合 json::from_json 逐条绑定到结构体。
+// 只跟踪字符串和括号来确定元素边界，元素内部的语法由使用方校验；
+// 元素完整落在一段输入内时直接引用输入，否则暂存在内部缓冲区中，
+// 暂存的元素超过 max_element 字节时抛出 JsonParseError。
+class JsonElementSplitter {
+  public:
+    using Callback = std::function<void(std::string_view)>;
+
+    explicit JsonElementSplitter(Callback callback,
+                                 size_t max_element = 1 << 20)
+        : callback_(std::move(callback)), max_element_(max_element) {}
+
+    void feed(std::string_view chunk);
+
+    // 输入结束，顶层数组不完整时抛出 JsonParseError
+    void finish();
+
+    // 已交出的元素个数
+    size_t count() const { return count_; }
+
+  private:
+    enum class State : uint8_t {
+        Start,
+        FirstElementOrEnd,
+        Element,
+        NextElement,
+        Done
+    };
+
+    void buffer(std::string_view piece);
+    void emit(std::string_view tail);
+
+    Callback callback_;
+    size_t max_element_;
+    State state_ = State::Start;
+    bool top_level_array_ = false;
+    bool in_string_ = false;
+    bool escape_ = false;
+    size_t depth_ = 0; // 当前元素内的括号深度
+    std::string partial_;
+    size_t count_ = 0;
+};
+
+// 按换行切分 NDJSON（JSON Lines）输入，逐行交出去掉行尾 '\r' 的文本和
+// 从 1 开始的行号；空白行跳过但计入行号。行内容不做校验。
+// 行完整落在一段输入内时直接引用输入，否则暂存在内部缓冲区中，
+// 单行超过 max_line 字节时抛出 JsonParseError，内存占用因此有上限。
+class JsonLineSplitter {
+  public:
+    using Callback = std::function<void(std::string_view, size_t)>;
+
+    explicit JsonLineSplitter(Callback callback, size_t max_line = 1 << 20)
+        : callback_(std::move(callback)), max_line_(max_line) {}
+
+    void feed(std::string_view chunk);
+
+    // 输入结束，最后一行可以没有换行符
+    void finish();
+
+    // 已交出的行数
+    size_t count() const { return count_; }
+
+  private:
+    void emit(std::string_view line);
+
+    Callback callback_;
+    size_t max_line_;
+    std::string partial_;
+    size_t line_ = 0;
+    size_t count_ = 0;
+};
+
+#endif
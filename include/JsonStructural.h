@@ -0,0 +1,36 @@
+#ifndef JSON_STRUCTURAL_H
+#define JSON_STRUCTURAL_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// 两阶段 JSON 解析的第一阶段：结构索引
+//
+// 以 64 字节为一块，用 SIMD 批量找出反斜杠、引号、空白和 {}[]:,
+// 计算出字符串内部区域后，输出字符串外的结构字符以及每个标量/字符串
+// 起始字符的位置。第二阶段只需沿着索引构建 DOM。
+namespace json {
+
+enum class SimdLevel { Scalar, SSE2, AVX2, NEON };
+
+// 当前 CPU 可用的最佳实现
+SimdLevel best_simd_level();
+
+const char *simd_level_name(SimdLevel level);
+
+// 成功时 positions 以 json.size() 作为哨兵结尾；
+// 字符串未闭合、UTF-8 编码无效或输入超过 4 GB 时抛出 std::runtime_error
+void build_structural_index(std::string_view json,
+                            std::vector<uint32_t> &positions);
+void build_structural_index(std::string_view json,
+                            std::vector<uint32_t> &positions,
+                            SimdLevel level);
+
+// 校验 UTF-8 编码，拒绝截断的序列、过长编码、代理项和超过 U+10FFFF 的码点
+bool validate_utf8(std::string_view data);
+bool validate_utf8(std::string_view data, SimdLevel level);
+
+} // namespace json
+
+#endif
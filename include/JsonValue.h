@@ -2,58 +2,144 @@
 #define JSON_VALUE_H
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <map>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
+// 16 字节的带标签值：标量和不超过 14 字节的字符串直接存放在值内，
+// 长字符串、数组和对象放在堆上，值内只保存指针。
+// 大量数字组成的数组因此只占每个元素 16 字节。
 class JsonValue {
   public:
     using Null = std::nullptr_t;
     using Bool = bool;
     using String = std::string;
     using Number = double;
+    using Integer = int64_t;
     using Array = std::vector<JsonValue>;
     using Object = std::map<std::string, JsonValue>;
 
-    using Value = std::variant<Null, Bool, String, Number, Array, Object>;
-
-    JsonValue() : value(nullptr) {}
-    JsonValue(Null) : value(nullptr) {}
-    JsonValue(Bool b) : value(b) {}
-    JsonValue(const String &s) : value(s) {}
-    JsonValue(const char *s) : value(std::string(s)) {}
-    JsonValue(Number n) : value(n) {}
-    JsonValue(int n) : value(static_cast<double>(n)) {}
-    JsonValue(const Array& a) : value(a) {}
-    JsonValue(const Object& o) : value(o) {}
-
-    bool is_null() const {return std::holds_alternative<Null>(value);}
-    bool is_bool() const { return std::holds_alternative<Bool>(value); }
-    bool is_number() const { return std::holds_alternative<Number>(value); }
-    bool is_string() const { return std::holds_alternative<String>(value); }
-    bool is_array() const { return std::holds_alternative<Array>(value); }
-    bool is_object() const { return std::holds_alternative<Object>(value); }
-
-    Bool as_bool() const {return std::get<Bool>(value);}
-    Number as_number() const { return std::get<Number>(value); }
-    const String& as_string() const { return std::get<String>(value); }
-    const Array& as_array() const { return std::get<Array>(value); }
-    const Object& as_object() const { return std::get<Object>(value); }
-
-    static JsonValue parse(const String& json);
+    JsonValue() { set_tag(Tag::Null); }
+    JsonValue(Null) { set_tag(Tag::Null); }
+    JsonValue(Bool b) { set(Tag::Bool, b); }
+    JsonValue(const String &s) { init_string(s); }
+    JsonValue(std::string_view s) { init_string(s); }
+    JsonValue(const char *s) { init_string(s); }
+    JsonValue(Number n) { set(Tag::Number, n); }
+    JsonValue(int n) { set(Tag::Integer, static_cast<Integer>(n)); }
+    JsonValue(Integer n) { set(Tag::Integer, n); }
+    JsonValue(const Array &a);
+    JsonValue(Array &&a);
+    JsonValue(const Object &o);
+    JsonValue(Object &&o);
+
+    JsonValue(const JsonValue &other);
+    JsonValue(JsonValue &&other) noexcept {
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        other.set_tag(Tag::Null);
+    }
+    JsonValue &operator=(const JsonValue &other);
+    JsonValue &operator=(JsonValue &&other) noexcept;
+    ~JsonValue() { release(); }
+
+    bool is_null() const { return tag() == Tag::Null; }
+    bool is_bool() const { return tag() == Tag::Bool; }
+    // 整数也是数字；is_integer() 表示可以无损地取得 int64
+    bool is_number() const {
+        return tag() == Tag::Number || tag() == Tag::Integer;
+    }
+    bool is_integer() const { return tag() == Tag::Integer; }
+    bool is_string() const {
+        return tag() == Tag::SmallString || tag() == Tag::String;
+    }
+    bool is_array() const { return tag() == Tag::Array; }
+    bool is_object() const { return tag() == Tag::Object; }
+
+    // 类型不匹配时抛出 std::bad_variant_access
+    Bool as_bool() const { return get<Bool>(Tag::Bool); }
+    Number as_number() const {
+        if (tag() == Tag::Integer) {
+            return static_cast<Number>(get<Integer>(Tag::Integer));
+        }
+        return get<Number>(Tag::Number);
+    }
+    Integer as_integer() const { return get<Integer>(Tag::Integer); }
+    // 视图在值被修改或销毁前有效
+    std::string_view as_string() const;
+    const Array &as_array() const { return *get<Array *>(Tag::Array); }
+    const Object &as_object() const { return *get<Object *>(Tag::Object); }
+
+    Array &as_array() { return *get<Array *>(Tag::Array); }
+    Object &as_object() { return *get<Object *>(Tag::Object); }
+
+    // 在数组末尾原地构造元素，当前值必须是数组
+    template <typename... Args> JsonValue &emplace_back(Args &&...args) {
+        return as_array().emplace_back(std::forward<Args>(args)...);
+    }
+
+    // 在对象中原地构造成员，键已存在时覆盖；当前值必须是对象
+    template <typename... Args>
+    JsonValue &emplace(std::string key, Args &&...args) {
+        auto [it, inserted] = as_object().try_emplace(
+            std::move(key), std::forward<Args>(args)...);
+        if (!inserted) {
+            it->second = JsonValue(std::forward<Args>(args)...);
+        }
+        return it->second;
+    }
+
+    // 两阶段解析：先用 SIMD 建立结构索引，再沿索引构建 DOM
+    static JsonValue parse(std::string_view json);
+
+    // 序列化为 JSON 文本，pretty 时缩进两个空格
+    std::string dump(bool pretty = false) const;
 
   private:
-    Value value;
-
-    static JsonValue parse_value(const String& json, size_t& index);
-    static void skip_whitespace(const String& json, size_t& index);
-    static JsonValue parse_null(const std::string& json, size_t& index);
-    static JsonValue parse_bool(const std::string& json, size_t& index);
-    static JsonValue parse_number(const std::string& json, size_t& index);
-    static JsonValue parse_string(const std::string& json, size_t& index);
-    static JsonValue parse_array(const std::string& json, size_t& index);
-    static JsonValue parse_object(const std::string& json, size_t& index);
+    enum class Tag : uint8_t {
+        Null,
+        Bool,
+        Number,
+        Integer,
+        SmallString,
+        String,
+        Array,
+        Object
+    };
+
+    // bytes_[0..8) 存放标量或指针，短字符串占 bytes_[0..14)，
+    // bytes_[14] 是短字符串长度，bytes_[15] 是标签
+    static constexpr size_t kSmallCapacity = 14;
+    static constexpr size_t kSmallSizeByte = 14;
+    static constexpr size_t kTagByte = 15;
+
+    Tag tag() const { return static_cast<Tag>(bytes_[kTagByte]); }
+    void set_tag(Tag t) { bytes_[kTagByte] = static_cast<unsigned char>(t); }
+
+    template <typename T> void set(Tag t, T payload) {
+        std::memcpy(bytes_, &payload, sizeof(T));
+        set_tag(t);
+    }
+
+    template <typename T> T get(Tag expected) const {
+        if (tag() != expected) {
+            throw std::bad_variant_access();
+        }
+        T payload;
+        std::memcpy(&payload, bytes_, sizeof(T));
+        return payload;
+    }
+
+    void init_string(std::string_view s);
+    void release() noexcept;
+
+    alignas(8) unsigned char bytes_[16];
 };
 
-#endif
\ No newline at end of file
+static_assert(sizeof(JsonValue) == 16, "JsonValue should stay 16 bytes");
+
+#endif
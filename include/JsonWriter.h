@@ -0,0 +1,67 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class JsonValue;
+class JsonNode;
+
+// JSON 序列化器
+// 可以直接写入一个 std::string，也可以在缓冲区满时把数据交给 sink，
+// 这样大型响应可以边生成边发送，不必在内存中拼成一个完整字符串。
+class JsonWriter {
+  public:
+    using Sink = std::function<void(std::string_view)>;
+
+    explicit JsonWriter(std::string &out, bool pretty = false);
+    explicit JsonWriter(Sink sink, bool pretty = false,
+                        size_t buffer_size = 16 * 1024);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter &operator=(const JsonWriter &) = delete;
+
+    JsonWriter &begin_object();
+    JsonWriter &end_object();
+    JsonWriter &begin_array();
+    JsonWriter &end_array();
+    JsonWriter &key(std::string_view name);
+
+    JsonWriter &null();
+    JsonWriter &value(bool b);
+    JsonWriter &value(double d);
+    JsonWriter &value(int64_t n);
+    JsonWriter &value(int n) { return value(static_cast<int64_t>(n)); }
+    JsonWriter &value(std::string_view s);
+    JsonWriter &value(const char *s) { return value(std::string_view(s)); }
+
+    JsonWriter &write(const JsonValue &v);
+    JsonWriter &write(const JsonNode &node);
+
+    // 把缓冲区中的内容交给 sink（写入字符串模式下无操作）
+    void flush();
+
+  private:
+    void before_value();
+    void newline();
+    void raw(std::string_view s);
+    void maybe_flush();
+    void write_escaped(std::string_view s);
+
+    std::string own_buffer_;
+    std::string &out_;
+    Sink sink_;
+    size_t flush_threshold_ = 0;
+    bool pretty_;
+
+    // 每层容器是否还没有写入任何元素
+    std::vector<bool> first_;
+    bool after_key_ = false;
+};
+
+#endif
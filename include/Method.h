@@ -0,0 +1,42 @@
+#ifndef METHOD_H
+#define METHOD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 请求方法，解析一次后以枚举值参与路由分派
+// Extension 为未知的扩展方法预留，原始方法名保存在 Request::extension_method
+enum class Method : uint8_t {
+    Get,
+    Head,
+    Post,
+    Put,
+    Delete,
+    Connect,
+    Options,
+    Trace,
+    Patch,
+    Extension,
+};
+
+constexpr size_t kMethodCount = static_cast<size_t>(Method::Extension) + 1;
+
+// 方法集合位掩码，用于生成 Allow 头
+using MethodMask = uint16_t;
+
+constexpr MethodMask method_bit(Method m) {
+    return static_cast<MethodMask>(1u << static_cast<unsigned>(m));
+}
+
+constexpr size_t method_index(Method m) { return static_cast<size_t>(m); }
+
+Method parse_method(std::string_view token);
+
+std::string_view method_name(Method m);
+
+// 按枚举顺序拼接 "GET, HEAD, ..."，不包含 Extension
+std::string allow_header_value(MethodMask mask);
+
+#endif
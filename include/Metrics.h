@@ -0,0 +1,80 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "Trace.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 按路由与状态码统计的请求计数和延迟直方图，以及各处理阶段的耗时
+// 直方图，以 Prometheus 文本格式导出
+//
+// 每个连接线程借用一个按缓存行对齐的槽位，只有它写入，计数用普通的
+// 读-加-写更新，不加锁也没有原子读改写指令；导出时合并所有槽位。
+// 线程结束时槽位连同计数归还，由之后的线程继续累加。
+class Metrics {
+    struct Slot;
+
+  public:
+    // HDR 风格的对数-线性分桶：每个 2 的幂区间再分 4 个子桶，
+    // 相对误差不超过 25%，有限的桶覆盖 0 到约 67 秒（微秒）。
+    // 更大的值记入下标为 kBuckets 的溢出桶，导出时只计入 +Inf
+    static constexpr unsigned kSubBucketBits = 2;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBuckets = 100;
+    // 每个槽位最多区分的路由数，更多的路由只计入状态码
+    static constexpr size_t kMaxRoutes = 32;
+    static constexpr size_t kMaxStatus = 600;
+
+    // 0 到 kBuckets，kBuckets 为溢出桶
+    static size_t bucket_index(uint64_t latency_us);
+    // 有限桶内最大的值（含）
+    static uint64_t bucket_upper_bound(size_t index);
+
+    // 连接线程持有，析构时归还槽位
+    class Recorder {
+      public:
+        explicit Recorder(Metrics &metrics);
+        ~Recorder();
+
+        Recorder(const Recorder &) = delete;
+        Recorder &operator=(const Recorder &) = delete;
+
+        // route 为匹配的路由模式，需要在 Metrics 存续期间有效，
+        // 空串表示没有匹配的路由
+        void record(std::string_view route, int status, uint64_t latency_us);
+
+        // 一个请求各阶段的微秒数，下标为 trace::Phase
+        void record_phases(
+            const std::array<uint64_t, trace::kPhaseCount> &phases_us);
+
+      private:
+        Metrics &metrics_;
+        Slot *slot_;
+    };
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    // 合并所有槽位，输出 Prometheus 文本格式 (version 0.0.4)
+    std::string scrape() const;
+
+  private:
+    Slot *acquire();
+    void release(Slot *slot);
+
+    mutable std::mutex mutex_; // 只保护槽位的分配与遍历
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::vector<Slot *> free_;
+};
+
+#endif
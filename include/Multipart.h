@@ -0,0 +1,136 @@
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// multipart/form-data 请求体 (RFC 7578) 的流式解析
+
+// 请求体格式错误时抛出，便于和事件回调中抛出的异常区分
+class MultipartParseError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// 一个部分的头部，只保留表单用到的字段
+struct MultipartPart {
+    std::string name;     // Content-Disposition 的 name
+    std::string filename; // Content-Disposition 的 filename
+    std::string content_type;
+    bool is_file = false; // 带有 filename 参数，可能为空串
+};
+
+// 部分的事件接口，数据视图只在回调期间有效
+class MultipartHandler {
+  public:
+    virtual ~MultipartHandler() = default;
+    virtual void on_part_begin(const MultipartPart &part) = 0;
+    virtual void on_part_data(std::string_view data) = 0;
+    virtual void on_part_end() = 0;
+};
+
+// 可恢复的流式 multipart 解析器
+//
+// 输入可以任意切分后多次 feed()。分隔符 "\r\n--boundary" 用
+// Boyer-Moore-Horspool 查找，部分的数据直接引用输入交给 handler，
+// 只有可能是分隔符开头的段尾几个字节暂存到下一段；部分头部暂存在
+// 内部缓冲区中，超过 max_header 字节时抛出 MultipartParseError。
+// 内存占用与请求体大小无关。
+class MultipartParser {
+  public:
+    MultipartParser(std::string_view boundary, MultipartHandler &handler,
+                    size_t max_header = 16 * 1024);
+
+    void feed(std::string_view chunk);
+
+    // 输入结束，没有遇到结束分隔符时抛出 MultipartParseError
+    void finish();
+
+    // 已开始的部分数
+    size_t count() const { return count_; }
+
+  private:
+    enum class State : uint8_t {
+        Preamble,   // 第一个分隔符之前，内容丢弃
+        Delimiter,  // 分隔符之后，等待 "--" 或行尾
+        CloseDash,  // 已读到结束分隔符的第一个 '-'
+        LineFeed,   // 分隔符行的 '\r' 之后
+        Headers,    // 部分的头部
+        Body,       // 部分的数据
+        Epilogue,   // 结束分隔符之后，内容丢弃
+    };
+
+    std::string_view feed_data(std::string_view chunk);
+    std::string_view feed_headers(std::string_view chunk);
+    void emit(std::string_view data);
+    void on_delimiter();
+    void parse_headers(std::string_view block);
+    size_t find_delimiter(std::string_view data) const;
+    size_t partial_delimiter(std::string_view data) const;
+
+    MultipartHandler &handler_;
+    size_t max_header_;
+    std::string delimiter_; // "\r\n--" + boundary
+    std::array<uint8_t, 256> skip_{};
+    State state_ = State::Preamble;
+    std::string carry_;   // 段尾可能是分隔符开头的字节
+    std::string scratch_; // carry_ 与下一段开头拼接后查找
+    std::string header_;
+    MultipartPart part_;
+    size_t count_ = 0;
+};
+
+// 把文件部分直接写入 directory 下新建的文件，数据不在内存中累积；
+// 其余字段保存在 fields 中，单个字段超过 max_field 字节、字段总数
+// 超过 max_fields 时抛出 MultipartParseError。
+// 文件名由服务器生成，客户端提供的 filename 只作记录。
+// 析构时删除未写完的文件，已完成的文件由调用方处理。
+class MultipartFileSaver : public MultipartHandler {
+  public:
+    struct SavedFile {
+        std::string name;
+        std::string filename;
+        std::string content_type;
+        std::filesystem::path path;
+        uint64_t size = 0;
+    };
+
+    explicit MultipartFileSaver(std::filesystem::path directory,
+                                size_t max_field = 64 * 1024,
+                                size_t max_fields = 256);
+    ~MultipartFileSaver() override;
+
+    MultipartFileSaver(const MultipartFileSaver &) = delete;
+    MultipartFileSaver &operator=(const MultipartFileSaver &) = delete;
+
+    void on_part_begin(const MultipartPart &part) override;
+    void on_part_data(std::string_view data) override;
+    void on_part_end() override;
+
+    const std::vector<SavedFile> &files() const { return files_; }
+    // 同名字段保留第一个
+    const std::map<std::string, std::string> &fields() const {
+        return fields_;
+    }
+
+  private:
+    void close_file();
+
+    std::filesystem::path directory_;
+    size_t max_field_;
+    size_t max_fields_;
+    std::vector<SavedFile> files_;
+    std::map<std::string, std::string> fields_;
+    size_t field_count_ = 0;
+    std::string field_name_;
+    std::string field_value_;
+    int fd_ = -1; // 正在写入的文件，对应 files_.back()
+};
+
+#endif
@@ -3,43 +3,188 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <unordered_map>
 #include <spdlog/spdlog.h>
+#include <utility>
 #include <vector>
 
+#include "HeaderMap.h"
+#include "JsonLazy.h"
 #include "JsonValue.h"
+#include "Method.h"
+#include "Trace.h"
+#include "Url.h"
 
 namespace fs = std::filesystem;
 
+class JsonHandler;
+class MultipartHandler;
+
+namespace json {
+enum class Format : uint8_t;
+}
+
+class RequestArena;
+
 // 请求类
+// 由连接持有，按引用交给处理器。路径、头部、路由参数、请求体和解析后的
+// 表单都从请求自己的单调 arena 分配，arena 以进程内复用的内存块为初始
+// 缓冲区，reset() 时整体回收；只访问这些内容的请求在稳定状态下不调用
+// 全局 new。json()/json_lazy() 的解析结果以及 query_params() 等返回
+// 值不在 arena 中，仍使用全局堆。
 class Request {
+    // 必须最先构造：下面的请求级容器都从它分配
+    std::unique_ptr<RequestArena> arena_;
+
 public:
-    Request(int fd) : client_fd_(fd) {}
-    Request() = default;
+    Request(int fd);
+    Request();
+    ~Request();
+
+    // 容器引用 arena_，移动构造后 arena 随之转移；移动赋值会让已有
+    // 容器指向被销毁的 arena，因此不提供
+    Request(Request&&);
+    Request& operator=(Request&&) = delete;
+    Request(const Request&) = delete;
+    Request& operator=(const Request&) = delete;
+
+    // 结束上一个请求：清空内容并一次性回收 arena，
+    // 之前取得的视图和引用全部失效
+    void reset();
+
+    // 请求级 arena，Response 的头部也从这里分配
+    std::pmr::memory_resource* resource() const;
+
+    Method method = Method::Extension;
+    std::pmr::string extension_method{resource()}; // 仅 Extension 时有效
+    std::pmr::string path{resource()};         // 请求目标中 '?' 之前的部分
+    std::pmr::string query_string{resource()}; // '?' 之后的部分，未解码
+    std::pmr::string version{resource()};
+    HeaderMap headers{resource()};
+    // 解码、规范化后相对于根目录的路径，由 RequestHandler 在路由前填写
+    std::pmr::string relative_path{resource()};
+    // 路由参数的原始值，param_names 与之一一对应，名字指向路由表
+    std::pmr::vector<std::pmr::string> params{resource()};
+    std::pmr::vector<std::string_view> param_names{resource()};
+    // 匹配的路由模式，如 "/users/:id"，指向路由表；未匹配时为空
+    std::string_view route;
+    // 阶段计时，由 HttpServer 开始与结束，Router 标记路由阶段；
+    // reset() 不清空
+    trace::RequestTrace trace;
+
+    // 路径中的非空段，遍历时才切分，段未经解码
+    url::PathSegments path_segments() const {
+        return url::PathSegments(path);
+    }
+
+    // 查询参数的键值对视图，键和值都未解码
+    url::QueryParams query() const { return url::QueryParams(query_string); }
+
+    // 键值对从请求的 arena 分配，reset() 后失效
+    using Form =
+        std::pmr::vector<std::pair<std::pmr::string, std::pmr::string>>;
+
+    // 请求体按 Content-Type 在首次访问时解析并缓存，未访问时没有开销
+    // 类型不匹配时抛出 "415 Unsupported Media Type"，格式错误时抛出
+    // "400 Bad Request"；空请求体分别得到 null 和空表单。
+    // json() 也接受 MessagePack 与 CBOR 请求体，解码为同样的 JsonValue
+    const JsonValue& json() const;
+    const Form& form() const;
+
+    // 只校验并建立索引，字段在访问时才解码，适合只读取少数字段的场景，
+    // 如 req.json_lazy().at_pointer("/host")；错误处理与 json() 相同
+    const JsonLazyDocument& json_lazy() const;
 
-    std::string method;
-    std::string path;
-    std::string version;
-    std::unordered_map<std::string, std::string> headers;
-    std::vector<uint8_t> body;
-    std::string body_str;
-    fs::path full_path;
-    std::vector<std::string> splited_path;
-    std::vector<std::string> params;
+    // 请求体在首次访问时才从连接读取
+    const std::pmr::vector<uint8_t>& body() const;
+    std::string_view body_str() const;
 
-    JsonValue json_value;
+    // 边接收边处理请求体：每次返回下一段，读完后返回空视图，
+    // 返回的视图在下次调用前有效。与 body() 只能二选一。
+    std::string_view read_body_chunk();
 
+    // 边接收边解析 JSON 请求体，事件交给 handler，内存占用与请求体
+    // 大小无关；错误处理与 json() 相同，空请求体产生一个 null 事件
+    void stream_json(JsonHandler& handler);
+
+    // 请求体是数组时逐个交出元素的原始 JSON 文本，否则交出整个请求体，
+    // 可配合 json::from_json 逐条绑定到结构体；空请求体不产生元素
+    void stream_json_elements(
+        const std::function<void(std::string_view)>& callback);
+
+    // Content-Type 是 NDJSON（JSON Lines），如 application/x-ndjson
+    bool is_json_lines() const;
+
+    // 边接收边按行切分 NDJSON 请求体，逐行交出文本和行号，内存占用只与
+    // 最长的行有关；单行超过 max_line 字节时抛出 "400 Bad Request"，
+    // 类型不匹配时抛出 "415 Unsupported Media Type"
+    void stream_json_lines(
+        const std::function<void(std::string_view, size_t)>& callback,
+        size_t max_line = 1 << 20);
+
+    // 边接收边解析 multipart/form-data 请求体，各部分的头部和数据交给
+    // handler，如 MultipartFileSaver 把文件部分直接写入磁盘；格式错误或
+    // 缺少 boundary 时抛出 "400 Bad Request"，类型不匹配时抛出
+    // "415 Unsupported Media Type"
+    void stream_multipart(MultipartHandler& handler);
+
+    // 由 HttpServer 设置：随头部一起收到的请求体前缀与 Content-Length
+    void set_body_source(std::string_view received, size_t content_length);
+
+    // 处理器读取请求体时 recv 所用的计数，见 trace::now()
+    uint64_t body_read_ticks() const { return body_read_ticks_; }
+
+    // 按协议版本和 Connection 头部判断客户端是否希望保持连接
+    bool keep_alive() const;
+
+    // 由 HttpServer 在处理器返回后调用，读掉未被读取的请求体，
+    // 使连接可以继续接收下一个请求；失败或剩余太多时返回 false
+    bool discard_body();
+
+    // Content-Type 去掉参数后的部分，如 "application/json"
+    std::string_view media_type() const;
+
+    // 请求体的格式，Content-Type 不是 JSON、MessagePack 或 CBOR 时为空
+    std::optional<json::Format> body_format() const;
+
+    // 按 Accept 头部协商响应格式：取 q 值最高且明确列出的格式，
+    // 没有列出任何支持的格式（包括只有 */*）时为空，由调用方决定默认值
+    std::optional<json::Format> accepted_format() const;
+
+    // 解码后的查询参数，同名参数保留第一个
     std::unordered_map<std::string, std::string> query_params() const;
-    std::string get_path_param(const std::string& key) const;
+    // 解码后的路由参数，如 "/users/:id" 中的 id，"*" 取通配部分；
+    // 不存在时返回空字符串
+    std::string get_path_param(std::string_view key) const;
     std::string client_ip() const;
 
     bool isBodyLikelyString();
 
-    int client_fd_;
+    int client_fd_ = -1;
 
     void info();
 
+private:
+    std::string_view next_body_chunk() const;
+    template <typename Parser>
+    void stream_body(Parser& parser, bool accepted);
+
+    mutable std::pmr::vector<uint8_t> body_{resource()};
+    mutable std::pmr::string body_chunk_{resource()};
+    mutable size_t body_unread_ = 0;     // 尚未交给调用方的字节数
+    mutable bool body_prefix_ = false;   // body_chunk_ 中是未交出的前缀
+    mutable bool body_loaded_ = false;
+    mutable uint64_t body_read_ticks_ = 0; // 读取请求体的 recv 耗时
+    bool body_streamed_ = false;
+    mutable std::optional<JsonValue> json_;
+    mutable std::optional<JsonLazyDocument> json_lazy_;
+    mutable std::optional<Form> form_;
 };
 
 #endif
\ No newline at end of file
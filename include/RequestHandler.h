@@ -1,8 +1,10 @@
 #pragma once
 
+#include "AccessLog.h"
 #include "Request.h"
 #include "Response.h"
 #include "Router.h"
+#include "ThreadPool.h"
 #include <exception>
 #include <filesystem>
 
@@ -10,11 +12,16 @@ namespace fs = std::filesystem;
 
 class RequestHandler {
 public:
-    explicit RequestHandler(const fs::path root_path) : root_path_(root_path) {
+    // workers 是解析 NDJSON 批量上传的线程数，通常取 Config::thread_pool_size；
+    // upload_dir 保存 multipart 上传的文件，通常取 Config::upload_dir
+    explicit RequestHandler(const fs::path root_path, size_t workers = 4,
+                            fs::path upload_dir = "uploads")
+        : root_path_(root_path), upload_dir_(std::move(upload_dir)),
+          workers_(workers) {
         setup_routes();
     }
     
-    void handle_request(Request req, Response res) {
+    void handle_request(Request& req, Response& res) {
         try {
             process_request(req, res);
         } catch (const std::exception& e) {
@@ -22,15 +29,22 @@ public:
         }
     }
 
+    // 按异常发送错误响应，状态码见 error_status()；
+    // 也用作 HttpServer 的错误处理器，处理请求头部本身的错误
+    void handle_error(const Request& req, Response& res, const std::exception& e);
+
 private:
     
     void process_request(Request& req, Response& res);
-    void handle_error(const Request& req, Response& res, const std::exception& e);
     void handle_get(Request& req, Response& res);
     void handle_post(Request& req, Response& res);
+    void ingest_json_lines(Request& req, Response& res);
 
     fs::path root_path_;
+    fs::path upload_dir_;
 
     void setup_routes();
     Router router_;
+    ThreadPool workers_;
+    RateLimiter error_log_limit_{10}; // 每秒最多记录的错误数
 };
\ No newline at end of file
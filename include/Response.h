@@ -1,19 +1,54 @@
 #ifndef RESPONSE_H
 #define RESPONSE_H
 
+#include "HeaderMap.h"
+#include "JsonBinary.h"
+#include "Trace.h"
 #include <spdlog/spdlog.h>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <sys/uio.h>
 
 // 响应类
+// 由连接持有并在同一连接的各个请求之间复用；套接字也归连接所有，
+// 响应发送完毕后不关闭连接。头部从给定的内存资源分配，
+// 通常是 Request::resource()，需要在请求的 arena 回收前 reset()
 class Response {
   public:
-    Response(int client_fd);
+    Response(int client_fd, std::pmr::memory_resource *resource =
+                                std::pmr::get_default_resource());
     ~Response();
 
+    Response(Response &&) = default;
+    Response &operator=(Response &&) = default;
+    Response(const Response &) = delete;
+    Response &operator=(const Response &) = delete;
+
+    // 清空状态和头部，准备发送下一个响应
+    void reset();
+
+    // 发送后连接是否继续使用，为 false 时头部带 Connection: close；
+    // 由 HttpServer 在调用处理器前设置
+    Response &keep_alive(bool enable);
+
+    // 状态行与头部已经发出，之后不能再改变状态码
+    bool headers_sent() const { return headers_sent_; }
+
+    // 响应已经完整发出；写套接字失败（如对端已关闭）时为 false
+    bool complete() const { return ended_ && !failed_; }
+
+    // 访问日志使用：当前状态码与已写入套接字的字节数（含头部）
+    int status_code() const { return status_code_; }
+    uint64_t bytes_sent() const { return bytes_sent_; }
+    // 写套接字所用的计数，见 trace::now()
+    uint64_t write_ticks() const { return write_ticks_; }
+
     Response &status(int code);
 
-    Response &header(const std::string &key, const std::string &value);
+    Response &header(std::string_view key, std::string_view value);
+
+    // HEAD 请求：照常计算头部（包括 Content-Length），但不发送正文
+    Response &head_only(bool enable = true);
 
     Response &send_file(const std::string &file_path);
 
@@ -25,48 +60,38 @@ class Response {
     void send(const std::string &body_str);
     Response &end(const std::string &content = "");
 
+    // 分块传输：先发送带 Transfer-Encoding: chunked 的头部，
+    // 正文分多次写出，end_chunked() 发送结束块
+    Response &begin_chunked();
+    Response &write_chunk(std::string_view data);
+    Response &end_chunked();
+
+    // 序列化并发送 JSON；结果装得下写缓冲区时带 Content-Length 一次发送，
+    // 否则边序列化边以分块方式发送
+    Response &send_json(const JsonValue &value, bool pretty = false);
+
+    // 按协商出的格式发送同一个值：JSON 走 send_json，MessagePack 与
+    // CBOR 编码后一次发送；响应都带 Vary: Accept
+    Response &send_value(const JsonValue &value, json::Format format);
+
   private:
-    void send_headers();
+    // 状态行与头部写入 out；未显式设置 Content-Length 时使用 content_length
+    void write_head(std::string &out, size_t content_length);
+    Response &finish(std::string_view content);
+    void transmit(std::string_view data);
+    void transmit(iovec *parts, size_t count);
 
     int client_fd_;
     int status_code_ = 200;
-    std::unordered_map<std::string, std::string> headers_;
+    HeaderMap headers_;
     bool headers_sent_ = false;
-
-    std::string status_message() const {
-        switch (status_code_) {
-        case 200:
-            return "OK";
-        case 201:
-            return "Created";
-        case 204:
-            return "No Content";
-        case 301:
-            return "Moved Permanently";
-        case 302:
-            return "Found";
-        case 304:
-            return "Not Modified";
-        case 400:
-            return "Bad Request";
-        case 401:
-            return "Unauthorized";
-        case 403:
-            return "Forbidden";
-        case 404:
-            return "Not Found";
-        case 405:
-            return "Method Not Allowed";
-        case 500:
-            return "Internal Server Error";
-        case 501:
-            return "Not Implemented";
-        case 503:
-            return "Service Unavailable";
-        default:
-            return "Unknown Status";
-        }
-    }
+    bool head_only_ = false;
+    bool chunked_ = false;
+    bool ended_ = false;
+    bool keep_alive_ = false;
+    bool failed_ = false; // 写套接字出错，之后的写入全部放弃
+    uint64_t bytes_sent_ = 0;
+    uint64_t write_ticks_ = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
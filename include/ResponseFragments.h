@@ -0,0 +1,24 @@
+#ifndef RESPONSE_FRAGMENTS_H
+#define RESPONSE_FRAGMENTS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 预先序列化好的响应头片段，热路径上只做 memcpy
+
+// "HTTP/1.1 200 OK\r\n"，100-599 的每个状态码都有对应的行
+std::string_view status_line(int code);
+
+std::string_view reason_phrase(int code);
+
+// "Server: HttpServer/1.0\r\n"
+std::string_view server_header();
+
+// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"，每个线程每秒最多刷新一次
+std::string_view date_header();
+
+// 以十进制追加整数，不经过 ostringstream/to_string
+void append_decimal(std::string &out, size_t value);
+
+#endif
@@ -1,11 +1,14 @@
 #pragma once
 
+#include "Method.h"
 #include "Request.h"
 #include "Response.h"
+#include <array>
 #include <functional>
-#include <map>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 using Handler = std::function<void(Request&, Response&)>;
@@ -13,20 +16,46 @@ using Handler = std::function<void(Request&, Response&)>;
 class Router {
 public:
 
+    enum class Result {
+        Handled,
+        NotFound,         // 没有任何方法的路由匹配该路径
+        MethodNotAllowed, // 路径存在但方法不匹配，已设置 Allow 头
+    };
+
+    void add_route(Method method, const std::string& path, Handler handler);
+
+    // 注册扩展方法（如 PROPFIND），标准方法会被转换为对应的枚举值
     void add_route(const std::string& method, const std::string& path, Handler handler);
 
-    bool route(Request& req, Response& res);
+    Result route(Request& req, Response& res);
+
+    // 计算路径可用的方法，用于 405 / OPTIONS 的 Allow 头
+    std::string allowed_methods(std::string_view path) const;
 
     void add_middleware(Handler middleware);
 
 private:
 
     struct Route {
+        std::string pattern; // 注册时的路径，如 "/users/:id"
         std::regex path_pattern;
+        // 与捕获组一一对应，":id" 记为 "id"，通配符记为 "*"
+        std::vector<std::string> param_names;
         Handler handler;
     };
 
-    std::map<std::string, std::vector<Route>> routes_;
+    static Route make_route(const std::string& path, Handler handler);
+    // 路径是请求 arena 中的字符串，按字符区间匹配
+    static bool match(const Route& route, std::string_view path,
+                      std::cmatch& matches);
+    static const Route* find(const std::vector<Route>& routes,
+                             std::string_view path, std::cmatch& matches);
+    static void dispatch(const Route& route, const std::cmatch& matches,
+                         Request& req, Response& res);
+
+    // 以 Method 枚举为下标，Extension 槽位保存扩展方法名
+    std::array<std::vector<Route>, kMethodCount> routes_;
+    std::vector<std::pair<std::string, Route>> extension_routes_;
     std::vector<Handler> middlewares_;
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 固定数量的工作线程，任务按提交顺序取出执行
+// 队列本身不限长度，提交方需要自行限制未完成的任务数；
+// 析构时执行完已提交的任务再退出。
+class ThreadPool {
+  public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    // 任务抛出的异常由返回的 future 转交给调用方
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&task) {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        push([packaged] { (*packaged)(); });
+        return result;
+    }
+
+  private:
+    void push(std::function<void()> task);
+    void work();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+};
+
+#endif
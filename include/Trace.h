@@ -0,0 +1,97 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_HAVE_TSC 1
+#endif
+
+// 请求各阶段的计时
+//
+// 时间戳是计数而不是时间：x86 上有不变 TSC 时直接读 TSC，一次只要
+// 几十个周期；否则退回 steady_clock 的纳秒。换算成微秒只在请求结束时做。
+namespace trace {
+
+namespace detail {
+extern const bool use_tsc;
+} // namespace detail
+
+inline uint64_t now() {
+#ifdef TRACE_HAVE_TSC
+    if (detail::use_tsc) {
+        return __rdtsc();
+    }
+#endif
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// 计数差换算为微秒；使用 TSC 时第一次调用会测量约 20ms 的频率
+uint64_t to_us(uint64_t ticks);
+
+// 提前完成频率测量，避免第一个请求承担
+void calibrate();
+
+//   Accept  accept() 返回到连接线程开始处理，只计入连接上的第一个请求
+//   Read    收到请求的第一个字节到头部收完，以及处理器读取请求体的时间
+//   Parse   解析请求行与头部
+//   Route   路由匹配，包括 Router 的正则扫描
+//   Handle  处理器，不含其中读取请求体和发送响应的时间
+//   Write   发送响应
+enum class Phase : uint8_t { Accept, Read, Parse, Route, Handle, Write };
+
+constexpr size_t kPhaseCount = static_cast<size_t>(Phase::Write) + 1;
+
+const char *phase_name(Phase phase);
+
+// 一个请求的阶段计时，由处理它的线程独占使用
+class RequestTrace {
+  public:
+    // 从 ticks 开始计时，清空各阶段
+    void start(uint64_t ticks) {
+        phases_.fill(0);
+        nested_ = 0;
+        last_ = ticks;
+    }
+
+    // 从现在重新开始计时，之前的时间不计入任何阶段（如等待下一个请求）
+    void skip() { last_ = now(); }
+
+    // 上一次标记以来的时间计入 phase，扣除其间用 nested() 记到别处的部分
+    void mark(Phase phase) {
+        uint64_t t = now();
+        uint64_t elapsed = t - last_;
+        phases_[index(phase)] += elapsed > nested_ ? elapsed - nested_ : 0;
+        nested_ = 0;
+        last_ = t;
+    }
+
+    // 当前阶段中有 ticks 实际属于 phase，如处理器中的 recv 与 send
+    void nested(Phase phase, uint64_t ticks) {
+        phases_[index(phase)] += ticks;
+        nested_ += ticks;
+    }
+
+    uint64_t ticks(Phase phase) const { return phases_[index(phase)]; }
+
+    // 各阶段的微秒数，下标为 Phase
+    std::array<uint64_t, kPhaseCount> phases_us() const;
+
+  private:
+    static size_t index(Phase phase) { return static_cast<size_t>(phase); }
+
+    std::array<uint64_t, kPhaseCount> phases_{};
+    uint64_t nested_ = 0;
+    uint64_t last_ = 0;
+};
+
+} // namespace trace
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef URL_H
+#define URL_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// 请求目标的解析工具：路径段与查询参数都按需从原始字符串中切出，
+// 只返回视图，不分配；百分号解码由调用方在需要时进行。
+namespace url {
+
+// 路径中的非空段，连续的 '/' 和首尾的 '/' 不产生段
+class PathSegments {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view *;
+        using reference = const std::string_view &;
+
+        iterator() = default;
+        explicit iterator(std::string_view rest) : rest_(rest) { advance(); }
+
+        reference operator*() const { return current_; }
+        pointer operator->() const { return &current_; }
+        iterator &operator++() {
+            advance();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            advance();
+            return old;
+        }
+        bool operator==(const iterator &other) const {
+            return current_.data() == other.current_.data() &&
+                   current_.size() == other.current_.size();
+        }
+        bool operator!=(const iterator &other) const {
+            return !(*this == other);
+        }
+
+      private:
+        void advance();
+
+        std::string_view rest_;
+        std::string_view current_;
+    };
+
+    explicit PathSegments(std::string_view path) : path_(path) {}
+
+    iterator begin() const { return iterator(path_); }
+    iterator end() const { return iterator(); }
+
+    bool empty() const { return begin() == end(); }
+    size_t size() const;
+    // 最后一段，没有段时返回空视图
+    std::string_view back() const;
+
+  private:
+    std::string_view path_;
+};
+
+// 一个查询参数，键和值都还没有解码
+struct QueryParam {
+    std::string_view key;
+    std::string_view value;
+};
+
+// "a=1&b=2" 形式的键值对（也用于 x-www-form-urlencoded 请求体），
+// 空项跳过，没有 '=' 的项值为空
+class QueryParams {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = QueryParam;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const QueryParam *;
+        using reference = const QueryParam &;
+
+        iterator() = default;
+        explicit iterator(std::string_view rest) : rest_(rest) { advance(); }
+
+        reference operator*() const { return current_; }
+        pointer operator->() const { return &current_; }
+        iterator &operator++() {
+            advance();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            advance();
+            return old;
+        }
+        bool operator==(const iterator &other) const {
+            return current_.key.data() == other.current_.key.data() &&
+                   rest_.data() == other.rest_.data();
+        }
+        bool operator!=(const iterator &other) const {
+            return !(*this == other);
+        }
+
+      private:
+        void advance();
+
+        std::string_view rest_;
+        QueryParam current_;
+    };
+
+    explicit QueryParams(std::string_view query) : query_(query) {}
+
+    iterator begin() const { return iterator(query_); }
+    iterator end() const { return iterator(); }
+
+    // 第一个键（解码前）等于 key 的参数的原始值
+    bool find(std::string_view key, std::string_view &value) const;
+
+  private:
+    std::string_view query_;
+};
+
+// 第一个需要解码的字符的位置：'%'，plus_as_space 时还有 '+'；
+// 没有时返回 npos。按 16 字节一组用 SIMD 比较
+size_t find_escape(std::string_view s, bool plus_as_space);
+
+// 百分号解码并追加到 out，不完整或非法的 '%' 序列原样保留；
+// 查询参数与表单中 plus_as_space 为 true，路径中为 false
+void percent_decode(std::string_view s, std::string &out,
+                    bool plus_as_space);
+void percent_decode(std::string_view s, std::pmr::string &out,
+                    bool plus_as_space);
+std::string percent_decode(std::string_view s, bool plus_as_space);
+
+// 把请求路径解码并规范化为相对于根目录的路径，结果写入 out：
+// 合并连续的 '/'，去掉 "." 段，".." 回退一段，不保留首尾的 '/'，
+// 根目录本身为空串。以下情况返回 false：".." 超出根目录，
+// 解码出 '/' 或 '\0'，以及由编码得到的 "." 或 ".."（如 "%2e%2e"）
+bool normalize_path(std::string_view path, std::string &out);
+bool normalize_path(std::string_view path, std::pmr::string &out);
+
+} // namespace url
+
+#endif
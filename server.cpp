@@ -1,11 +1,19 @@
 #include "HttpServer.h"
 #include "Request.h"
+#include "RequestHandler.h"
 #include <filesystem>
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 #include <string>
 
 int main(int argc, char *argv[]) {
 
+    // 诊断日志交给 spdlog 的后台线程写出，队列满时覆盖最旧的消息，
+    // 不阻塞处理请求的线程；访问记录另由 AccessLog 负责
+    spdlog::init_thread_pool(8192, 1);
+    spdlog::set_default_logger(
+        spdlog::create_async_nb<spdlog::sinks::stdout_color_sink_mt>("server"));
     spdlog::set_level(spdlog::level::debug);
     spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] [%s:%#] %v");
     SPDLOG_INFO("============density test server============");
@@ -14,48 +22,21 @@ int main(int argc, char *argv[]) {
 
     HttpServer server(config);
 
-    server.set_request_handler([&](Request req, Response res) {
-        auto root = server.get_root_path();
-        auto relative_path = req.path.substr(1);
-        auto absolute_path = fs::path(root) / relative_path;
-
-        SPDLOG_DEBUG("Requested path: {}", absolute_path.string());
-
-        if (absolute_path.lexically_normal().string().find(root) != 0) {
-            throw std::runtime_error("Invalid path traversal attempt");
-        }
-
-        if (req.method == "GET") {
-            if (fs::exists(absolute_path)) {
-                if (fs::is_directory(absolute_path)) {
-                    res.send_directory_listing(absolute_path,
-                                               server.get_root_path());
-                } else {
-                    res.send_file(absolute_path);
-                }
-            } else {
-                throw std::runtime_error("404 Not Found");
-            }
-        } else {
-            throw std::runtime_error("Method not allowed");
-        }
-    });
+    // 路由、HEAD/OPTIONS 与 405 处理统一交给 RequestHandler
+    RequestHandler handler(server.get_root_path(),
+                           static_cast<size_t>(config.thread_pool_size),
+                           config.upload_dir);
 
-    server.set_error_handler([](const Request &req, Response &res,
-                                const std::exception &e) {
-        SPDLOG_ERROR("Error handling request {}: {}", req.path, e.what());
-
-        if (e.what() == std::string("404 Not Found")) {
-            res.status(404).send("404 Not Found");
-        } else if (e.what() == std::string("Method not allowed")) {
-            res.status(405).send("405 Method Not Allowed");
-        } else if (e.what() == std::string("Invalid path traversal attempt")) {
-            res.status(403).send("403 Forbidden");
-        } else {
-            res.status(500).send("500 Internal Server Error");
-        }
+    server.set_request_handler([&handler](Request &req, Response &res) {
+        handler.handle_request(req, res);
     });
 
+    // 请求头部本身的错误（如格式错误或过大）与处理器中的错误用同一套映射
+    server.set_error_handler(
+        [&handler](const Request &req, Response &res, const std::exception &e) {
+            handler.handle_error(req, res, e);
+        });
+
     server.start();
     server.run();
     return 0;
@@ -0,0 +1,251 @@
+#include "AccessLog.h"
+#include "BinaryAccessLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+// 一批格式化结果超过这个大小就先写出
+constexpr size_t kBatchBytes = 64 * 1024;
+// 队列为空时后台线程的等待时间，以及未满一批时最长的等待时间
+constexpr auto kIdleWait = std::chrono::milliseconds(2);
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+int64_t now_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch())
+        .count();
+}
+
+void append_number(std::string &out, uint64_t n) {
+    char digits[20];
+    size_t len = 0;
+    do {
+        digits[len++] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    } while (n != 0);
+    while (len > 0) {
+        out += digits[--len];
+    }
+}
+
+} // namespace
+
+void AccessRecord::set_target(std::string_view path, std::string_view query) {
+    size_t n = std::min(path.size(), kMaxTarget);
+    std::memcpy(target, path.data(), n);
+    if (!query.empty() && n < kMaxTarget) {
+        target[n++] = '?';
+        size_t q = std::min(query.size(), kMaxTarget - n);
+        std::memcpy(target + n, query.data(), q);
+        n += q;
+    }
+    target_size = static_cast<uint8_t>(n);
+}
+
+void AccessRecord::set_method(Method m, std::string_view extension_method) {
+    method = m;
+    size_t n = m == Method::Extension
+                   ? std::min(extension_method.size(), kMaxExtension)
+                   : 0;
+    std::memcpy(extension, extension_method.data(), n);
+    extension_size = static_cast<uint8_t>(n);
+}
+
+std::string_view AccessRecord::method_view() const {
+    if (method != Method::Extension) {
+        return method_name(method);
+    }
+    return extension_size > 0 ? std::string_view(extension, extension_size)
+                              : std::string_view("-");
+}
+
+AccessLog::AccessLog(const std::string &path, size_t capacity,
+                     Overflow overflow, Format format)
+    : overflow_(overflow) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open access log " + path + ": " +
+                                 std::strerror(errno));
+    }
+
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask_ = size - 1;
+    slots_ = std::make_unique<Slot[]>(size);
+    for (size_t i = 0; i < size; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    if (format == Format::Binary) {
+        encoder_ = std::make_unique<access_log::BinaryEncoder>();
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+AccessLog::~AccessLog() {
+    stop_.store(true);
+    thread_.join();
+    ::close(fd_);
+}
+
+void AccessLog::record(const AccessRecord &record) {
+    while (!try_push(record)) {
+        if (overflow_ == Overflow::Drop) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            dropped_total_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+// 有界 MPMC 队列 (Vyukov)：槽位的序号表示它可写还是可读
+bool AccessLog::try_push(const AccessRecord &record) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot &slot = slots_[pos & mask_];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool AccessLog::try_pop(AccessRecord &record) {
+    Slot &slot = slots_[tail_ & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+        return false;
+    }
+    record = slot.record;
+    slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+    tail_++;
+    return true;
+}
+
+void AccessLog::run() {
+    std::string out;
+    if (encoder_) {
+        encoder_->begin(now_us(), out);
+    }
+    auto last_write = std::chrono::steady_clock::now();
+    AccessRecord record;
+    for (;;) {
+        // 先读停止标志，保证停止前放入的记录都会被取出
+        bool stopping = stop_.load();
+        bool idle = true;
+        while (try_pop(record)) {
+            idle = false;
+            format(record, out);
+            if (out.size() >= kBatchBytes) {
+                write_out(out);
+                last_write = std::chrono::steady_clock::now();
+            }
+        }
+        if (uint64_t dropped = dropped_.exchange(0)) {
+            if (encoder_) {
+                encoder_->dropped(dropped, out);
+            } else {
+                out += "# ";
+                append_number(out, dropped);
+                out += " access log records dropped\n";
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (stopping || now - last_write >= kFlushInterval) {
+            write_out(out);
+            last_write = now;
+        }
+        if (stopping) {
+            return;
+        }
+        if (idle) {
+            std::this_thread::sleep_for(kIdleWait);
+        }
+    }
+}
+
+// 2026-10-19 08:30:00.123 GET /index.html?x=1 200 1534 87us
+void AccessLog::format(const AccessRecord &record, std::string &out) {
+    if (encoder_) {
+        encoder_->encode(record, out);
+        return;
+    }
+    int64_t second = record.time_us / 1000000;
+    if (second != cached_second_) {
+        time_t t = static_cast<time_t>(second);
+        tm local{};
+        localtime_r(&t, &local);
+        strftime(cached_time_, sizeof(cached_time_), "%Y-%m-%d %H:%M:%S",
+                 &local);
+        cached_second_ = second;
+    }
+    out += cached_time_;
+    out += '.';
+    int millis = static_cast<int>(record.time_us / 1000 % 1000);
+    out += static_cast<char>('0' + millis / 100);
+    out += static_cast<char>('0' + millis / 10 % 10);
+    out += static_cast<char>('0' + millis % 10);
+    out += ' ';
+    out += record.method_view();
+    out += ' ';
+    out += record.target_view();
+    out += ' ';
+    append_number(out, record.status);
+    out += ' ';
+    append_number(out, record.bytes);
+    out += ' ';
+    append_number(out, record.latency_us);
+    out += "us\n";
+}
+
+void AccessLog::write_out(std::string &out) {
+    std::string_view data = out;
+    while (!data.empty()) {
+        ssize_t n = ::write(fd_, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // 日志写失败不影响服务，丢弃这一批
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    out.clear();
+}
+
+bool RateLimiter::allow(uint64_t &suppressed) {
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (window != now && window_.compare_exchange_strong(window, now)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) < limit_) {
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
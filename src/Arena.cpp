@@ -0,0 +1,78 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMaxBlockSize = size_t(64) << 20;
+
+} // namespace
+
+Arena::Arena(size_t initial_block_size)
+    : next_block_size_(std::max<size_t>(initial_block_size, 256)) {}
+
+Arena::Arena(Arena &&other) noexcept
+    : blocks_(std::move(other.blocks_)), cursor_(other.cursor_),
+      limit_(other.limit_), next_block_size_(other.next_block_size_),
+      bytes_reserved_(other.bytes_reserved_) {
+    other.blocks_.clear();
+    other.cursor_ = other.limit_ = nullptr;
+    other.bytes_reserved_ = 0;
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+    if (this != &other) {
+        blocks_ = std::move(other.blocks_);
+        cursor_ = other.cursor_;
+        limit_ = other.limit_;
+        next_block_size_ = other.next_block_size_;
+        bytes_reserved_ = other.bytes_reserved_;
+
+        other.blocks_.clear();
+        other.cursor_ = other.limit_ = nullptr;
+        other.bytes_reserved_ = 0;
+    }
+    return *this;
+}
+
+void *Arena::allocate_slow(size_t size, size_t align) {
+    // 块大小按倍数增长，单次超大分配独占一个块
+    size_t block_size = std::max(next_block_size_, size + align);
+    next_block_size_ = std::min(next_block_size_ * 2, kMaxBlockSize);
+
+    // new char[] 不做零初始化，避免触碰整块内存
+    blocks_.push_back(
+        {std::unique_ptr<char[]>(new char[block_size]), block_size});
+    bytes_reserved_ += block_size;
+    cursor_ = blocks_.back().data.get();
+    limit_ = cursor_ + block_size;
+
+    return allocate(size, align);
+}
+
+std::string_view Arena::copy_string(std::string_view s) {
+    if (s.empty()) {
+        return {};
+    }
+    char *data = allocate_array<char>(s.size());
+    std::memcpy(data, s.data(), s.size());
+    return std::string_view(data, s.size());
+}
+
+void Arena::reset() {
+    if (blocks_.empty()) {
+        return;
+    }
+
+    auto largest = std::max_element(
+        blocks_.begin(), blocks_.end(),
+        [](const Block &a, const Block &b) { return a.size < b.size; });
+    Block keep = std::move(*largest);
+    blocks_.clear();
+    blocks_.push_back(std::move(keep));
+
+    bytes_reserved_ = blocks_.back().size;
+    cursor_ = blocks_.back().data.get();
+    limit_ = cursor_ + blocks_.back().size;
+}
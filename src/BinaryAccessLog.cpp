@@ -0,0 +1,182 @@
+#include "BinaryAccessLog.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+namespace access_log {
+
+namespace {
+
+constexpr char kMagic[4] = {'D', 'S', 'A', 'L'};
+
+template <typename T> void put(std::string &out, T value) {
+    auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out += static_cast<char>(bits >> (8 * i) & 0xff);
+    }
+}
+
+template <typename T> T get(std::string_view data, size_t offset) {
+    std::make_unsigned_t<T> bits = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        bits |= static_cast<std::make_unsigned_t<T>>(
+                    static_cast<uint8_t>(data[offset + i]))
+                << (8 * i);
+    }
+    return static_cast<T>(bits);
+}
+
+size_t padded(size_t n) { return (n + 7) & ~size_t(7); }
+
+} // namespace
+
+void BinaryEncoder::begin(int64_t time_us, std::string &out) {
+    ids_.clear();
+    next_id_ = 1;
+    out += static_cast<char>(EntryKind::Header);
+    out += static_cast<char>(kFormatVersion);
+    out.append(2, '\0');
+    out.append(kMagic, sizeof(kMagic));
+    put<int64_t>(out, time_us);
+}
+
+uint32_t BinaryEncoder::intern(std::string_view s, std::string &out) {
+    if (s.empty()) {
+        return 0;
+    }
+    key_.assign(s);
+    auto it = ids_.find(key_);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    uint32_t id = next_id_++;
+    ids_.emplace(key_, id);
+    out += static_cast<char>(EntryKind::String);
+    out += '\0';
+    put<uint16_t>(out, static_cast<uint16_t>(s.size()));
+    put<uint32_t>(out, id);
+    out.append(s);
+    out.append(padded(s.size()) - s.size(), '\0');
+    return id;
+}
+
+void BinaryEncoder::encode(const AccessRecord &record, std::string &out) {
+    // 清空后重写 Header，解码器随之丢弃旧的编号
+    if (ids_.size() + 2 > kMaxStrings) {
+        begin(record.time_us, out);
+    }
+    uint32_t target = intern(record.target_view(), out);
+    uint32_t route = intern(record.route, out);
+
+    out += static_cast<char>(EntryKind::Access);
+    out += static_cast<char>(record.method);
+    put<uint16_t>(out, record.status);
+    put<uint32_t>(out, record.latency_us);
+    put<int64_t>(out, record.time_us);
+    put<uint64_t>(out, record.bytes);
+    put<uint32_t>(out, target);
+    put<uint32_t>(out, route);
+}
+
+void BinaryEncoder::dropped(uint64_t count, std::string &out) {
+    out += static_cast<char>(EntryKind::Dropped);
+    out.append(7, '\0');
+    put<uint64_t>(out, count);
+}
+
+BinaryDecoder::BinaryDecoder(RecordCallback on_record,
+                             DroppedCallback on_dropped)
+    : on_record_(std::move(on_record)), on_dropped_(std::move(on_dropped)) {}
+
+void BinaryDecoder::feed(std::string_view data) {
+    pending_.append(data);
+    std::string_view rest = pending_;
+    while (size_t size = parse_entry(rest)) {
+        rest.remove_prefix(size);
+        offset_ += size;
+    }
+    pending_.erase(0, pending_.size() - rest.size());
+}
+
+void BinaryDecoder::finish() {
+    if (!pending_.empty()) {
+        throw std::runtime_error("Truncated access log at offset " +
+                                 std::to_string(offset_));
+    }
+}
+
+std::string_view BinaryDecoder::lookup(uint32_t id) const {
+    if (id == 0) {
+        return {};
+    }
+    auto it = strings_.find(id);
+    if (it == strings_.end()) {
+        throw std::runtime_error("Unknown string id at offset " +
+                                 std::to_string(offset_));
+    }
+    return it->second;
+}
+
+size_t BinaryDecoder::parse_entry(std::string_view data) {
+    if (data.size() < 8) {
+        return 0;
+    }
+    auto corrupt = [&](const char *what) {
+        return std::runtime_error(std::string(what) + " at offset " +
+                                  std::to_string(offset_));
+    };
+
+    switch (static_cast<EntryKind>(data[0])) {
+    case EntryKind::Header:
+        if (data.size() < 16) {
+            return 0;
+        }
+        if (data.substr(4, 4) != std::string_view(kMagic, sizeof(kMagic))) {
+            throw corrupt("Bad access log header");
+        }
+        if (static_cast<uint8_t>(data[1]) != kFormatVersion) {
+            throw corrupt("Unsupported access log version");
+        }
+        strings_.clear();
+        return 16;
+    case EntryKind::String: {
+        size_t length = get<uint16_t>(data, 2);
+        size_t size = 8 + padded(length);
+        if (data.size() < size) {
+            return 0;
+        }
+        strings_[get<uint32_t>(data, 4)] = data.substr(8, length);
+        return size;
+    }
+    case EntryKind::Access: {
+        if (data.size() < kAccessEntrySize) {
+            return 0;
+        }
+        DecodedRecord record;
+        record.method = static_cast<Method>(data[1]);
+        if (record.method > Method::Extension) {
+            throw corrupt("Bad method in access log");
+        }
+        record.status = get<uint16_t>(data, 2);
+        record.latency_us = get<uint32_t>(data, 4);
+        record.time_us = get<int64_t>(data, 8);
+        record.bytes = get<uint64_t>(data, 16);
+        record.target = lookup(get<uint32_t>(data, 24));
+        record.route = lookup(get<uint32_t>(data, 28));
+        on_record_(record);
+        return kAccessEntrySize;
+    }
+    case EntryKind::Dropped:
+        if (data.size() < 16) {
+            return 0;
+        }
+        if (on_dropped_) {
+            on_dropped_(get<uint64_t>(data, 8));
+        }
+        return 16;
+    }
+    throw corrupt("Unknown access log entry");
+}
+
+} // namespace access_log
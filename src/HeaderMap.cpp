@@ -0,0 +1,280 @@
+#include "HeaderMap.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr std::string_view kHeaderNames[kKnownHeaderCount] = {
+    "Host",
+    "Content-Length",
+    "Content-Type",
+    "Connection",
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "User-Agent",
+    "Transfer-Encoding",
+    "Content-Encoding",
+    "Cookie",
+    "Set-Cookie",
+    "Authorization",
+    "Cache-Control",
+    "If-None-Match",
+    "If-Modified-Since",
+    "Last-Modified",
+    "ETag",
+    "Range",
+    "Referer",
+    "Origin",
+    "Expect",
+    "Upgrade",
+    "Keep-Alive",
+    "Date",
+    "Server",
+    "Location",
+    "Allow",
+    "Vary",
+};
+
+constexpr char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+constexpr size_t kTableSize = 64;
+
+constexpr uint32_t header_hash(std::string_view name, uint32_t seed) {
+    uint32_t h = seed;
+    for (char c : name) {
+        h = (h ^ static_cast<uint8_t>(to_lower(c))) * 16777619u;
+    }
+    return (h ^ (h >> 16)) & (kTableSize - 1);
+}
+
+constexpr bool seed_is_perfect(uint32_t seed) {
+    bool used[kTableSize] = {};
+    for (auto name : kHeaderNames) {
+        uint32_t slot = header_hash(name, seed);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+// 编译期搜索一个对所有常用头部无冲突的种子
+constexpr uint32_t find_seed() {
+    for (uint32_t seed = 2166136261u; seed < 2166136261u + 100000; seed++) {
+        if (seed_is_perfect(seed)) {
+            return seed;
+        }
+    }
+    return 0;
+}
+
+constexpr uint32_t kSeed = find_seed();
+static_assert(kSeed != 0, "no perfect hash seed for known headers");
+
+struct SlotTable {
+    Header slots[kTableSize];
+};
+
+constexpr SlotTable make_slots() {
+    SlotTable table{};
+    for (auto &slot : table.slots) {
+        slot = Header::Unknown;
+    }
+    for (size_t i = 0; i < kKnownHeaderCount; i++) {
+        table.slots[header_hash(kHeaderNames[i], kSeed)] =
+            static_cast<Header>(i);
+    }
+    return table;
+}
+
+constexpr SlotTable kSlots = make_slots();
+
+} // namespace
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (to_lower(a[i]) != to_lower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Header lookup_header(std::string_view name) {
+    Header id = kSlots.slots[header_hash(name, kSeed)];
+    if (id != Header::Unknown &&
+        iequals(name, kHeaderNames[static_cast<size_t>(id)])) {
+        return id;
+    }
+    return Header::Unknown;
+}
+
+std::string_view header_name(Header id) {
+    return id == Header::Unknown ? std::string_view()
+                                 : kHeaderNames[static_cast<size_t>(id)];
+}
+
+void HeaderMap::add(std::string_view name, std::string_view value) {
+    append(lookup_header(name), name, value);
+}
+
+void HeaderMap::set(std::string_view name, std::string_view value) {
+    assign(lookup_header(name), name, value);
+}
+
+void HeaderMap::set(Header id, std::string_view value) {
+    assign(id, header_name(id), value);
+}
+
+bool HeaderMap::contains(Header id) const {
+    return id != Header::Unknown && known_[static_cast<size_t>(id)] != 0;
+}
+
+bool HeaderMap::contains(std::string_view name) const {
+    return find(lookup_header(name), name) != npos;
+}
+
+std::string_view HeaderMap::get(Header id) const {
+    if (!contains(id)) {
+        return {};
+    }
+    return value_of(entry(known_[static_cast<size_t>(id)] - 1));
+}
+
+std::string_view HeaderMap::get(std::string_view name) const {
+    size_t index = find(lookup_header(name), name);
+    return index == npos ? std::string_view() : value_of(entry(index));
+}
+
+void HeaderMap::erase(Header id) {
+    if (contains(id)) {
+        erase(header_name(id));
+    }
+}
+
+void HeaderMap::erase(std::string_view name) {
+    Header id = lookup_header(name);
+    for (size_t index = find(id, name); index != npos; index = find(id, name)) {
+        remove(index);
+    }
+}
+
+void HeaderMap::clear() {
+    size_ = 0;
+    overflow_.clear();
+    known_.fill(0);
+    bytes_.clear();
+}
+
+void HeaderMap::release() {
+    size_ = 0;
+    known_.fill(0);
+    // 交换而不是移动赋值：从短字符串移动赋值会保留原来的缓冲区
+    std::pmr::vector<Entry>(overflow_.get_allocator()).swap(overflow_);
+    std::pmr::string(bytes_.get_allocator()).swap(bytes_);
+}
+
+std::pair<std::string_view, std::string_view>
+HeaderMap::field(size_t index) const {
+    const Entry &e = entry(index);
+    return {name_of(e), value_of(e)};
+}
+
+std::string_view HeaderMap::name_of(const Entry &e) const {
+    if (e.id != Header::Unknown) {
+        return kHeaderNames[static_cast<size_t>(e.id)];
+    }
+    return std::string_view(bytes_.data() + e.name_offset, e.name_length);
+}
+
+std::string_view HeaderMap::value_of(const Entry &e) const {
+    return std::string_view(bytes_.data() + e.value_offset, e.value_length);
+}
+
+size_t HeaderMap::find(Header id, std::string_view name) const {
+    if (id != Header::Unknown) {
+        return known_[static_cast<size_t>(id)] - size_t(1);
+    }
+    for (size_t i = 0; i < size_; i++) {
+        const Entry &e = entry(i);
+        if (e.id == Header::Unknown && iequals(name_of(e), name)) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+void HeaderMap::append(Header id, std::string_view name,
+                       std::string_view value) {
+    if (bytes_.capacity() < 256) {
+        bytes_.reserve(256);
+    }
+
+    Entry e{};
+    e.id = id;
+    if (id == Header::Unknown) {
+        e.name_offset = static_cast<uint32_t>(bytes_.size());
+        e.name_length = static_cast<uint16_t>(name.size());
+        bytes_.append(name);
+    }
+    e.value_offset = static_cast<uint32_t>(bytes_.size());
+    e.value_length = static_cast<uint32_t>(value.size());
+    bytes_.append(value);
+
+    if (size_ < kInlineEntries) {
+        inline_[size_] = e;
+    } else {
+        overflow_.push_back(e);
+    }
+    if (id != Header::Unknown && known_[static_cast<size_t>(id)] == 0) {
+        known_[static_cast<size_t>(id)] = static_cast<uint16_t>(size_ + 1);
+    }
+    size_++;
+}
+
+void HeaderMap::assign(Header id, std::string_view name,
+                       std::string_view value) {
+    size_t index = find(id, name);
+    if (index == npos) {
+        append(id, name, value);
+        return;
+    }
+
+    // 旧值留在缓冲区中，clear() 时统一回收
+    Entry &e = entry(index);
+    if (value.size() <= e.value_length) {
+        std::memcpy(&bytes_[e.value_offset], value.data(), value.size());
+    } else {
+        e.value_offset = static_cast<uint32_t>(bytes_.size());
+        bytes_.append(value);
+    }
+    e.value_length = static_cast<uint32_t>(value.size());
+}
+
+void HeaderMap::remove(size_t index) {
+    for (size_t i = index; i + 1 < size_; i++) {
+        entry(i) = entry(i + 1);
+    }
+    size_--;
+    if (size_ >= kInlineEntries) {
+        overflow_.pop_back();
+    }
+    reindex();
+}
+
+void HeaderMap::reindex() {
+    known_.fill(0);
+    for (size_t i = size_; i-- > 0;) {
+        const Entry &e = entry(i);
+        if (e.id != Header::Unknown) {
+            known_[static_cast<size_t>(e.id)] = static_cast<uint16_t>(i + 1);
+        }
+    }
+}
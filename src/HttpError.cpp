@@ -0,0 +1,20 @@
+#include "HttpError.h"
+#include "ResponseFragments.h"
+
+HttpError::HttpError(int status, const std::string &detail)
+    : std::runtime_error(detail.empty() ? status_text(status) : detail),
+      status_(status) {}
+
+std::string status_text(int status) {
+    std::string text = std::to_string(status);
+    text += ' ';
+    text += reason_phrase(status);
+    return text;
+}
+
+int error_status(const std::exception &e) {
+    if (auto *error = dynamic_cast<const HttpError *>(&e)) {
+        return error->status();
+    }
+    return 500;
+}
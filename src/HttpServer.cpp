@@ -1,9 +1,14 @@
 #include "HttpServer.h"
+#include "HttpError.h"
+#include "Metrics.h"
 #include "Request.h"
 #include "Response.h"
 #include <algorithm>
+#include <arpa/inet.h>
 #include <asm-generic/socket.h>
 #include <cctype>
+#include <charconv>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <exception>
@@ -21,15 +26,65 @@
 #include <unistd.h>
 
 #include "JsonValue.h"
-#include "split.h"
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+// 取出下一行（不含行尾的 \r\n 或 \n）
+std::string_view next_line(std::string_view &s) {
+    size_t newline = s.find('\n');
+    std::string_view line = s.substr(0, newline);
+    s.remove_prefix(newline == std::string_view::npos ? s.size()
+                                                      : newline + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+// 取出下一个以空白分隔的词
+std::string_view next_word(std::string_view &s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        s = {};
+        return {};
+    }
+    s.remove_prefix(begin);
+    size_t end = s.find_first_of(" \t");
+    std::string_view word = s.substr(0, end);
+    s.remove_prefix(word.size());
+    return word;
+}
+
+} // namespace
 
 class HttpServer::Impl {
   public:
-    Impl(const Config &config) : port_(config.port), server_fd_(-1) {
+    Impl(const Config &config)
+        : port_(config.port), server_fd_(-1),
+          keep_alive_timeout_(config.keep_alive_timeout),
+          max_body_size_(config.max_body_size),
+          metrics_path_(config.metrics_path),
+          slow_request_us_(static_cast<uint64_t>(config.slow_request_ms) *
+                           1000) {
         root_dir_ = fs::absolute(config.root_dir);
         if (!fs::is_directory(root_dir_)) {
             throw std::runtime_error("Path is not a directory: " + root_dir_);
         }
+        if (config.enable_logging && !config.access_log.empty()) {
+            access_log_ = std::make_unique<AccessLog>(
+                config.access_log, config.access_log_capacity,
+                config.access_log_overflow, config.access_log_format);
+        }
+        trace::calibrate();
     }
     ~Impl() { close(server_fd_); }
 
@@ -45,8 +100,14 @@ class HttpServer::Impl {
     void set_error_handler(ErrorHandler handler) {
         error_handler_ = std::move(handler);
     }
-    void handle_client(int client_fd);
-    Request parse_request(int client_fd, const std::string &request);
+    // accepted 为 accept() 返回时的 trace::now()
+    void handle_client(int client_fd, uint64_t accepted);
+    // 结束阶段计时，记录指标、慢请求与访问日志
+    void record_request(Metrics::Recorder &recorder, Request &request,
+                        const Response &response,
+                        std::chrono::steady_clock::time_point started);
+    void log_if_slow(const Request &request, const Response &response,
+                     const std::array<uint64_t, trace::kPhaseCount> &phases);
 
     void set_root_directory(const std::string &path);
 
@@ -55,7 +116,14 @@ class HttpServer::Impl {
   private:
     int port_;
     int server_fd_;
+    int keep_alive_timeout_;
+    size_t max_body_size_;
     std::string root_dir_;
+    std::unique_ptr<AccessLog> access_log_;
+    std::string metrics_path_;
+    Metrics metrics_;
+    uint64_t slow_request_us_;
+    RateLimiter slow_log_limit_{10}; // 每秒最多记录的慢请求数
 
     RequestHandler request_handler_;
     ErrorHandler error_handler_;
@@ -106,6 +174,7 @@ void HttpServer::Impl::run() {
         socklen_t client_len = sizeof(client_addr);
         int client_fd =
             accept(server_fd_, (sockaddr *)&client_addr, &client_len);
+        uint64_t accepted = trace::now();
         if (client_fd < 0) {
             int err = errno;
             switch (err) {
@@ -133,8 +202,8 @@ void HttpServer::Impl::run() {
             continue;
         }
 
-        std::thread([this, client_fd] {
-            handle_client(client_fd);
+        std::thread([this, client_fd, accepted] {
+            handle_client(client_fd, accepted);
             close(client_fd);
         }).detach();
     }
@@ -150,52 +219,74 @@ void HttpServer::set_error_handler(ErrorHandler handler) {
     impl_->set_error_handler(std::move(handler));
 }
 
-Request HttpServer::Impl::parse_request(int client_fd,
-                                        const std::string &request) {
-
-    std::istringstream stream(request);
-    Request req(client_fd);
-
-    stream >> req.method >> req.path >> req.version;
-
-    req.splited_path = split_path(req.path, '/');
-
-    std::transform(req.method.begin(), req.method.end(), req.method.begin(),
-                   ::toupper);
-
-    stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-
-    std::string header_line;
-    while (std::getline(stream, header_line) && header_line != "\r") {
-        if (header_line.back() == '\r')
-            header_line.pop_back();
-
-        auto colon_pos = header_line.find(':');
-        if (colon_pos != std::string::npos) {
-            std::string key = header_line.substr(0, colon_pos);
-            std::string value = header_line.substr(colon_pos + 1);
+size_t parse_request(std::string_view received, Request &req,
+                     size_t max_body_size) {
+    size_t header_end = received.find("\r\n\r\n");
+    if (header_end == std::string_view::npos) {
+        throw HttpError(400, "Incomplete request header");
+    }
+    size_t header_size = header_end + 4;
+    std::string_view head = received.substr(0, header_end + 2);
+
+    // 请求行：方法、目标与版本以空白分隔
+    std::string_view line = next_line(head);
+    std::string_view method = next_word(line);
+    std::string_view target = next_word(line);
+    req.version = next_word(line);
+
+    req.method = parse_method(method);
+    if (req.method == Method::Extension) {
+        req.extension_method = method;
+    }
 
-            key.erase(0, key.find_first_not_of(" "));
-            key.erase(key.find_last_not_of(" ") + 1);
-            value.erase(0, value.find_first_not_of(" "));
-            value.erase(value.find_last_not_of(" ") + 1);
+    size_t question = target.find('?');
+    req.path = target.substr(0, question);
+    if (question != std::string_view::npos) {
+        req.query_string = target.substr(question + 1);
+    }
 
-            req.headers[key] = value;
+    while (!head.empty()) {
+        line = next_line(head);
+        size_t colon_pos = line.find(':');
+        if (colon_pos != std::string_view::npos) {
+            std::string_view key = trim(line.substr(0, colon_pos));
+            std::string_view value = trim(line.substr(colon_pos + 1));
+            // 多个取值不同的 Content-Length 无法确定请求体的边界
+            if (lookup_header(key) == Header::ContentLength &&
+                req.headers.contains(Header::ContentLength) &&
+                req.headers.get(Header::ContentLength) != value) {
+                throw HttpError(400, "Conflicting Content-Length");
+            }
+            req.headers.add(key, value);
         }
     }
 
-    // 解析请求体（如果有）
-    if (req.headers.find("Content-Length") != req.headers.end()) {
-        size_t content_length = std::stoul(req.headers["Content-Length"]);
-        req.body.resize(content_length);
-        stream.read(reinterpret_cast<char*>(req.body.data()), content_length);
-        if (req.isBodyLikelyString()) {
-            req.body_str = std::string(req.body.begin(), req.body.end());
+    // 请求体只按 Content-Length 划分。带 Transfer-Encoding 的请求体如果
+    // 留在连接上，会被当作下一个请求解析，因此一律拒绝，随后关闭连接
+    if (req.headers.contains(Header::TransferEncoding)) {
+        std::string_view coding = req.headers.get(Header::TransferEncoding);
+        throw HttpError(iequals(coding, "chunked") ? 501 : 400,
+                        "Unsupported Transfer-Encoding: " +
+                            std::string(coding));
+    }
+
+    // 请求体不在这里读取，只记录随头部收到的前缀，由 Request 按需接收
+    size_t content_length = 0;
+    if (req.headers.contains(Header::ContentLength)) {
+        std::string_view length = req.headers.get(Header::ContentLength);
+        auto [end, ec] = std::from_chars(
+            length.data(), length.data() + length.size(), content_length);
+        if (ec != std::errc() || end != length.data() + length.size()) {
+            throw HttpError(400, "Invalid Content-Length");
+        }
+        if (content_length > max_body_size) {
+            throw HttpError(413);
         }
-        req.json_value = JsonValue::parse(req.body_str);
     }
+    std::string_view prefix = received.substr(header_size);
+    req.set_body_source(prefix, content_length);
 
-    return req;
+    return header_size + std::min(prefix.size(), content_length);
 }
 
 const std::string &HttpServer::get_root_path() {
@@ -204,25 +295,171 @@ const std::string &HttpServer::get_root_path() {
 
 const std::string &HttpServer::Impl::get_root_path() { return root_dir_; }
 
-void HttpServer::Impl::handle_client(int client_fd) {
+namespace {
+
+// 指标只对本机开放
+bool is_loopback_peer(int fd) {
+    sockaddr_storage peer{};
+    socklen_t len = sizeof(peer);
+    if (getpeername(fd, reinterpret_cast<sockaddr *>(&peer), &len) != 0) {
+        return false;
+    }
+    if (peer.ss_family == AF_INET) {
+        auto *in = reinterpret_cast<const sockaddr_in *>(&peer);
+        return (ntohl(in->sin_addr.s_addr) >> 24) == 127;
+    }
+    if (peer.ss_family == AF_INET6) {
+        auto *in6 = reinterpret_cast<const sockaddr_in6 *>(&peer);
+        return IN6_IS_ADDR_LOOPBACK(&in6->sin6_addr);
+    }
+    return false;
+}
+
+} // namespace
+
+void HttpServer::Impl::handle_client(int client_fd, uint64_t accepted) {
+
+    constexpr size_t kMaxHeaderSize = 64 * 1024;
+
+    // 空闲超过 keep_alive_timeout_ 秒的连接由 recv 超时结束
+    timeval timeout{};
+    timeout.tv_sec = keep_alive_timeout_;
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // 连接上的请求依次复用同一对 Request/Response 及其缓冲区
+    Request request(client_fd);
+    Response response(client_fd, request.resource());
+    Metrics::Recorder recorder(metrics_);
+    bool serve_metrics = !metrics_path_.empty() && is_loopback_peer(client_fd);
+    std::string received;
+    char buffer[4096];
+    bool keep_alive = true;
+    auto started = std::chrono::steady_clock::now();
+    request.trace.start(accepted);
+    request.trace.mark(trace::Phase::Accept);
+
+    while (keep_alive) {
+        // 响应的头部在请求的 arena 中，先于请求重置
+        response.reset();
+        request.reset();
+        try {
+            // 读到头部结束为止，多收到的部分是请求体的开头或下一个请求
+            while (received.find("\r\n\r\n") == std::string::npos) {
+                if (received.size() > kMaxHeaderSize) {
+                    throw HttpError(431, "Request header too large");
+                }
+                bool idle = received.empty();
+                ssize_t bytes_read =
+                    recv(client_fd, buffer, sizeof(buffer), 0);
+                if (bytes_read <= 0) {
+                    if (received.empty()) {
+                        return;
+                    }
+                    throw HttpError(400, "Incomplete request header");
+                }
+                // 等待请求的第一个字节是空闲时间，不计入读取阶段
+                if (idle) {
+                    request.trace.skip();
+                }
+                received.append(buffer, static_cast<size_t>(bytes_read));
+            }
+            request.trace.mark(trace::Phase::Read);
+
+            started = std::chrono::steady_clock::now();
+            size_t consumed =
+                parse_request(received, request, max_body_size_);
+            received.erase(0, consumed);
+            request.trace.mark(trace::Phase::Parse);
+            keep_alive = request.keep_alive();
+            response.keep_alive(keep_alive);
+
+            if (serve_metrics && request.method == Method::Get &&
+                std::string_view(request.path) == metrics_path_) {
+                response.header("Content-Type", "text/plain; version=0.0.4");
+                response.send(metrics_.scrape());
+            } else {
+                request_handler_(request, response);
+                record_request(recorder, request, response, started);
+            }
 
-    try {
-        char buffer[4096] = {0};
-        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes_read <= 0) {
-            perror("recv failed");
+            // 响应不完整或请求体没能读完时，连接的状态已经不确定
+            keep_alive = keep_alive && response.complete() &&
+                         request.discard_body();
+            // 连接上的下一个请求从现在开始计时，Accept 阶段为 0
+            request.trace.start(trace::now());
+        } catch (const std::exception &e) {
+            response.reset();
+            error_handler_(request, response, e);
+            record_request(recorder, request, response, started);
             return;
         }
+    }
+}
 
-        Request request = parse_request(client_fd, buffer);
-        Response response(client_fd);
-        request_handler_(request, response);
+// 访问日志只复制定长字段，格式化和写文件由后台线程完成
+void HttpServer::Impl::record_request(
+    Metrics::Recorder &recorder, Request &request, const Response &response,
+    std::chrono::steady_clock::time_point started) {
+    using namespace std::chrono;
+    // 处理器中读取请求体与发送响应的时间各自计入 Read 与 Write
+    request.trace.nested(trace::Phase::Read, request.body_read_ticks());
+    request.trace.nested(trace::Phase::Write, response.write_ticks());
+    request.trace.mark(trace::Phase::Handle);
+    std::array<uint64_t, trace::kPhaseCount> phases =
+        request.trace.phases_us();
+
+    auto latency_us = static_cast<uint64_t>(
+        duration_cast<microseconds>(steady_clock::now() - started).count());
+    recorder.record(request.route, response.status_code(), latency_us);
+    recorder.record_phases(phases);
+    log_if_slow(request, response, phases);
+    if (!access_log_) {
+        return;
+    }
+    AccessRecord record;
+    record.time_us =
+        duration_cast<microseconds>(system_clock::now().time_since_epoch())
+            .count();
+    record.latency_us = static_cast<uint32_t>(latency_us);
+    record.status = static_cast<uint16_t>(response.status_code());
+    record.bytes = response.bytes_sent();
+    record.set_method(request.method, request.extension_method);
+    record.set_target(request.path, request.query_string);
+    record.route = request.route;
+    access_log_->record(record);
+}
+
+// Slow request GET /upload 200 1523400us: accept=0us read=1200us ...
+void HttpServer::Impl::log_if_slow(
+    const Request &request, const Response &response,
+    const std::array<uint64_t, trace::kPhaseCount> &phases) {
+    uint64_t total = 0;
+    for (uint64_t us : phases) {
+        total += us;
+    }
+    uint64_t suppressed = 0;
+    if (slow_request_us_ == 0 || total < slow_request_us_ ||
+        !slow_log_limit_.allow(suppressed)) {
+        return;
+    }
+    if (suppressed > 0) {
+        SPDLOG_WARN("{} slow requests were not logged", suppressed);
+    }
 
-    } catch (const std::exception& e) {
-        Request error_req(client_fd);
-        Response error_res(client_fd);
-        error_handler_(error_req, error_res, e);
+    std::string breakdown;
+    for (size_t i = 0; i < trace::kPhaseCount; i++) {
+        breakdown += i == 0 ? "" : " ";
+        breakdown += trace::phase_name(static_cast<trace::Phase>(i));
+        breakdown += '=';
+        breakdown += std::to_string(phases[i]);
+        breakdown += "us";
     }
+    std::string_view method = request.method == Method::Extension
+                                  ? std::string_view(request.extension_method)
+                                  : method_name(request.method);
+    SPDLOG_WARN("Slow request {} {}{}{} {} {}us: {}", method, request.path,
+                request.query_string.empty() ? "" : "?", request.query_string,
+                response.status_code(), total, breakdown);
 }
 
 // 添加静态文件服务
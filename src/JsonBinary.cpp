@@ -0,0 +1,581 @@
+#include "JsonBinary.h"
+#include "JsonStructural.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace json {
+
+namespace {
+
+constexpr size_t kMaxDepth = 1024;
+
+// 两种格式共用的大端读取
+class ByteReader {
+  public:
+    ByteReader(std::string_view data, const char *format)
+        : p_(reinterpret_cast<const uint8_t *>(data.data())),
+          end_(p_ + data.size()), format_(format) {}
+
+    bool at_end() const { return p_ == end_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+    uint8_t byte() {
+        need(1);
+        return *p_++;
+    }
+
+    uint64_t big_endian(size_t n) {
+        need(n);
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; i++) {
+            v = v << 8 | p_[i];
+        }
+        p_ += n;
+        return v;
+    }
+
+    std::string_view bytes(uint64_t n) {
+        need(n);
+        std::string_view s(reinterpret_cast<const char *>(p_), n);
+        p_ += n;
+        return s;
+    }
+
+    // 元素个数不可能超过剩余字节数，避免按伪造的长度预留内存
+    size_t count(uint64_t n) {
+        need(n);
+        return static_cast<size_t>(n);
+    }
+
+    [[noreturn]] void error(const char *what) const {
+        throw std::runtime_error(std::string(format_) + ": " + what);
+    }
+
+    void enter(size_t &depth) const {
+        if (++depth > kMaxDepth) {
+            error("nesting too deep");
+        }
+    }
+
+  private:
+    void need(uint64_t n) const {
+        if (n > remaining()) {
+            error("unexpected end of data");
+        }
+    }
+
+    const uint8_t *p_;
+    const uint8_t *end_;
+    const char *format_;
+};
+
+JsonValue utf8_string(ByteReader &in, std::string_view s) {
+    if (!validate_utf8(s)) {
+        in.error("invalid UTF-8 in string");
+    }
+    return JsonValue(s);
+}
+
+// 超出 int64 的无符号整数按浮点数处理
+JsonValue unsigned_integer(uint64_t n) {
+    if (n > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        return JsonValue(static_cast<double>(n));
+    }
+    return JsonValue(static_cast<int64_t>(n));
+}
+
+double float32(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+double float64(uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// IEEE 754 半精度
+double float16(uint16_t bits) {
+    int exponent = bits >> 10 & 0x1F;
+    int mantissa = bits & 0x3FF;
+    double value;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    } else if (exponent == 31) {
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                              : std::numeric_limits<double>::quiet_NaN();
+    } else {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    return bits & 0x8000 ? -value : value;
+}
+
+void put_big_endian(std::string &out, uint64_t v, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        out += static_cast<char>(v >> (i * 8) & 0xFF);
+    }
+}
+
+// MessagePack 解码，递归构建 JsonValue
+class MsgPackDecoder {
+  public:
+    explicit MsgPackDecoder(std::string_view data)
+        : in_(data, "MessagePack") {}
+
+    JsonValue decode_document() {
+        JsonValue value = decode();
+        if (!in_.at_end()) {
+            in_.error("unexpected data after value");
+        }
+        return value;
+    }
+
+  private:
+    JsonValue decode() {
+        uint8_t b = in_.byte();
+        if (b <= 0x7F) {
+            return JsonValue(static_cast<int64_t>(b));
+        }
+        if (b >= 0xE0) {
+            return JsonValue(static_cast<int64_t>(static_cast<int8_t>(b)));
+        }
+        if (b >= 0xA0 && b <= 0xBF) {
+            return string(b & 0x1F);
+        }
+        if (b >= 0x90 && b <= 0x9F) {
+            return array(b & 0x0F);
+        }
+        if (b >= 0x80 && b <= 0x8F) {
+            return map(b & 0x0F);
+        }
+
+        switch (b) {
+        case 0xC0:
+            return JsonValue(nullptr);
+        case 0xC2:
+            return JsonValue(false);
+        case 0xC3:
+            return JsonValue(true);
+        case 0xC4:
+        case 0xD9:
+            return string(in_.big_endian(1));
+        case 0xC5:
+        case 0xDA:
+            return string(in_.big_endian(2));
+        case 0xC6:
+        case 0xDB:
+            return string(in_.big_endian(4));
+        case 0xCA:
+            return JsonValue(
+                float32(static_cast<uint32_t>(in_.big_endian(4))));
+        case 0xCB:
+            return JsonValue(float64(in_.big_endian(8)));
+        case 0xCC:
+            return JsonValue(static_cast<int64_t>(in_.big_endian(1)));
+        case 0xCD:
+            return JsonValue(static_cast<int64_t>(in_.big_endian(2)));
+        case 0xCE:
+            return JsonValue(static_cast<int64_t>(in_.big_endian(4)));
+        case 0xCF:
+            return unsigned_integer(in_.big_endian(8));
+        case 0xD0:
+            return JsonValue(static_cast<int64_t>(
+                static_cast<int8_t>(in_.big_endian(1))));
+        case 0xD1:
+            return JsonValue(static_cast<int64_t>(
+                static_cast<int16_t>(in_.big_endian(2))));
+        case 0xD2:
+            return JsonValue(static_cast<int64_t>(
+                static_cast<int32_t>(in_.big_endian(4))));
+        case 0xD3:
+            return JsonValue(static_cast<int64_t>(in_.big_endian(8)));
+        case 0xDC:
+            return array(in_.big_endian(2));
+        case 0xDD:
+            return array(in_.big_endian(4));
+        case 0xDE:
+            return map(in_.big_endian(2));
+        case 0xDF:
+            return map(in_.big_endian(4));
+        case 0xC1:
+            in_.error("invalid type byte 0xc1");
+        default:
+            // 0xc7-0xc9 与 0xd4-0xd8
+            in_.error("extension types are not supported");
+        }
+    }
+
+    JsonValue string(uint64_t size) {
+        return utf8_string(in_, in_.bytes(size));
+    }
+
+    JsonValue array(uint64_t size) {
+        in_.enter(depth_);
+        JsonValue::Array result;
+        result.reserve(in_.count(size));
+        for (uint64_t i = 0; i < size; i++) {
+            result.push_back(decode());
+        }
+        depth_--;
+        return JsonValue(std::move(result));
+    }
+
+    JsonValue map(uint64_t size) {
+        in_.enter(depth_);
+        in_.count(size);
+        JsonValue::Object result;
+        for (uint64_t i = 0; i < size; i++) {
+            JsonValue key = decode();
+            if (!key.is_string()) {
+                in_.error("map key must be a string");
+            }
+            // 重复的键以最后一个为准
+            result.insert_or_assign(std::string(key.as_string()), decode());
+        }
+        depth_--;
+        return JsonValue(std::move(result));
+    }
+
+    ByteReader in_;
+    size_t depth_ = 0;
+};
+
+void put_msgpack_size(std::string &out, size_t size, uint8_t fix,
+                      size_t fix_limit, uint8_t b8, uint8_t b16,
+                      uint8_t b32) {
+    if (size < fix_limit) {
+        out += static_cast<char>(fix | size);
+    } else if (b8 && size <= 0xFF) {
+        out += static_cast<char>(b8);
+        put_big_endian(out, size, 1);
+    } else if (size <= 0xFFFF) {
+        out += static_cast<char>(b16);
+        put_big_endian(out, size, 2);
+    } else {
+        out += static_cast<char>(b32);
+        put_big_endian(out, size, 4);
+    }
+}
+
+void put_msgpack_integer(std::string &out, int64_t n) {
+    if (n >= 0) {
+        uint64_t u = static_cast<uint64_t>(n);
+        if (u <= 0x7F) {
+            out += static_cast<char>(u);
+        } else if (u <= 0xFF) {
+            out += '\xCC';
+            put_big_endian(out, u, 1);
+        } else if (u <= 0xFFFF) {
+            out += '\xCD';
+            put_big_endian(out, u, 2);
+        } else if (u <= 0xFFFFFFFF) {
+            out += '\xCE';
+            put_big_endian(out, u, 4);
+        } else {
+            out += '\xCF';
+            put_big_endian(out, u, 8);
+        }
+        return;
+    }
+
+    uint64_t bits = static_cast<uint64_t>(n);
+    if (n >= -32) {
+        out += static_cast<char>(bits & 0xFF);
+    } else if (n >= INT8_MIN) {
+        out += '\xD0';
+        put_big_endian(out, bits, 1);
+    } else if (n >= INT16_MIN) {
+        out += '\xD1';
+        put_big_endian(out, bits, 2);
+    } else if (n >= INT32_MIN) {
+        out += '\xD2';
+        put_big_endian(out, bits, 4);
+    } else {
+        out += '\xD3';
+        put_big_endian(out, bits, 8);
+    }
+}
+
+// CBOR 解码，支持定长与不定长的字符串、数组和映射
+class CborDecoder {
+  public:
+    explicit CborDecoder(std::string_view data) : in_(data, "CBOR") {}
+
+    JsonValue decode_document() {
+        JsonValue value = decode();
+        if (!in_.at_end()) {
+            in_.error("unexpected data after value");
+        }
+        return value;
+    }
+
+  private:
+    static constexpr uint8_t kIndefinite = 31;
+    static constexpr uint8_t kBreak = 0xFF;
+
+    // 附加信息对应的参数；不定长时 indefinite 为 true
+    uint64_t argument(uint8_t info, bool &indefinite) {
+        indefinite = false;
+        if (info < 24) {
+            return info;
+        }
+        switch (info) {
+        case 24:
+            return in_.big_endian(1);
+        case 25:
+            return in_.big_endian(2);
+        case 26:
+            return in_.big_endian(4);
+        case 27:
+            return in_.big_endian(8);
+        case kIndefinite:
+            indefinite = true;
+            return 0;
+        default:
+            in_.error("reserved additional information");
+        }
+    }
+
+    JsonValue decode() {
+        uint8_t b = in_.byte();
+        uint8_t major = b >> 5;
+        uint8_t info = b & 0x1F;
+
+        if (major == 7) {
+            return simple(info);
+        }
+
+        bool indefinite = false;
+        uint64_t arg = argument(info, indefinite);
+        if (indefinite && major <= 1) {
+            in_.error("indefinite length integer");
+        }
+
+        switch (major) {
+        case 0:
+            return unsigned_integer(arg);
+        case 1:
+            // 值为 -1 - arg
+            if (arg > static_cast<uint64_t>(
+                          std::numeric_limits<int64_t>::max())) {
+                return JsonValue(-1.0 - static_cast<double>(arg));
+            }
+            return JsonValue(-1 - static_cast<int64_t>(arg));
+        case 2:
+        case 3:
+            return string(major, arg, indefinite);
+        case 4:
+            return array(arg, indefinite);
+        case 5:
+            return map(arg, indefinite);
+        default:
+            // 标签：忽略标签号，只保留内容
+            if (indefinite) {
+                in_.error("indefinite length tag");
+            }
+            return decode();
+        }
+    }
+
+    JsonValue simple(uint8_t info) {
+        switch (info) {
+        case 20:
+            return JsonValue(false);
+        case 21:
+            return JsonValue(true);
+        case 22:
+        case 23:
+            return JsonValue(nullptr);
+        case 25:
+            return JsonValue(
+                float16(static_cast<uint16_t>(in_.big_endian(2))));
+        case 26:
+            return JsonValue(
+                float32(static_cast<uint32_t>(in_.big_endian(4))));
+        case 27:
+            return JsonValue(float64(in_.big_endian(8)));
+        case kIndefinite:
+            in_.error("unexpected break");
+        default:
+            in_.error("unsupported simple value");
+        }
+    }
+
+    // 不定长字符串由若干个同类型的定长片段组成，以 break 结束
+    JsonValue string(uint8_t major, uint64_t size, bool indefinite) {
+        if (!indefinite) {
+            return utf8_string(in_, in_.bytes(size));
+        }
+        std::string joined;
+        while (true) {
+            uint8_t b = in_.byte();
+            if (b == kBreak) {
+                break;
+            }
+            bool nested = false;
+            uint64_t chunk = argument(b & 0x1F, nested);
+            if (b >> 5 != major || nested) {
+                in_.error("invalid chunk in indefinite length string");
+            }
+            joined.append(in_.bytes(chunk));
+        }
+        return utf8_string(in_, joined);
+    }
+
+    bool next(uint64_t &i, uint64_t size, bool indefinite) {
+        if (!indefinite) {
+            return i++ < size;
+        }
+        if (in_.remaining() > 0 && peek() == kBreak) {
+            in_.byte();
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t peek() {
+        ByteReader copy = in_;
+        return copy.byte();
+    }
+
+    JsonValue array(uint64_t size, bool indefinite) {
+        in_.enter(depth_);
+        JsonValue::Array result;
+        if (!indefinite) {
+            result.reserve(in_.count(size));
+        }
+        for (uint64_t i = 0; next(i, size, indefinite);) {
+            result.push_back(decode());
+        }
+        depth_--;
+        return JsonValue(std::move(result));
+    }
+
+    JsonValue map(uint64_t size, bool indefinite) {
+        in_.enter(depth_);
+        if (!indefinite) {
+            in_.count(size);
+        }
+        JsonValue::Object result;
+        for (uint64_t i = 0; next(i, size, indefinite);) {
+            JsonValue key = decode();
+            if (!key.is_string()) {
+                in_.error("map key must be a string");
+            }
+            result.insert_or_assign(std::string(key.as_string()), decode());
+        }
+        depth_--;
+        return JsonValue(std::move(result));
+    }
+
+    ByteReader in_;
+    size_t depth_ = 0;
+};
+
+void put_cbor_head(std::string &out, uint8_t major, uint64_t arg) {
+    uint8_t m = static_cast<uint8_t>(major << 5);
+    if (arg < 24) {
+        out += static_cast<char>(m | arg);
+    } else if (arg <= 0xFF) {
+        out += static_cast<char>(m | 24);
+        put_big_endian(out, arg, 1);
+    } else if (arg <= 0xFFFF) {
+        out += static_cast<char>(m | 25);
+        put_big_endian(out, arg, 2);
+    } else if (arg <= 0xFFFFFFFF) {
+        out += static_cast<char>(m | 26);
+        put_big_endian(out, arg, 4);
+    } else {
+        out += static_cast<char>(m | 27);
+        put_big_endian(out, arg, 8);
+    }
+}
+
+uint64_t double_bits(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+JsonValue decode_msgpack(std::string_view data) {
+    return MsgPackDecoder(data).decode_document();
+}
+
+void encode_msgpack(const JsonValue &value, std::string &out) {
+    if (value.is_null()) {
+        out += '\xC0';
+    } else if (value.is_bool()) {
+        out += value.as_bool() ? '\xC3' : '\xC2';
+    } else if (value.is_integer()) {
+        put_msgpack_integer(out, value.as_integer());
+    } else if (value.is_number()) {
+        out += '\xCB';
+        put_big_endian(out, double_bits(value.as_number()), 8);
+    } else if (value.is_string()) {
+        std::string_view s = value.as_string();
+        put_msgpack_size(out, s.size(), 0xA0, 32, 0xD9, 0xDA, 0xDB);
+        out.append(s);
+    } else if (value.is_array()) {
+        const JsonValue::Array &array = value.as_array();
+        put_msgpack_size(out, array.size(), 0x90, 16, 0, 0xDC, 0xDD);
+        for (const JsonValue &element : array) {
+            encode_msgpack(element, out);
+        }
+    } else {
+        const JsonValue::Object &object = value.as_object();
+        put_msgpack_size(out, object.size(), 0x80, 16, 0, 0xDE, 0xDF);
+        for (const auto &[key, element] : object) {
+            put_msgpack_size(out, key.size(), 0xA0, 32, 0xD9, 0xDA, 0xDB);
+            out.append(key);
+            encode_msgpack(element, out);
+        }
+    }
+}
+
+JsonValue decode_cbor(std::string_view data) {
+    return CborDecoder(data).decode_document();
+}
+
+void encode_cbor(const JsonValue &value, std::string &out) {
+    if (value.is_null()) {
+        out += '\xF6';
+    } else if (value.is_bool()) {
+        out += value.as_bool() ? '\xF5' : '\xF4';
+    } else if (value.is_integer()) {
+        int64_t n = value.as_integer();
+        if (n >= 0) {
+            put_cbor_head(out, 0, static_cast<uint64_t>(n));
+        } else {
+            put_cbor_head(out, 1, static_cast<uint64_t>(-1 - n));
+        }
+    } else if (value.is_number()) {
+        out += '\xFB';
+        put_big_endian(out, double_bits(value.as_number()), 8);
+    } else if (value.is_string()) {
+        std::string_view s = value.as_string();
+        put_cbor_head(out, 3, s.size());
+        out.append(s);
+    } else if (value.is_array()) {
+        const JsonValue::Array &array = value.as_array();
+        put_cbor_head(out, 4, array.size());
+        for (const JsonValue &element : array) {
+            encode_cbor(element, out);
+        }
+    } else {
+        const JsonValue::Object &object = value.as_object();
+        put_cbor_head(out, 5, object.size());
+        for (const auto &[key, element] : object) {
+            put_cbor_head(out, 3, key.size());
+            out.append(key);
+            encode_cbor(element, out);
+        }
+    }
+}
+
+} // namespace json
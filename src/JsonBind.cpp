@@ -0,0 +1,400 @@
+#include "JsonBind.h"
+#include "JsonDetail.h"
+#include "JsonStructural.h"
+
+namespace json {
+
+namespace {
+
+constexpr size_t kMaxDepth = 1024;
+
+// index[pos] 处的标量 token，去掉尾部空白
+std::string_view scalar_at(std::string_view json,
+                           const std::vector<uint32_t> &index, size_t pos) {
+    json_detail::StructuralCursor cursor(json, index, pos);
+    return cursor.scalar_token();
+}
+
+} // namespace
+
+// 索引缓冲区按线程复用，同一线程同时只能有一个 Reader
+Reader::Reader(std::string_view json) : json_(json) {
+    std::vector<uint32_t> &index = json_detail::thread_index_buffer();
+    try {
+        build_structural_index(json, index);
+    } catch (const std::runtime_error &e) {
+        error_ = e.what();
+        index.assign(1, static_cast<uint32_t>(json.size()));
+    }
+    index_ = &index;
+}
+
+Reader::~Reader() { json_detail::trim_thread_index_buffer(); }
+
+char Reader::peek() const {
+    return pos_ + 1 >= index_->size() ? '\0' : json_[(*index_)[pos_]];
+}
+
+bool Reader::fail(const char *expected) {
+    if (error_.empty()) {
+        size_t offset = (*index_)[pos_];
+        error_ = std::string("Expected ") + expected + " at offset " +
+                 std::to_string(offset);
+    }
+    return false;
+}
+
+bool Reader::syntax_error(std::string_view what) {
+    if (error_.empty()) {
+        error_ = what;
+    }
+    return false;
+}
+
+bool Reader::read_null() {
+    if (peek() != 'n' || scalar_at(json_, *index_, pos_) != "null") {
+        return fail("null");
+    }
+    pos_++;
+    return true;
+}
+
+bool Reader::read(bool &out) {
+    char c = peek();
+    if (c != 't' && c != 'f') {
+        return fail("bool");
+    }
+    std::string_view token = scalar_at(json_, *index_, pos_);
+    if (token != "true" && token != "false") {
+        return syntax_error("Expect 'true/false'");
+    }
+    out = c == 't';
+    pos_++;
+    return true;
+}
+
+bool Reader::read(int64_t &out) {
+    char c = peek();
+    if (c != '-' && !json_detail::is_digit(c)) {
+        return fail("integer");
+    }
+    json_detail::NumberValue n;
+    try {
+        n = json_detail::parse_number_token(scalar_at(json_, *index_, pos_));
+    } catch (const std::runtime_error &e) {
+        return syntax_error(e.what());
+    }
+    if (!n.is_integer) {
+        return fail("integer");
+    }
+    out = n.integer;
+    pos_++;
+    return true;
+}
+
+bool Reader::read(double &out) {
+    char c = peek();
+    if (c != '-' && !json_detail::is_digit(c)) {
+        return fail("number");
+    }
+    try {
+        out = json_detail::parse_number_token(scalar_at(json_, *index_, pos_))
+                  .number;
+    } catch (const std::runtime_error &e) {
+        return syntax_error(e.what());
+    }
+    pos_++;
+    return true;
+}
+
+bool Reader::read(std::string &out) {
+    if (peek() != '"') {
+        return fail("string");
+    }
+    json_detail::StructuralCursor cursor(json_, *index_, pos_);
+    try {
+        bool has_escape = false;
+        std::string_view raw = cursor.string_token(has_escape);
+        if (has_escape) {
+            out.resize(raw.size());
+            out.resize(json_detail::decode_escapes(raw, out.data()));
+        } else {
+            out.assign(raw);
+        }
+    } catch (const std::runtime_error &e) {
+        return syntax_error(e.what());
+    }
+    pos_ = cursor.offset(*index_);
+    return true;
+}
+
+bool Reader::begin_object() {
+    if (peek() != '{') {
+        return fail("object");
+    }
+    pos_++;
+    return true;
+}
+
+bool Reader::next_key(std::string_view &key, bool &first) {
+    char c = peek();
+    if (c == '}') {
+        pos_++;
+        return false;
+    }
+    if (!first) {
+        if (c != ',') {
+            return syntax_error("Expected ',' or '}' in object");
+        }
+        pos_++;
+        c = peek();
+    }
+    first = false;
+    if (c != '"') {
+        return syntax_error("Expected '\"' at start of object key");
+    }
+
+    json_detail::StructuralCursor cursor(json_, *index_, pos_);
+    try {
+        bool has_escape = false;
+        key = cursor.string_token(has_escape);
+        if (has_escape) {
+            scratch_.resize(key.size());
+            scratch_.resize(json_detail::decode_escapes(key, scratch_.data()));
+            key = scratch_;
+        }
+    } catch (const std::runtime_error &e) {
+        return syntax_error(e.what());
+    }
+    pos_ = cursor.offset(*index_);
+
+    if (peek() != ':') {
+        return syntax_error("Expected ':' after object key");
+    }
+    pos_++;
+    return true;
+}
+
+bool Reader::begin_array() {
+    if (peek() != '[') {
+        return fail("array");
+    }
+    pos_++;
+    return true;
+}
+
+bool Reader::next_element(bool &first) {
+    char c = peek();
+    if (c == ']') {
+        pos_++;
+        return false;
+    }
+    if (!first) {
+        if (c != ',') {
+            return syntax_error("Expected ',' or ']' in array");
+        }
+        pos_++;
+    }
+    first = false;
+    return true;
+}
+
+bool Reader::skip_value() { return skip_value(0); }
+
+// 跳过的值同样完整校验语法，只是不保存结果
+bool Reader::skip_value(size_t depth) {
+    char c = peek();
+    switch (c) {
+    case '\0':
+        return syntax_error("Unexpected end of JSON input");
+    case '"': {
+        json_detail::StructuralCursor cursor(json_, *index_, pos_);
+        try {
+            bool has_escape = false;
+            std::string_view raw = cursor.string_token(has_escape);
+            if (has_escape) {
+                scratch_.resize(raw.size());
+                json_detail::decode_escapes(raw, scratch_.data());
+            }
+        } catch (const std::runtime_error &e) {
+            return syntax_error(e.what());
+        }
+        pos_ = cursor.offset(*index_);
+        return true;
+    }
+    case 't':
+    case 'f':
+    case 'n': {
+        std::string_view literal = c == 't'   ? "true"
+                                   : c == 'f' ? "false"
+                                              : "null";
+        if (scalar_at(json_, *index_, pos_) != literal) {
+            return syntax_error("Expect '" + std::string(literal) + "'");
+        }
+        pos_++;
+        return true;
+    }
+    case '{':
+    case '[':
+        break;
+    default:
+        if (c != '-' && !json_detail::is_digit(c)) {
+            return syntax_error("Unexpected character: " + std::string(1, c));
+        }
+        try {
+            json_detail::parse_number_token(scalar_at(json_, *index_, pos_));
+        } catch (const std::runtime_error &e) {
+            return syntax_error(e.what());
+        }
+        pos_++;
+        return true;
+    }
+
+    if (++depth > kMaxDepth) {
+        return syntax_error("JSON nesting too deep");
+    }
+    bool first = true;
+    if (c == '[') {
+        begin_array();
+        while (next_element(first)) {
+            if (!skip_value(depth)) {
+                return false;
+            }
+        }
+    } else {
+        begin_object();
+        std::string_view key;
+        while (next_key(key, first)) {
+            if (!skip_value(depth)) {
+                return false;
+            }
+        }
+    }
+    return ok();
+}
+
+bool Reader::finish() {
+    if (pos_ + 1 < index_->size()) {
+        return syntax_error("Unexpected content after JSON value");
+    }
+    return true;
+}
+
+char ValueReader::peek() const {
+    if (!current_) {
+        return '\0';
+    }
+    const JsonValue &v = *current_;
+    if (v.is_null()) {
+        return 'n';
+    }
+    if (v.is_bool()) {
+        return v.as_bool() ? 't' : 'f';
+    }
+    if (v.is_number()) {
+        return '0';
+    }
+    if (v.is_string()) {
+        return '"';
+    }
+    return v.is_array() ? '[' : '{';
+}
+
+bool ValueReader::fail(const char *expected) {
+    if (error_.empty()) {
+        error_ = std::string("Expected ") + expected;
+    }
+    return false;
+}
+
+bool ValueReader::read_null() {
+    if (!current_ || !current_->is_null()) {
+        return fail("null");
+    }
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::read(bool &out) {
+    if (!current_ || !current_->is_bool()) {
+        return fail("bool");
+    }
+    out = current_->as_bool();
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::read(int64_t &out) {
+    if (!current_ || !current_->is_integer()) {
+        return fail("integer");
+    }
+    out = current_->as_integer();
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::read(double &out) {
+    if (!current_ || !current_->is_number()) {
+        return fail("number");
+    }
+    out = current_->as_number();
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::read(std::string &out) {
+    if (!current_ || !current_->is_string()) {
+        return fail("string");
+    }
+    out.assign(current_->as_string());
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::begin_object() {
+    if (!current_ || !current_->is_object()) {
+        return fail("object");
+    }
+    frames_.push_back(Frame{current_, 0, current_->as_object().begin()});
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::next_key(std::string_view &key, bool &) {
+    Frame &frame = frames_.back();
+    if (frame.member == frame.container->as_object().end()) {
+        frames_.pop_back();
+        return false;
+    }
+    key = frame.member->first;
+    current_ = &frame.member->second;
+    ++frame.member;
+    return true;
+}
+
+bool ValueReader::begin_array() {
+    if (!current_ || !current_->is_array()) {
+        return fail("array");
+    }
+    frames_.push_back(Frame{current_, 0, {}});
+    current_ = nullptr;
+    return true;
+}
+
+bool ValueReader::next_element(bool &) {
+    Frame &frame = frames_.back();
+    const JsonValue::Array &array = frame.container->as_array();
+    if (frame.index == array.size()) {
+        frames_.pop_back();
+        return false;
+    }
+    current_ = &array[frame.index++];
+    return true;
+}
+
+bool ValueReader::skip_value() {
+    current_ = nullptr;
+    return true;
+}
+
+} // namespace json
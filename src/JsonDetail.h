@@ -0,0 +1,309 @@
+#ifndef JSON_DETAIL_H
+#define JSON_DETAIL_H
+
+// JSON 解析器共用的内部工具，不对外暴露
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json_detail {
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// 校验数字语法，返回数字之后的位置
+inline const char *scan_number(const char *p, const char *end) {
+    if (p < end && *p == '-') {
+        p++;
+    }
+    if (p < end && *p == '0') {
+        p++;
+        if (p < end && is_digit(*p)) {
+            throw std::runtime_error("Leading zero in number is not allowed");
+        }
+    } else if (p < end && is_digit(*p)) {
+        while (p < end && is_digit(*p)) {
+            p++;
+        }
+    } else {
+        throw std::runtime_error("Invalid number format");
+    }
+
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || !is_digit(*p)) {
+            throw std::runtime_error(
+                "Invalid number format after decimal point");
+        }
+        while (p < end && is_digit(*p)) {
+            p++;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) {
+            p++;
+        }
+        if (p >= end || !is_digit(*p)) {
+            throw std::runtime_error("Invalid number format in exponent");
+        }
+        while (p < end && is_digit(*p)) {
+            p++;
+        }
+    }
+    return p;
+}
+
+// 数字 token 的值：没有小数和指数部分且在 int64 范围内时为整数
+struct NumberValue {
+    bool is_integer;
+    int64_t integer;
+    double number;
+};
+
+// 校验并转换完整的数字 token，全程不分配内存，不依赖 locale。
+// "-0" 按浮点 -0.0 处理以保留符号；超出 double 范围时抛出异常
+inline NumberValue parse_number_token(std::string_view token) {
+    const char *begin = token.data();
+    const char *end = begin + token.size();
+    const char *stop = scan_number(begin, end);
+    if (stop != end) {
+        throw std::runtime_error("Unexpected character: " +
+                                 std::string(1, *stop));
+    }
+
+    NumberValue result{false, 0, 0};
+    bool integral = token.find_first_of(".eE") == std::string_view::npos;
+    if (integral) {
+        auto [ptr, ec] = std::from_chars(begin, end, result.integer);
+        if (ec == std::errc() && !(result.integer == 0 && *begin == '-')) {
+            result.is_integer = true;
+            result.number = static_cast<double>(result.integer);
+            return result;
+        }
+    }
+
+    auto [ptr, ec] = std::from_chars(begin, end, result.number);
+    if (ec != std::errc()) {
+        throw std::runtime_error("Invalid number: " + std::string(token));
+    }
+    return result;
+}
+
+inline uint32_t parse_hex4(const char *p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            throw std::runtime_error("Invalid Unicode escape");
+        }
+        value = value << 4 | digit;
+    }
+    return value;
+}
+
+inline size_t encode_utf8(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | cp >> 6);
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | cp >> 12);
+        out[1] = static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | cp >> 18);
+    out[1] = static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+    out[2] = static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// 解码字符串中的转义序列，out 至少需要 raw.size() 字节，返回解码后的长度。
+// \uXXXX 解码为 UTF-8（代理对合并为一个码点），解码结果不会比原文长
+inline size_t decode_escapes(std::string_view raw, char *out) {
+    const char *p = raw.data();
+    const char *end = p + raw.size();
+    char *o = out;
+
+    while (true) {
+        // 两个转义之间的部分整段复制
+        const char *slash =
+            static_cast<const char *>(std::memchr(p, '\\', end - p));
+        const char *run_end = slash ? slash : end;
+        std::memcpy(o, p, run_end - p);
+        o += run_end - p;
+        if (!slash) {
+            break;
+        }
+
+        p = slash + 1;
+        if (p >= end) {
+            throw std::runtime_error(
+                "Unexpected end of string after escape character");
+        }
+        char c = *p++;
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            *o++ = c;
+            break;
+        case 'b':
+            *o++ = '\b';
+            break;
+        case 'f':
+            *o++ = '\f';
+            break;
+        case 'n':
+            *o++ = '\n';
+            break;
+        case 'r':
+            *o++ = '\r';
+            break;
+        case 't':
+            *o++ = '\t';
+            break;
+        case 'u': {
+            if (end - p < 4) {
+                throw std::runtime_error(
+                    "Unexpected end of string after Unicode escape");
+            }
+            uint32_t cp = parse_hex4(p);
+            p += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                // 高代理项之后必须紧跟一个低代理项
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+                    throw std::runtime_error("Invalid Unicode surrogate pair");
+                }
+                uint32_t low = parse_hex4(p + 2);
+                if (low < 0xDC00 || low > 0xDFFF) {
+                    throw std::runtime_error("Invalid Unicode surrogate pair");
+                }
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                throw std::runtime_error("Invalid Unicode surrogate pair");
+            }
+            o += encode_utf8(cp, o);
+            break;
+        }
+        default:
+            throw std::runtime_error("Invalid escape sequence: \\" +
+                                     std::string(1, c));
+        }
+    }
+    return static_cast<size_t>(o - out);
+}
+
+// 第二阶段沿结构索引前进的游标
+// 索引以输入长度作为哨兵结尾，peek() 在末尾返回 '\0'
+class StructuralCursor {
+  public:
+    StructuralCursor(std::string_view json, const std::vector<uint32_t> &index)
+        : json_(json), pos_(index.data()),
+          last_(index.data() + index.size() - 1) {}
+
+    // 从索引中间的某个位置开始
+    StructuralCursor(std::string_view json, const std::vector<uint32_t> &index,
+                     size_t at)
+        : json_(json), pos_(index.data() + at),
+          last_(index.data() + index.size() - 1) {}
+
+    // 当前位置在索引中的下标
+    size_t offset(const std::vector<uint32_t> &index) const {
+        return static_cast<size_t>(pos_ - index.data());
+    }
+
+    bool at_end() const { return pos_ == last_; }
+
+    char peek() const { return at_end() ? '\0' : json_[*pos_]; }
+
+    void advance() { pos_++; }
+
+    // 当前字符串 token 的原始内容（不含引号），并前进到下一个 token
+    // 闭引号与下一个结构字符之间只可能有空白，因此可以直接反向定位
+    std::string_view string_token(bool &has_escape) {
+        size_t open = *pos_;
+        size_t close = pos_[1];
+        while (close > open + 1 && is_space(json_[close - 1])) {
+            close--;
+        }
+        close--;
+        if (close <= open || json_[close] != '"') {
+            throw std::runtime_error("Expected '\"' at end of string");
+        }
+        pos_++;
+
+        std::string_view raw = json_.substr(open + 1, close - open - 1);
+        has_escape = std::memchr(raw.data(), '\\', raw.size()) != nullptr;
+        return raw;
+    }
+
+    // 当前标量 token（数字或字面量），去掉尾部空白，并前进到下一个 token
+    std::string_view scalar_token() {
+        size_t begin = *pos_;
+        size_t end = pos_[1];
+        while (end > begin && is_space(json_[end - 1])) {
+            end--;
+        }
+        pos_++;
+        return json_.substr(begin, end - begin);
+    }
+
+  private:
+    std::string_view json_;
+    const uint32_t *pos_;
+    const uint32_t *last_;
+};
+
+// 索引缓冲区按线程复用，避免每次解析重新分配
+inline std::vector<uint32_t> &thread_index_buffer() {
+    thread_local std::vector<uint32_t> index;
+    return index;
+}
+
+// 解析结束后保留的最大索引容量（1 MB），超大输入的索引用完即释放，
+// 不在每个解析过它的线程里一直占着
+constexpr size_t kMaxRetainedIndex = 256 * 1024;
+
+inline void trim_thread_index_buffer() {
+    std::vector<uint32_t> &index = thread_index_buffer();
+    if (index.capacity() > kMaxRetainedIndex) {
+        std::vector<uint32_t>().swap(index);
+    }
+}
+
+// 离开作用域时（包括抛出异常）调用 trim_thread_index_buffer()
+struct ThreadIndexTrim {
+    ThreadIndexTrim() = default;
+    ThreadIndexTrim(const ThreadIndexTrim &) = delete;
+    ThreadIndexTrim &operator=(const ThreadIndexTrim &) = delete;
+    ~ThreadIndexTrim() { trim_thread_index_buffer(); }
+};
+
+} // namespace json_detail
+
+#endif
@@ -0,0 +1,308 @@
+#include "JsonDocument.h"
+#include "JsonDetail.h"
+#include "JsonStructural.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMaxDepth = 1024;
+
+} // namespace
+
+// 第二阶段：沿结构索引构建节点
+// 元素先压入可复用的临时栈，容器结束时整体拷入 arena
+class JsonDocumentParser {
+  public:
+    JsonDocumentParser(json_detail::StructuralCursor &cursor, Arena &arena)
+        : cursor_(cursor), arena_(arena) {}
+
+    JsonNode parse_document() {
+        JsonNode root = parse_value();
+        if (!cursor_.at_end()) {
+            throw std::runtime_error("Unexpected content after JSON value");
+        }
+        return root;
+    }
+
+  private:
+    JsonNode parse_value() {
+        switch (cursor_.peek()) {
+        case '"':
+            return parse_string();
+        case 't':
+            return parse_literal("true", JsonNode::Type::Bool, true);
+        case 'f':
+            return parse_literal("false", JsonNode::Type::Bool, false);
+        case 'n':
+            return parse_literal("null", JsonNode::Type::Null, false);
+        case '[':
+            return parse_array();
+        case '{':
+            return parse_object();
+        case '\0':
+            if (cursor_.at_end()) {
+                throw std::runtime_error("Unexpected end of JSON input");
+            }
+            [[fallthrough]];
+        default: {
+            char c = cursor_.peek();
+            if (c == '-' || json_detail::is_digit(c)) {
+                return parse_number();
+            }
+            throw std::runtime_error("Unexpected character: " +
+                                     std::string(1, c));
+        }
+        }
+    }
+
+    JsonNode parse_literal(std::string_view literal, JsonNode::Type type,
+                           bool value) {
+        if (cursor_.scalar_token() != literal) {
+            throw std::runtime_error("Expect '" + std::string(literal) + "'");
+        }
+
+        JsonNode node;
+        node.type_ = type;
+        node.boolean_ = value;
+        return node;
+    }
+
+    JsonNode parse_number() {
+        json_detail::NumberValue n =
+            json_detail::parse_number_token(cursor_.scalar_token());
+        JsonNode node;
+        node.type_ = JsonNode::Type::Number;
+        node.integral_ = n.is_integer;
+        if (n.is_integer) {
+            node.integer_ = n.integer;
+        } else {
+            node.number_ = n.number;
+        }
+        return node;
+    }
+
+    // 没有转义时直接引用输入，否则解码到 arena（解码后不会变长）
+    JsonNode parse_string() {
+        bool has_escape = false;
+        std::string_view value = cursor_.string_token(has_escape);
+        if (has_escape) {
+            char *out = arena_.allocate_array<char>(value.size());
+            value = std::string_view(
+                out, json_detail::decode_escapes(value, out));
+        }
+
+        JsonNode node;
+        node.type_ = JsonNode::Type::String;
+        node.string_ = value.data();
+        node.size_ = static_cast<uint32_t>(value.size());
+        return node;
+    }
+
+    void enter() {
+        if (++depth_ > kMaxDepth) {
+            throw std::runtime_error("JSON nesting too deep");
+        }
+    }
+
+    JsonNode parse_array() {
+        enter();
+        cursor_.advance();
+
+        size_t mark = elements_.size();
+        if (cursor_.peek() == ']') {
+            cursor_.advance();
+        } else {
+            while (true) {
+                elements_.push_back(parse_value());
+                char c = cursor_.peek();
+                cursor_.advance();
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
+                    throw std::runtime_error("Expected ',' or ']' in array");
+                }
+            }
+        }
+
+        JsonNode node;
+        node.type_ = JsonNode::Type::Array;
+        node.size_ = static_cast<uint32_t>(elements_.size() - mark);
+        JsonNode *elements = arena_.allocate_array<JsonNode>(node.size_);
+        std::copy(elements_.begin() + mark, elements_.end(), elements);
+        elements_.resize(mark);
+        node.elements_ = elements;
+
+        depth_--;
+        return node;
+    }
+
+    JsonNode parse_object() {
+        enter();
+        cursor_.advance();
+
+        size_t mark = members_.size();
+        if (cursor_.peek() == '}') {
+            cursor_.advance();
+        } else {
+            while (true) {
+                if (cursor_.peek() != '"') {
+                    throw std::runtime_error(
+                        "Expected '\"' at start of object key");
+                }
+                JsonNode key = parse_string();
+
+                if (cursor_.peek() != ':') {
+                    throw std::runtime_error("Expected ':' after object key");
+                }
+                cursor_.advance();
+
+                JsonNode value = parse_value();
+                members_.push_back({key.as_string(), value});
+
+                char c = cursor_.peek();
+                cursor_.advance();
+                if (c == '}') {
+                    break;
+                }
+                if (c != ',') {
+                    throw std::runtime_error("Expected ',' or '}' in object");
+                }
+            }
+        }
+
+        JsonNode node;
+        node.type_ = JsonNode::Type::Object;
+        node.size_ = static_cast<uint32_t>(members_.size() - mark);
+        JsonMember *members = arena_.allocate_array<JsonMember>(node.size_);
+        std::copy(members_.begin() + mark, members_.end(), members);
+        members_.resize(mark);
+        node.members_ = members;
+
+        depth_--;
+        return node;
+    }
+
+    json_detail::StructuralCursor &cursor_;
+    Arena &arena_;
+    size_t depth_ = 0;
+
+    std::vector<JsonNode> elements_;
+    std::vector<JsonMember> members_;
+};
+
+JsonDocument::JsonDocument(size_t input_size)
+    : arena_(std::max<size_t>(input_size, 4096)) {}
+
+JsonDocument JsonDocument::parse(std::string_view json) {
+    std::vector<uint32_t> &index = json_detail::thread_index_buffer();
+    json_detail::ThreadIndexTrim trim;
+    json::build_structural_index(json, index);
+
+    JsonDocument doc(json.size());
+    json_detail::StructuralCursor cursor(json, index);
+    doc.root_ = JsonDocumentParser(cursor, doc.arena_).parse_document();
+    return doc;
+}
+
+bool JsonNode::as_bool() const {
+    if (type_ != Type::Bool) {
+        throw std::runtime_error("JSON value is not a bool");
+    }
+    return boolean_;
+}
+
+double JsonNode::as_number() const {
+    if (type_ != Type::Number) {
+        throw std::runtime_error("JSON value is not a number");
+    }
+    return integral_ ? static_cast<double>(integer_) : number_;
+}
+
+int64_t JsonNode::as_integer() const {
+    if (!is_integer()) {
+        throw std::runtime_error("JSON value is not an integer");
+    }
+    return integer_;
+}
+
+std::string_view JsonNode::as_string() const {
+    if (type_ != Type::String) {
+        throw std::runtime_error("JSON value is not a string");
+    }
+    return std::string_view(string_, size_);
+}
+
+const JsonNode *JsonNode::begin() const {
+    return type_ == Type::Array ? elements_ : nullptr;
+}
+
+const JsonNode *JsonNode::end() const {
+    return type_ == Type::Array ? elements_ + size_ : nullptr;
+}
+
+const JsonNode &JsonNode::operator[](size_t index) const {
+    if (type_ != Type::Array || index >= size_) {
+        throw std::out_of_range("JSON array index out of range");
+    }
+    return elements_[index];
+}
+
+const JsonMember *JsonNode::members_begin() const {
+    return type_ == Type::Object ? members_ : nullptr;
+}
+
+const JsonMember *JsonNode::members_end() const {
+    return type_ == Type::Object ? members_ + size_ : nullptr;
+}
+
+const JsonNode *JsonNode::find(std::string_view key) const {
+    for (const JsonMember *m = members_begin(); m != members_end(); m++) {
+        if (m->key == key) {
+            return &m->value;
+        }
+    }
+    return nullptr;
+}
+
+const JsonNode &JsonNode::at(std::string_view key) const {
+    const JsonNode *node = find(key);
+    if (!node) {
+        throw std::out_of_range("JSON object has no key: " + std::string(key));
+    }
+    return *node;
+}
+
+JsonValue JsonNode::to_value() const {
+    switch (type_) {
+    case Type::Null:
+        return JsonValue(nullptr);
+    case Type::Bool:
+        return JsonValue(boolean_);
+    case Type::Number:
+        return integral_ ? JsonValue(integer_) : JsonValue(number_);
+    case Type::String:
+        return JsonValue(std::string(string_, size_));
+    case Type::Array: {
+        JsonValue::Array array;
+        array.reserve(size_);
+        for (const JsonNode &element : *this) {
+            array.push_back(element.to_value());
+        }
+        return JsonValue(std::move(array));
+    }
+    case Type::Object: {
+        JsonValue::Object object;
+        for (const JsonMember *m = members_begin(); m != members_end(); m++) {
+            object.insert_or_assign(std::string(m->key), m->value.to_value());
+        }
+        return JsonValue(std::move(object));
+    }
+    }
+    return JsonValue();
+}
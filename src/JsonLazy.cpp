@@ -0,0 +1,401 @@
+#include "JsonLazy.h"
+#include "JsonDetail.h"
+#include "JsonStructural.h"
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kMaxDepth = 1024;
+
+} // namespace
+
+// 沿结构索引完整校验一遍语法，同时记录每个容器的配对位置；
+// 只检查标量的语法，不转换数字，不保存解码后的字符串
+class JsonLazyValidator {
+  public:
+    explicit JsonLazyValidator(JsonLazyDocument &doc)
+        : doc_(doc), cursor_(doc.json_, doc.index_) {}
+
+    void validate_document() {
+        validate_value();
+        if (!cursor_.at_end()) {
+            throw std::runtime_error("Unexpected content after JSON value");
+        }
+    }
+
+  private:
+    void validate_value() {
+        switch (cursor_.peek()) {
+        case '"':
+            validate_string();
+            return;
+        case '[':
+            validate_array();
+            return;
+        case '{':
+            validate_object();
+            return;
+        case 't':
+        case 'f': {
+            std::string_view token = cursor_.scalar_token();
+            if (token != "true" && token != "false") {
+                throw std::runtime_error("Expect 'true/false'");
+            }
+            return;
+        }
+        case 'n':
+            if (cursor_.scalar_token() != "null") {
+                throw std::runtime_error("Expect 'null'");
+            }
+            return;
+        case '\0':
+            if (cursor_.at_end()) {
+                throw std::runtime_error("Unexpected end of JSON input");
+            }
+            [[fallthrough]];
+        default: {
+            char c = cursor_.peek();
+            if (c != '-' && !json_detail::is_digit(c)) {
+                throw std::runtime_error("Unexpected character: " +
+                                         std::string(1, c));
+            }
+            std::string_view token = cursor_.scalar_token();
+            const char *end = token.data() + token.size();
+            const char *stop = json_detail::scan_number(token.data(), end);
+            if (stop != end) {
+                throw std::runtime_error("Unexpected character: " +
+                                         std::string(1, *stop));
+            }
+            return;
+        }
+        }
+    }
+
+    // 有转义时试解码一次，保证之后访问不会再遇到语法错误
+    void validate_string() {
+        bool has_escape = false;
+        std::string_view raw = cursor_.string_token(has_escape);
+        if (has_escape) {
+            scratch_.resize(raw.size());
+            json_detail::decode_escapes(raw, scratch_.data());
+        }
+    }
+
+    void enter() {
+        if (++depth_ > kMaxDepth) {
+            throw std::runtime_error("JSON nesting too deep");
+        }
+    }
+
+    void validate_array() {
+        enter();
+        size_t open = cursor_.offset(doc_.index_);
+        cursor_.advance();
+
+        if (cursor_.peek() != ']') {
+            while (true) {
+                validate_value();
+                char c = cursor_.peek();
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
+                    throw std::runtime_error("Expected ',' or ']' in array");
+                }
+                cursor_.advance();
+            }
+        }
+
+        close_container(open);
+        depth_--;
+    }
+
+    void validate_object() {
+        enter();
+        size_t open = cursor_.offset(doc_.index_);
+        cursor_.advance();
+
+        if (cursor_.peek() != '}') {
+            while (true) {
+                if (cursor_.peek() != '"') {
+                    throw std::runtime_error(
+                        "Expected '\"' at start of object key");
+                }
+                validate_string();
+
+                if (cursor_.peek() != ':') {
+                    throw std::runtime_error("Expected ':' after object key");
+                }
+                cursor_.advance();
+
+                validate_value();
+                char c = cursor_.peek();
+                if (c == '}') {
+                    break;
+                }
+                if (c != ',') {
+                    throw std::runtime_error("Expected ',' or '}' in object");
+                }
+                cursor_.advance();
+            }
+        }
+
+        close_container(open);
+        depth_--;
+    }
+
+    // 当前位置是 open 配对的结束符
+    void close_container(size_t open) {
+        doc_.close_[open] =
+            static_cast<uint32_t>(cursor_.offset(doc_.index_));
+        cursor_.advance();
+    }
+
+    JsonLazyDocument &doc_;
+    json_detail::StructuralCursor cursor_;
+    size_t depth_ = 0;
+    std::string scratch_;
+};
+
+JsonLazyDocument JsonLazyDocument::parse(std::string_view json) {
+    JsonLazyDocument doc;
+    doc.json_ = json;
+    json::build_structural_index(json, doc.index_);
+    doc.close_.assign(doc.index_.size(), 0);
+    JsonLazyValidator(doc).validate_document();
+    return doc;
+}
+
+char JsonLazyValue::first_char() const {
+    return doc_->json_[doc_->index_[at_]];
+}
+
+uint32_t JsonLazyValue::skip() const {
+    char c = first_char();
+    return c == '{' || c == '[' ? doc_->close_[at_] + 1 : at_ + 1;
+}
+
+JsonLazyValue::Type JsonLazyValue::type() const {
+    switch (first_char()) {
+    case '"':
+        return Type::String;
+    case '{':
+        return Type::Object;
+    case '[':
+        return Type::Array;
+    case 't':
+    case 'f':
+        return Type::Bool;
+    case 'n':
+        return Type::Null;
+    default:
+        return Type::Number;
+    }
+}
+
+std::string_view JsonLazyValue::raw_string(bool &has_escape) const {
+    json_detail::StructuralCursor cursor(doc_->json_, doc_->index_, at_);
+    return cursor.string_token(has_escape);
+}
+
+bool JsonLazyValue::as_bool() const {
+    if (!is_bool()) {
+        throw std::runtime_error("JSON value is not a bool");
+    }
+    return first_char() == 't';
+}
+
+double JsonLazyValue::as_number() const {
+    if (!is_number()) {
+        throw std::runtime_error("JSON value is not a number");
+    }
+    json_detail::StructuralCursor cursor(doc_->json_, doc_->index_, at_);
+    return json_detail::parse_number_token(cursor.scalar_token()).number;
+}
+
+int64_t JsonLazyValue::as_integer() const {
+    if (!is_number()) {
+        throw std::runtime_error("JSON value is not a number");
+    }
+    json_detail::StructuralCursor cursor(doc_->json_, doc_->index_, at_);
+    json_detail::NumberValue n =
+        json_detail::parse_number_token(cursor.scalar_token());
+    if (!n.is_integer) {
+        throw std::runtime_error("JSON value is not an integer");
+    }
+    return n.integer;
+}
+
+std::string JsonLazyValue::as_string() const {
+    if (!is_string()) {
+        throw std::runtime_error("JSON value is not a string");
+    }
+    bool has_escape = false;
+    std::string_view raw = raw_string(has_escape);
+    if (!has_escape) {
+        return std::string(raw);
+    }
+    std::string result(raw.size(), '\0');
+    result.resize(json_detail::decode_escapes(raw, result.data()));
+    return result;
+}
+
+size_t JsonLazyValue::size() const {
+    Type t = type();
+    if (t != Type::Array && t != Type::Object) {
+        return 0;
+    }
+
+    // 对象成员占 键、':'、值 三个位置，之后是 ',' 或结束符
+    uint32_t end = doc_->close_[at_];
+    uint32_t k = at_ + 1;
+    size_t count = 0;
+    while (k < end) {
+        JsonLazyValue element(doc_, t == Type::Object ? k + 2 : k);
+        k = element.skip() + 1;
+        count++;
+    }
+    return count;
+}
+
+std::optional<JsonLazyValue> JsonLazyValue::find(size_t index) const {
+    if (!is_array()) {
+        return std::nullopt;
+    }
+    uint32_t end = doc_->close_[at_];
+    uint32_t k = at_ + 1;
+    for (size_t i = 0; k < end; i++) {
+        JsonLazyValue element(doc_, k);
+        if (i == index) {
+            return element;
+        }
+        k = element.skip() + 1;
+    }
+    return std::nullopt;
+}
+
+std::optional<JsonLazyValue> JsonLazyValue::find(std::string_view key) const {
+    if (!is_object()) {
+        return std::nullopt;
+    }
+
+    std::string decoded;
+    uint32_t end = doc_->close_[at_];
+    uint32_t k = at_ + 1;
+    while (k < end) {
+        JsonLazyValue name(doc_, k);
+        JsonLazyValue value(doc_, k + 2);
+
+        bool has_escape = false;
+        std::string_view raw = name.raw_string(has_escape);
+        if (has_escape) {
+            decoded.resize(raw.size());
+            decoded.resize(json_detail::decode_escapes(raw, decoded.data()));
+            raw = decoded;
+        }
+        if (raw == key) {
+            return value;
+        }
+        k = value.skip() + 1;
+    }
+    return std::nullopt;
+}
+
+JsonLazyValue JsonLazyValue::at(size_t index) const {
+    std::optional<JsonLazyValue> value = find(index);
+    if (!value) {
+        throw std::out_of_range("JSON array index out of range");
+    }
+    return *value;
+}
+
+JsonLazyValue JsonLazyValue::at(std::string_view key) const {
+    std::optional<JsonLazyValue> value = find(key);
+    if (!value) {
+        throw std::out_of_range("JSON object has no key: " + std::string(key));
+    }
+    return *value;
+}
+
+std::optional<JsonLazyValue>
+JsonLazyValue::find_pointer(std::string_view pointer) const {
+    // 先校验整个指针，格式错误不应因为路径提前不存在而被掩盖
+    bool valid = pointer.empty() || pointer.front() == '/';
+    for (size_t i = 0; valid && i < pointer.size(); i++) {
+        if (pointer[i] == '~') {
+            valid = i + 1 < pointer.size() &&
+                    (pointer[i + 1] == '0' || pointer[i + 1] == '1');
+        }
+    }
+    if (!valid) {
+        throw std::runtime_error("Invalid JSON pointer: " +
+                                 std::string(pointer));
+    }
+
+    JsonLazyValue current = *this;
+    std::string unescaped;
+    while (!pointer.empty()) {
+        pointer.remove_prefix(1);
+        size_t slash = pointer.find('/');
+        std::string_view token = pointer.substr(0, slash);
+        pointer = slash == std::string_view::npos ? std::string_view()
+                                                  : pointer.substr(slash);
+
+        // ~1 表示 '/'，~0 表示 '~'
+        if (token.find('~') != std::string_view::npos) {
+            unescaped.clear();
+            for (size_t i = 0; i < token.size(); i++) {
+                if (token[i] == '~') {
+                    unescaped += token[++i] == '0' ? '~' : '/';
+                } else {
+                    unescaped += token[i];
+                }
+            }
+            token = unescaped;
+        }
+
+        std::optional<JsonLazyValue> next;
+        if (current.is_object()) {
+            next = current.find(token);
+        } else if (current.is_array()) {
+            // 数组下标只允许十进制数字，且不能有前导零
+            size_t index = 0;
+            auto [ptr, ec] = std::from_chars(
+                token.data(), token.data() + token.size(), index);
+            if (ec != std::errc() || ptr != token.data() + token.size() ||
+                (token.size() > 1 && token.front() == '0')) {
+                return std::nullopt;
+            }
+            next = current.find(index);
+        }
+        if (!next) {
+            return std::nullopt;
+        }
+        current = *next;
+    }
+    return current;
+}
+
+JsonLazyValue JsonLazyValue::at_pointer(std::string_view pointer) const {
+    std::optional<JsonLazyValue> value = find_pointer(pointer);
+    if (!value) {
+        throw std::out_of_range("JSON pointer not found: " +
+                                std::string(pointer));
+    }
+    return *value;
+}
+
+std::string_view JsonLazyValue::raw_json() const {
+    const std::string_view json = doc_->json_;
+    size_t begin = doc_->index_[at_];
+    size_t end = doc_->index_[skip()];
+    while (end > begin && json_detail::is_space(json[end - 1])) {
+        end--;
+    }
+    return json.substr(begin, end - begin);
+}
+
+JsonValue JsonLazyValue::to_value() const {
+    return JsonValue::parse(raw_json());
+}
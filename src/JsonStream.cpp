@@ -0,0 +1,509 @@
+#include "JsonStream.h"
+#include "JsonDetail.h"
+#include "JsonStructural.h"
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMaxDepth = 1024;
+
+inline bool is_scalar_char(char c) {
+    return json_detail::is_digit(c) || (c >= 'a' && c <= 'z') || c == '-' ||
+           c == '+' || c == '.' || c == 'E';
+}
+
+} // namespace
+
+void JsonStreamParser::reset() {
+    state_ = State::Value;
+    token_ = Token::None;
+    is_key_ = false;
+    escape_pending_ = false;
+    has_escape_ = false;
+    stack_.clear();
+    partial_.clear();
+}
+
+void JsonStreamParser::feed(std::string_view chunk) {
+    size_t i = 0;
+    const size_t n = chunk.size();
+
+    while (i < n) {
+        if (token_ == Token::String) {
+            i = continue_string(chunk, i);
+            continue;
+        }
+        if (token_ != Token::None) {
+            i = continue_scalar(chunk, i);
+            continue;
+        }
+
+        char c = chunk[i];
+        if (json_detail::is_space(c)) {
+            i++;
+            continue;
+        }
+
+        switch (state_) {
+        case State::Done:
+            throw JsonParseError("Unexpected content after JSON value");
+
+        case State::FirstValueOrEnd:
+            if (c == ']') {
+                close_container();
+                i++;
+                break;
+            }
+            [[fallthrough]];
+        case State::Value:
+            i = begin_value(chunk, i);
+            break;
+
+        case State::FirstKeyOrEnd:
+            if (c == '}') {
+                close_container();
+                i++;
+                break;
+            }
+            [[fallthrough]];
+        case State::Key:
+            if (c != '"') {
+                throw JsonParseError("Expected '\"' at start of object key");
+            }
+            token_ = Token::String;
+            is_key_ = true;
+            i++;
+            break;
+
+        case State::Colon:
+            if (c != ':') {
+                throw JsonParseError("Expected ':' after object key");
+            }
+            state_ = State::Value;
+            i++;
+            break;
+
+        case State::CommaOrEnd: {
+            bool in_object = stack_.back() == '{';
+            if (c == ',') {
+                state_ = in_object ? State::Key : State::Value;
+            } else if (c == (in_object ? '}' : ']')) {
+                close_container();
+            } else {
+                throw JsonParseError(in_object
+                                         ? "Expected ',' or '}' in object"
+                                         : "Expected ',' or ']' in array");
+            }
+            i++;
+            break;
+        }
+        }
+    }
+}
+
+void JsonStreamParser::finish() {
+    // 顶层的数字或字面量只能由输入结束来终止
+    if (token_ == Token::Number || token_ == Token::Literal) {
+        token_ = Token::None;
+        finish_scalar(partial_);
+        partial_.clear();
+    }
+    if (state_ != State::Done) {
+        throw JsonParseError("Unexpected end of JSON input");
+    }
+}
+
+size_t JsonStreamParser::begin_value(std::string_view chunk, size_t i) {
+    char c = chunk[i];
+    switch (c) {
+    case '{':
+    case '[':
+        open_container(c);
+        return i + 1;
+    case '"':
+        token_ = Token::String;
+        is_key_ = false;
+        return i + 1;
+    case 't':
+    case 'f':
+    case 'n':
+        token_ = Token::Literal;
+        return continue_scalar(chunk, i);
+    default:
+        if (c == '-' || json_detail::is_digit(c)) {
+            token_ = Token::Number;
+            return continue_scalar(chunk, i);
+        }
+        throw JsonParseError("Unexpected character: " + std::string(1, c));
+    }
+}
+
+// 从 i 开始继续扫描字符串，返回下一个未处理的位置
+size_t JsonStreamParser::continue_string(std::string_view chunk, size_t i) {
+    const size_t start = i;
+    const size_t n = chunk.size();
+
+    if (escape_pending_) {
+        escape_pending_ = false;
+        i++;
+    }
+    while (i < n) {
+        char c = chunk[i];
+        if (c == '"') {
+            break;
+        }
+        if (c == '\\') {
+            has_escape_ = true;
+            if (i + 1 == n) {
+                escape_pending_ = true;
+            }
+            i += 2;
+            continue;
+        }
+        i++;
+    }
+
+    if (i >= n) {
+        // 字符串在本段内没有结束，暂存已收到的部分
+        buffer(chunk.substr(start));
+        return n;
+    }
+
+    // 整个字符串都在本段内时直接引用输入
+    if (partial_.empty()) {
+        finish_string(chunk.substr(start, i - start));
+    } else {
+        buffer(chunk.substr(start, i - start));
+        finish_string(partial_);
+        partial_.clear();
+    }
+    return i + 1;
+}
+
+// 数字与字面量在遇到非标量字符时结束
+size_t JsonStreamParser::continue_scalar(std::string_view chunk, size_t i) {
+    const size_t start = i;
+    const size_t n = chunk.size();
+    while (i < n && is_scalar_char(chunk[i])) {
+        i++;
+    }
+
+    if (i == n) {
+        buffer(chunk.substr(start));
+        return n;
+    }
+
+    token_ = Token::None;
+    if (partial_.empty()) {
+        finish_scalar(chunk.substr(start, i - start));
+    } else {
+        buffer(chunk.substr(start, i - start));
+        finish_scalar(partial_);
+        partial_.clear();
+    }
+    return i;
+}
+
+void JsonStreamParser::buffer(std::string_view piece) {
+    if (partial_.size() + piece.size() > max_token_) {
+        throw JsonParseError("JSON token is too long");
+    }
+    partial_.append(piece);
+}
+
+void JsonStreamParser::finish_string(std::string_view raw) {
+    token_ = Token::None;
+    // 多字节字符可能被切在两段之间，只能在字符串完整后校验
+    if (!json::validate_utf8(raw)) {
+        throw JsonParseError("Invalid UTF-8 in JSON string");
+    }
+    if (has_escape_) {
+        has_escape_ = false;
+        decoded_.resize(raw.size());
+        try {
+            decoded_.resize(
+                json_detail::decode_escapes(raw, decoded_.data()));
+        } catch (const std::runtime_error &e) {
+            throw JsonParseError(e.what());
+        }
+        raw = decoded_;
+    }
+
+    if (is_key_) {
+        is_key_ = false;
+        handler_.on_key(raw);
+        state_ = State::Colon;
+    } else {
+        handler_.on_string(raw);
+        after_value();
+    }
+}
+
+void JsonStreamParser::finish_scalar(std::string_view token) {
+    switch (token.empty() ? '\0' : token.front()) {
+    case 't':
+    case 'f':
+        if (token != "true" && token != "false") {
+            throw JsonParseError("Expect 'true/false'");
+        }
+        handler_.on_bool(token == "true");
+        break;
+    case 'n':
+        if (token != "null") {
+            throw JsonParseError("Expect 'null'");
+        }
+        handler_.on_null();
+        break;
+    default: {
+        json_detail::NumberValue n;
+        try {
+            n = json_detail::parse_number_token(token);
+        } catch (const std::runtime_error &e) {
+            throw JsonParseError(e.what());
+        }
+        if (n.is_integer) {
+            handler_.on_integer(n.integer);
+        } else {
+            handler_.on_number(n.number);
+        }
+        break;
+    }
+    }
+    after_value();
+}
+
+void JsonStreamParser::open_container(char c) {
+    if (stack_.size() >= kMaxDepth) {
+        throw JsonParseError("JSON nesting too deep");
+    }
+    stack_.push_back(c);
+    if (c == '{') {
+        handler_.on_begin_object();
+        state_ = State::FirstKeyOrEnd;
+    } else {
+        handler_.on_begin_array();
+        state_ = State::FirstValueOrEnd;
+    }
+}
+
+void JsonStreamParser::close_container() {
+    char c = stack_.back();
+    stack_.pop_back();
+    if (c == '{') {
+        handler_.on_end_object();
+    } else {
+        handler_.on_end_array();
+    }
+    after_value();
+}
+
+void JsonStreamParser::after_value() {
+    state_ = stack_.empty() ? State::Done : State::CommaOrEnd;
+}
+
+void JsonElementReader::on_begin_object() {
+    frames_.push_back(Frame{true, {}, {}, {}});
+}
+
+void JsonElementReader::on_end_object() {
+    JsonValue value(std::move(frames_.back().object));
+    frames_.pop_back();
+    add(std::move(value));
+}
+
+void JsonElementReader::on_begin_array() {
+    // 顶层数组本身不构建，只作为元素的容器
+    if (frames_.empty() && !top_level_array_ && count_ == 0) {
+        top_level_array_ = true;
+        return;
+    }
+    frames_.push_back(Frame{false, {}, {}, {}});
+}
+
+void JsonElementReader::on_end_array() {
+    if (frames_.empty()) {
+        return;
+    }
+    JsonValue value(std::move(frames_.back().array));
+    frames_.pop_back();
+    add(std::move(value));
+}
+
+void JsonElementReader::add(JsonValue &&value) {
+    if (frames_.empty()) {
+        count_++;
+        callback_(value);
+        return;
+    }
+
+    Frame &frame = frames_.back();
+    if (frame.is_object) {
+        frame.object.insert_or_assign(std::move(frame.key), std::move(value));
+    } else {
+        frame.array.push_back(std::move(value));
+    }
+}
+
+void JsonElementSplitter::feed(std::string_view chunk) {
+    size_t start = 0; // 当前元素在本段中的起点
+    const size_t n = chunk.size();
+
+    for (size_t i = 0; i < n; i++) {
+        char c = chunk[i];
+        if (state_ != State::Element) {
+            if (json_detail::is_space(c)) {
+                continue;
+            }
+            switch (state_) {
+            case State::Start:
+                if (c == '[') {
+                    top_level_array_ = true;
+                    state_ = State::FirstElementOrEnd;
+                    continue;
+                }
+                // 顶层不是数组，整个输入是唯一的元素
+                break;
+            case State::FirstElementOrEnd:
+                if (c == ']') {
+                    state_ = State::Done;
+                    continue;
+                }
+                [[fallthrough]];
+            case State::NextElement:
+                if (c == ',' || c == ']') {
+                    throw JsonParseError("Unexpected character: " +
+                                         std::string(1, c));
+                }
+                break;
+            default:
+                throw JsonParseError("Unexpected content after JSON value");
+            }
+            state_ = State::Element;
+            start = i;
+            depth_ = 0;
+        }
+
+        if (in_string_) {
+            if (escape_) {
+                escape_ = false;
+            } else if (c == '\\') {
+                escape_ = true;
+            } else if (c == '"') {
+                in_string_ = false;
+            }
+            continue;
+        }
+        switch (c) {
+        case '"':
+            in_string_ = true;
+            break;
+        case '{':
+        case '[':
+            depth_++;
+            break;
+        case '}':
+        case ']':
+            if (depth_ > 0) {
+                depth_--;
+            } else if (top_level_array_ && c == ']') {
+                emit(chunk.substr(start, i - start));
+                state_ = State::Done;
+            } else {
+                throw JsonParseError("Unexpected character: " +
+                                     std::string(1, c));
+            }
+            break;
+        case ',':
+            if (depth_ == 0 && top_level_array_) {
+                emit(chunk.substr(start, i - start));
+                state_ = State::NextElement;
+            }
+            break;
+        }
+    }
+
+    if (state_ == State::Element) {
+        buffer(chunk.substr(start));
+    }
+}
+
+void JsonElementSplitter::finish() {
+    // 顶层不是数组时只能由输入结束来终止
+    if (state_ == State::Element && !top_level_array_ && !in_string_ &&
+        depth_ == 0) {
+        emit({});
+        state_ = State::Done;
+    }
+    if (state_ != State::Done) {
+        throw JsonParseError("Unexpected end of JSON input");
+    }
+}
+
+void JsonElementSplitter::emit(std::string_view tail) {
+    if (partial_.empty()) {
+        count_++;
+        callback_(tail);
+        return;
+    }
+    buffer(tail);
+    count_++;
+    callback_(partial_);
+    partial_.clear();
+}
+
+void JsonElementSplitter::buffer(std::string_view piece) {
+    if (partial_.size() + piece.size() > max_element_) {
+        throw JsonParseError("Element " + std::to_string(count_ + 1) +
+                             " is too long");
+    }
+    partial_.append(piece);
+}
+
+void JsonLineSplitter::feed(std::string_view chunk) {
+    while (!chunk.empty()) {
+        const void *found = std::memchr(chunk.data(), '\n', chunk.size());
+        if (!found) {
+            break;
+        }
+        size_t end = static_cast<const char *>(found) - chunk.data();
+        if (partial_.empty()) {
+            emit(chunk.substr(0, end));
+        } else {
+            partial_.append(chunk.data(), end);
+            emit(partial_);
+            partial_.clear();
+        }
+        chunk.remove_prefix(end + 1);
+    }
+
+    if (partial_.size() + chunk.size() > max_line_) {
+        throw JsonParseError("Line " + std::to_string(line_ + 1) +
+                             " is too long");
+    }
+    partial_.append(chunk);
+}
+
+void JsonLineSplitter::finish() {
+    if (!partial_.empty()) {
+        emit(partial_);
+        partial_.clear();
+    }
+}
+
+void JsonLineSplitter::emit(std::string_view line) {
+    line_++;
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    if (line.size() > max_line_) {
+        throw JsonParseError("Line " + std::to_string(line_) +
+                             " is too long");
+    }
+    for (char c : line) {
+        if (!json_detail::is_space(c)) {
+            count_++;
+            callback_(line, line_);
+            return;
+        }
+    }
+}
@@ -0,0 +1,389 @@
+#include "JsonStructural.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JSON_STRUCTURAL_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define JSON_STRUCTURAL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace json {
+
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+// 一个 64 字节块中各类字符的位图，第 i 位对应块内第 i 个字节
+struct BlockMasks {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t space;
+    uint64_t op; // { } [ ] : ,
+};
+
+enum : uint8_t {
+    kBackslash = 1,
+    kQuote = 2,
+    kSpace = 4,
+    kOp = 8,
+};
+
+constexpr std::array<uint8_t, 256> make_classes() {
+    std::array<uint8_t, 256> classes{};
+    classes['\\'] = kBackslash;
+    classes['"'] = kQuote;
+    classes[' '] = kSpace;
+    classes['\t'] = kSpace;
+    classes['\n'] = kSpace;
+    classes['\r'] = kSpace;
+    classes['{'] = kOp;
+    classes['}'] = kOp;
+    classes['['] = kOp;
+    classes[']'] = kOp;
+    classes[':'] = kOp;
+    classes[','] = kOp;
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> kClasses = make_classes();
+
+struct ScalarKernel {
+    static BlockMasks classify(const char *p) {
+        BlockMasks m{};
+        for (size_t i = 0; i < kBlockSize; i++) {
+            uint8_t c = kClasses[static_cast<uint8_t>(p[i])];
+            uint64_t bit = uint64_t(1) << i;
+            m.backslash |= (c & kBackslash) ? bit : 0;
+            m.quote |= (c & kQuote) ? bit : 0;
+            m.space |= (c & kSpace) ? bit : 0;
+            m.op |= (c & kOp) ? bit : 0;
+        }
+        return m;
+    }
+};
+
+#if defined(JSON_STRUCTURAL_X86)
+
+// '[' ']' 与 '{' '}' 只差 0x20 位，按位或 0x20 后两次比较即可覆盖四个括号
+struct Sse2Kernel {
+    static BlockMasks classify(const char *p) {
+        BlockMasks m{};
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i lf = _mm_set1_epi8('\n');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lower = _mm_set1_epi8(0x20);
+        const __m128i open = _mm_set1_epi8('{');
+        const __m128i close = _mm_set1_epi8('}');
+        const __m128i colon = _mm_set1_epi8(':');
+        const __m128i comma = _mm_set1_epi8(',');
+
+        for (int i = 0; i < 4; i++) {
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(p + i * 16));
+            __m128i folded = _mm_or_si128(v, lower);
+            __m128i ws = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+            __m128i op = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(folded, open),
+                             _mm_cmpeq_epi8(folded, close)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, colon),
+                             _mm_cmpeq_epi8(v, comma)));
+
+            int shift = i * 16;
+            m.backslash |= uint64_t(uint16_t(_mm_movemask_epi8(
+                               _mm_cmpeq_epi8(v, backslash))))
+                           << shift;
+            m.quote |=
+                uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote))))
+                << shift;
+            m.space |= uint64_t(uint16_t(_mm_movemask_epi8(ws))) << shift;
+            m.op |= uint64_t(uint16_t(_mm_movemask_epi8(op))) << shift;
+        }
+        return m;
+    }
+};
+
+struct Avx2Kernel {
+    __attribute__((target("avx2"))) static BlockMasks classify(const char *p) {
+        BlockMasks m{};
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i lf = _mm256_set1_epi8('\n');
+        const __m256i cr = _mm256_set1_epi8('\r');
+        const __m256i lower = _mm256_set1_epi8(0x20);
+        const __m256i open = _mm256_set1_epi8('{');
+        const __m256i close = _mm256_set1_epi8('}');
+        const __m256i colon = _mm256_set1_epi8(':');
+        const __m256i comma = _mm256_set1_epi8(',');
+
+        for (int i = 0; i < 2; i++) {
+            __m256i v = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(p + i * 32));
+            __m256i folded = _mm256_or_si256(v, lower);
+            __m256i ws = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                                _mm256_cmpeq_epi8(v, tab)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, lf),
+                                _mm256_cmpeq_epi8(v, cr)));
+            __m256i op = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(folded, open),
+                                _mm256_cmpeq_epi8(folded, close)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, colon),
+                                _mm256_cmpeq_epi8(v, comma)));
+
+            int shift = i * 32;
+            m.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(
+                               _mm256_cmpeq_epi8(v, backslash))))
+                           << shift;
+            m.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(
+                           _mm256_cmpeq_epi8(v, quote))))
+                       << shift;
+            m.space |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << shift;
+            m.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << shift;
+        }
+        return m;
+    }
+};
+
+#elif defined(JSON_STRUCTURAL_NEON)
+
+struct NeonKernel {
+    // 四个 16 字节比较结果压缩成一个 64 位掩码
+    static uint64_t movemask(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2,
+                             uint8x16_t m3) {
+        const uint8x16_t bits = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20,
+                                 0x40, 0x80, 0x01, 0x02, 0x04, 0x08,
+                                 0x10, 0x20, 0x40, 0x80};
+        uint8x16_t s0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+        uint8x16_t s1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+        s0 = vpaddq_u8(s0, s1);
+        s0 = vpaddq_u8(s0, s0);
+        return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+    }
+
+    static BlockMasks classify(const char *p) {
+        uint8x16_t v[4];
+        for (int i = 0; i < 4; i++) {
+            v[i] = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i * 16));
+        }
+
+        uint8x16_t backslash[4], quote[4], ws[4], op[4];
+        for (int i = 0; i < 4; i++) {
+            uint8x16_t folded = vorrq_u8(v[i], vdupq_n_u8(0x20));
+            backslash[i] = vceqq_u8(v[i], vdupq_n_u8('\\'));
+            quote[i] = vceqq_u8(v[i], vdupq_n_u8('"'));
+            ws[i] = vorrq_u8(vorrq_u8(vceqq_u8(v[i], vdupq_n_u8(' ')),
+                                      vceqq_u8(v[i], vdupq_n_u8('\t'))),
+                             vorrq_u8(vceqq_u8(v[i], vdupq_n_u8('\n')),
+                                      vceqq_u8(v[i], vdupq_n_u8('\r'))));
+            op[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')),
+                                      vceqq_u8(folded, vdupq_n_u8('}'))),
+                             vorrq_u8(vceqq_u8(v[i], vdupq_n_u8(':')),
+                                      vceqq_u8(v[i], vdupq_n_u8(','))));
+        }
+
+        BlockMasks m;
+        m.backslash =
+            movemask(backslash[0], backslash[1], backslash[2], backslash[3]);
+        m.quote = movemask(quote[0], quote[1], quote[2], quote[3]);
+        m.space = movemask(ws[0], ws[1], ws[2], ws[3]);
+        m.op = movemask(op[0], op[1], op[2], op[3]);
+        return m;
+    }
+};
+
+#endif
+
+// 每个 1 位之后（含）到下一个 1 位之前的区域置 1
+uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// 块之间需要延续的状态
+struct Carry {
+    uint64_t escaped = 0;   // 上一块最后一个字节是未被转义的反斜杠
+    uint64_t in_string = 0; // 全 1 表示上一块结束时仍在字符串内
+    uint64_t scalar = 0;    // 上一块最后一个字节属于标量
+};
+
+// 被反斜杠转义的字符位图；反斜杠很少出现，逐位处理即可
+uint64_t escaped_bits(uint64_t backslash, Carry &carry) {
+    uint64_t escaped = carry.escaped;
+    carry.escaped = 0;
+    while (backslash) {
+        uint64_t bit = backslash & (~backslash + 1);
+        backslash ^= bit;
+        if (escaped & bit) {
+            continue;
+        }
+        uint64_t next = bit << 1;
+        if (next == 0) {
+            carry.escaped = 1;
+        } else {
+            escaped |= next;
+            backslash &= ~next;
+        }
+    }
+    return escaped;
+}
+
+void flatten(uint64_t bits, uint32_t base, std::vector<uint32_t> &out) {
+    while (bits) {
+        out.push_back(base + static_cast<uint32_t>(__builtin_ctzll(bits)));
+        bits &= bits - 1;
+    }
+}
+
+uint64_t structurals(const BlockMasks &m, Carry &carry) {
+    uint64_t escaped = escaped_bits(m.backslash, carry);
+    uint64_t quote = m.quote & ~escaped;
+
+    // in_string 覆盖开引号到闭引号之前，string_tail 覆盖开引号之后到闭引号
+    uint64_t in_string = prefix_xor(quote) ^ carry.in_string;
+    carry.in_string =
+        static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    uint64_t string_tail = in_string ^ quote;
+
+    uint64_t op = m.op & ~in_string;
+    uint64_t scalar = ~(op | m.space) & ~string_tail;
+    uint64_t follows_scalar = (scalar << 1) | carry.scalar;
+    carry.scalar = scalar >> 63;
+
+    return op | (scalar & ~follows_scalar);
+}
+
+// 校验 [from, to) 的 UTF-8，to 向前退到码点边界，返回实际校验到的位置
+size_t validate_range(std::string_view json, size_t from, size_t to,
+                      SimdLevel level) {
+    while (to > from && to < json.size() &&
+           (static_cast<uint8_t>(json[to]) & 0xC0) == 0x80) {
+        to--;
+    }
+    if (!validate_utf8(json.substr(from, to - from), level)) {
+        throw std::runtime_error("Invalid UTF-8 in JSON input");
+    }
+    return to;
+}
+
+template <typename Kernel>
+void index_blocks(std::string_view json, std::vector<uint32_t> &out,
+                  SimdLevel level) {
+    // 每处理一段就校验这一段的 UTF-8，数据仍在缓存中，省去第二遍读内存
+    constexpr size_t kValidateStride = 16 * 1024;
+
+    Carry carry;
+    const char *data = json.data();
+    size_t full = json.size() - json.size() % kBlockSize;
+    size_t validated = 0;
+
+    for (size_t i = 0; i < full; i += kBlockSize) {
+        flatten(structurals(Kernel::classify(data + i), carry),
+                static_cast<uint32_t>(i), out);
+        if ((i + kBlockSize) % kValidateStride == 0) {
+            validated = validate_range(json, validated, i + kBlockSize, level);
+        }
+    }
+
+    if (full < json.size()) {
+        // 最后不足一块的部分用空白补齐
+        char tail[kBlockSize];
+        std::memset(tail, ' ', kBlockSize);
+        std::memcpy(tail, data + full, json.size() - full);
+        flatten(structurals(Kernel::classify(tail), carry),
+                static_cast<uint32_t>(full), out);
+    }
+
+    if (carry.in_string) {
+        throw std::runtime_error("Expected '\"' at end of string");
+    }
+
+    // 字符串外只允许 ASCII，整体校验即相当于校验了所有字符串的原始字节
+    validate_range(json, validated, json.size(), level);
+}
+
+} // namespace
+
+SimdLevel best_simd_level() {
+#if defined(JSON_STRUCTURAL_X86)
+    static const SimdLevel level = __builtin_cpu_supports("avx2")
+                                       ? SimdLevel::AVX2
+                                       : SimdLevel::SSE2;
+    return level;
+#elif defined(JSON_STRUCTURAL_NEON)
+    return SimdLevel::NEON;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char *simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE2:
+        return "sse2";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::NEON:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}
+
+void build_structural_index(std::string_view json,
+                            std::vector<uint32_t> &positions) {
+    build_structural_index(json, positions, best_simd_level());
+}
+
+void build_structural_index(std::string_view json,
+                            std::vector<uint32_t> &positions,
+                            SimdLevel level) {
+    if (json.size() >= UINT32_MAX) {
+        throw std::runtime_error("JSON input too large");
+    }
+
+    positions.clear();
+    // 经验值：结构字符大约占输入的 1/6
+    positions.reserve(json.size() / 6 + 2);
+
+    switch (level) {
+#if defined(JSON_STRUCTURAL_X86)
+    case SimdLevel::AVX2:
+        if (__builtin_cpu_supports("avx2")) {
+            index_blocks<Avx2Kernel>(json, positions, level);
+            break;
+        }
+        [[fallthrough]];
+    case SimdLevel::SSE2:
+        index_blocks<Sse2Kernel>(json, positions, level);
+        break;
+#elif defined(JSON_STRUCTURAL_NEON)
+    case SimdLevel::NEON:
+        index_blocks<NeonKernel>(json, positions, level);
+        break;
+#endif
+    default:
+        index_blocks<ScalarKernel>(json, positions, level);
+        break;
+    }
+
+    positions.push_back(static_cast<uint32_t>(json.size()));
+}
+
+} // namespace json
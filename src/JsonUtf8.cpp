@@ -0,0 +1,255 @@
+#include "JsonStructural.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JSON_UTF8_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define JSON_UTF8_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace json {
+
+namespace {
+
+// 校验从 p 开始的一个非 ASCII 码点，返回其长度，无效时返回 0
+size_t validate_code_point(const uint8_t *p, size_t n) {
+    auto cont = [](uint8_t c) { return (c & 0xC0) == 0x80; };
+    uint8_t c0 = p[0];
+
+    if (c0 >= 0xC2 && c0 <= 0xDF) {
+        return n >= 2 && cont(p[1]) ? 2 : 0;
+    }
+    if (c0 >= 0xE0 && c0 <= 0xEF) {
+        if (n < 3 || !cont(p[2])) {
+            return 0;
+        }
+        // E0 后不能是过长编码，ED 后不能是代理项
+        uint8_t lo = c0 == 0xE0 ? 0xA0 : 0x80;
+        uint8_t hi = c0 == 0xED ? 0x9F : 0xBF;
+        return p[1] >= lo && p[1] <= hi ? 3 : 0;
+    }
+    if (c0 >= 0xF0 && c0 <= 0xF4) {
+        if (n < 4 || !cont(p[2]) || !cont(p[3])) {
+            return 0;
+        }
+        // F0 后不能是过长编码，F4 后不能超过 U+10FFFF
+        uint8_t lo = c0 == 0xF0 ? 0x90 : 0x80;
+        uint8_t hi = c0 == 0xF4 ? 0x8F : 0xBF;
+        return p[1] >= lo && p[1] <= hi ? 4 : 0;
+    }
+    return 0;
+}
+
+// 开头连续 ASCII 字节的个数
+size_t ascii_prefix(const uint8_t *p, size_t n, SimdLevel level) {
+    size_t i = 0;
+#if defined(JSON_UTF8_X86)
+    if (level != SimdLevel::Scalar) {
+        for (; i + 16 <= n; i += 16) {
+            int mask = _mm_movemask_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)));
+            if (mask) {
+                return i + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+        }
+    }
+#elif defined(JSON_UTF8_NEON)
+    if (level != SimdLevel::Scalar) {
+        for (; i + 16 <= n; i += 16) {
+            if (vmaxvq_u8(vld1q_u8(p + i)) >= 0x80) {
+                break;
+            }
+        }
+    }
+#else
+    (void)level;
+#endif
+    // 一次检查 8 字节
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        if (word & 0x8080808080808080ull) {
+            break;
+        }
+    }
+    while (i < n && p[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+// 跳过 ASCII 段，逐个校验非 ASCII 码点
+bool validate_scalar(const uint8_t *p, size_t n, SimdLevel level) {
+    size_t i = 0;
+    while (true) {
+        i += ascii_prefix(p + i, n - i, level);
+        if (i == n) {
+            return true;
+        }
+        size_t length = validate_code_point(p + i, n - i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+}
+
+#if defined(JSON_UTF8_X86)
+
+// 查表法（Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction
+// Per Byte"）：用相邻两个字节的三个半字节查表，三张表按位与后非零即为错误；
+// 多字节序列的第 3、4 字节另行检查
+namespace avx2 {
+
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+__attribute__((target("avx2"))) inline __m256i
+table(uint8_t t0, uint8_t t1, uint8_t t2, uint8_t t3, uint8_t t4, uint8_t t5,
+      uint8_t t6, uint8_t t7, uint8_t t8, uint8_t t9, uint8_t t10,
+      uint8_t t11, uint8_t t12, uint8_t t13, uint8_t t14, uint8_t t15) {
+    return _mm256_setr_epi8(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11,
+                            t12, t13, t14, t15, t0, t1, t2, t3, t4, t5, t6, t7,
+                            t8, t9, t10, t11, t12, t13, t14, t15);
+}
+
+// input 之前 n 个字节组成的向量，跨越 128 位通道和上一块
+template <int N>
+__attribute__((target("avx2"))) inline __m256i prev(__m256i input,
+                                                    __m256i prev_input) {
+    return _mm256_alignr_epi8(
+        input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+}
+
+__attribute__((target("avx2"))) inline __m256i high_nibble(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+__attribute__((target("avx2"))) inline __m256i
+check_block(__m256i input, __m256i prev_input) {
+    __m256i prev1 = prev<1>(input, prev_input);
+
+    __m256i byte_1_high = _mm256_shuffle_epi8(
+        table(kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+              kTooLong, kTooLong, kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+              kTooShort | kOverlong2, kTooShort,
+              kTooShort | kOverlong3 | kSurrogate,
+              kTooShort | kTooLarge | kTooLarge1000 | kOverlong4),
+        high_nibble(prev1));
+
+    __m256i byte_1_low = _mm256_shuffle_epi8(
+        table(kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+              kCarry | kOverlong2, kCarry, kCarry, kCarry | kTooLarge,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+              kCarry | kTooLarge | kTooLarge1000,
+              kCarry | kTooLarge | kTooLarge1000),
+        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+
+    __m256i byte_2_high = _mm256_shuffle_epi8(
+        table(kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+              kTooShort, kTooShort, kTooShort,
+              kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+                  kOverlong4,
+              kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+              kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+              kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+              kTooShort, kTooShort, kTooShort, kTooShort),
+        high_nibble(input));
+
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // 前两/三个字节是 3/4 字节序列的首字节时，当前字节必须是后续字节
+    __m256i third = _mm256_subs_epu8(prev<2>(input, prev_input),
+                                     _mm256_set1_epi8(char(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev<3>(input, prev_input),
+                                      _mm256_set1_epi8(char(0xF0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                      _mm256_set1_epi8(char(0x80)));
+    return _mm256_xor_si256(must23, special);
+}
+
+// 块末尾是未完成的多字节序列时非零
+__attribute__((target("avx2"))) inline __m256i incomplete(__m256i input) {
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1),
+        char(0xE0 - 1), char(0xC0 - 1));
+    return _mm256_subs_epu8(input, max_value);
+}
+
+struct State {
+    __m256i error;
+    __m256i prev_input;
+    __m256i prev_incomplete;
+};
+
+__attribute__((target("avx2"))) inline void step(State &s, __m256i input) {
+    if (_mm256_movemask_epi8(input) == 0) {
+        // 纯 ASCII 块只需确认上一块没有截断的序列
+        s.error = _mm256_or_si256(s.error, s.prev_incomplete);
+    } else {
+        s.error = _mm256_or_si256(s.error, check_block(input, s.prev_input));
+        s.prev_incomplete = incomplete(input);
+    }
+    s.prev_input = input;
+}
+
+__attribute__((target("avx2"))) bool validate(const uint8_t *p, size_t n) {
+    State s{_mm256_setzero_si256(), _mm256_setzero_si256(),
+            _mm256_setzero_si256()};
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        step(s, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)));
+    }
+    if (i < n) {
+        // 末尾不足一块的部分补 0（ASCII）
+        uint8_t tail[32] = {};
+        std::memcpy(tail, p + i, n - i);
+        step(s, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail)));
+    }
+    __m256i error = _mm256_or_si256(s.error, s.prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+} // namespace avx2
+
+#endif
+
+} // namespace
+
+bool validate_utf8(std::string_view data) {
+    return validate_utf8(data, best_simd_level());
+}
+
+bool validate_utf8(std::string_view data, SimdLevel level) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data.data());
+#if defined(JSON_UTF8_X86)
+    if (level == SimdLevel::AVX2 && __builtin_cpu_supports("avx2")) {
+        return avx2::validate(p, data.size());
+    }
+#endif
+    return validate_scalar(p, data.size(), level);
+}
+
+} // namespace json
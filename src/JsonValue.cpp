@@ -1,279 +1,281 @@
 #include "JsonValue.h"
-#include <cctype>
+#include "JsonDetail.h"
+#include "JsonStructural.h"
+#include "JsonWriter.h"
 #include <cstddef>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
-JsonValue JsonValue::parse(const String &json) {
-
-    size_t index = 0;
-    JsonValue result = parse_value(json, index);
-
-    skip_whitespace(json, index);
-
-    if (index < json.size())
-        throw std::runtime_error("Unexpected content after JSON value");
-
-    return result;
-}
-
-JsonValue JsonValue::parse_value(const String &json, size_t &index) {
-    skip_whitespace(json, index);
-
-    if (index >= json.size()) {
-        throw std::runtime_error("Unexpected end of JSON input");
+namespace {
+
+constexpr size_t kMaxDepth = 1024;
+
+// 第二阶段：沿结构索引递归构建 JsonValue
+class ValueBuilder {
+  public:
+    explicit ValueBuilder(json_detail::StructuralCursor &cursor)
+        : cursor_(cursor) {}
+
+    JsonValue parse_value() {
+        switch (cursor_.peek()) {
+        case '"':
+            return parse_string();
+        case '[':
+            return parse_array();
+        case '{':
+            return parse_object();
+        case 't':
+            return parse_literal("true", JsonValue(true));
+        case 'f':
+            return parse_literal("false", JsonValue(false));
+        case 'n':
+            return parse_literal("null", JsonValue(nullptr));
+        case '\0':
+            if (cursor_.at_end()) {
+                throw std::runtime_error("Unexpected end of JSON input");
+            }
+            [[fallthrough]];
+        default: {
+            char c = cursor_.peek();
+            if (c == '-' || json_detail::is_digit(c)) {
+                return parse_number();
+            }
+            throw std::runtime_error("Unexpected character: " +
+                                     std::string(1, c));
+        }
+        }
     }
 
-    char c = json[index];
-    switch (c) {
-    case '"':
-        return parse_string(json, index);
-    case 't':
-    case 'f':
-        return parse_bool(json, index);
-    case '[':
-        return parse_array(json, index);
-    case '{':
-        return parse_object(json, index);
-    case 'n':
-        return parse_null(json, index);
-    default:
-        if (c == '-' || (c >= '0' && c <= '9')) {
-            return parse_number(json, index);
+  private:
+    // 直接与输入中的 token 比较，不产生临时字符串
+    JsonValue parse_literal(std::string_view literal, JsonValue value) {
+        if (cursor_.scalar_token() != literal) {
+            throw std::runtime_error(literal == "null" ? "Expect 'null'"
+                                                       : "Expect 'true/false'");
         }
-        throw std::runtime_error("Unexpected character: " + std::string(1, c));
+        return value;
     }
-}
-
-void JsonValue::skip_whitespace(const String &json, size_t &index) {
 
-    while (index < json.size() &&
-           std::isspace(static_cast<char>(json[index]))) {
-        index++;
+    JsonValue parse_number() {
+        json_detail::NumberValue n =
+            json_detail::parse_number_token(cursor_.scalar_token());
+        return n.is_integer ? JsonValue(n.integer) : JsonValue(n.number);
     }
-}
 
-JsonValue JsonValue::parse_null(const String &json, size_t &index) {
-    if (json.substr(index, 4) == "null") {
-        index += 4;
-        return JsonValue(nullptr);
+    // 短字符串直接存进值内，不经过临时的 std::string
+    JsonValue parse_string() {
+        bool has_escape = false;
+        std::string_view raw = cursor_.string_token(has_escape);
+        if (!has_escape) {
+            return JsonValue(raw);
+        }
+        scratch_.resize(raw.size());
+        size_t size = json_detail::decode_escapes(raw, scratch_.data());
+        return JsonValue(std::string_view(scratch_.data(), size));
     }
 
-    throw std::runtime_error("Expect 'null'");
-}
+    std::string read_string() {
+        bool has_escape = false;
+        std::string_view raw = cursor_.string_token(has_escape);
+        if (!has_escape) {
+            return std::string(raw);
+        }
 
-JsonValue JsonValue::parse_bool(const String &json, size_t &index) {
-    if (json.substr(index, 4) == "true") {
-        index += 4;
-        return JsonValue(true);
+        std::string result(raw.size(), '\0');
+        result.resize(json_detail::decode_escapes(raw, result.data()));
+        return result;
     }
 
-    if (json.substr(index, 5) == "false") {
-        index += 5;
-        return JsonValue(false);
+    void enter() {
+        if (++depth_ > kMaxDepth) {
+            throw std::runtime_error("JSON nesting too deep");
+        }
     }
 
-    throw std::runtime_error("Expect 'true/false'");
-}
+    JsonValue parse_array() {
+        enter();
+        cursor_.advance();
 
-JsonValue JsonValue::parse_number(const std::string &json, size_t &index) {
-    int start = index;
+        JsonValue::Array result;
+        if (cursor_.peek() == ']') {
+            cursor_.advance();
+            depth_--;
+            return JsonValue(std::move(result));
+        }
 
-    if (json[index] == '-') {
-        index++;
-    }
+        while (true) {
+            result.push_back(parse_value());
 
-    if (json[index] == '0') {
-        index++;
-        if (index < json.size() && std::isdigit(json[index])) {
-            throw std::runtime_error("Leading zero in number is not allowed");
-        }
-    } else if (json[index] >= '1' && json[index] <= '9') {
-        index++;
-        while (index < json.size() && isdigit(json[index])) {
-            index++;
+            char c = cursor_.peek();
+            cursor_.advance();
+            if (c == ']') {
+                break;
+            }
+            if (c != ',') {
+                throw std::runtime_error("Expected ',' or ']' in array");
+            }
         }
-    } else {
-        throw std::runtime_error("Invalid number format");
-    }
 
-    bool has_fraction = false;
-    if (index < json.size() && json[index] == '.') {
-        has_fraction = true;
-        index++;
-        if (index >= json.size() || !std::isdigit(json[index])) {
-            throw std::runtime_error(
-                "Invalid number format after decimal point");
-        }
-        while (index < json.size() && std::isdigit(json[index])) {
-            index++;
-        }
+        depth_--;
+        return JsonValue(std::move(result));
     }
 
-    bool has_exponent = false;
-    if (index < json.size() && (json[index] == 'e' || json[index] == 'E')) {
-        has_exponent = true;
-        index++;
-        if (index < json.size() && (json[index] == '+' || json[index] == '-')) {
-            index++;
-        }
-        if (index >= json.size() || !std::isdigit(json[index])) {
-            throw std::runtime_error("Invalid number format in exponent");
+    JsonValue parse_object() {
+        enter();
+        cursor_.advance();
+
+        JsonValue::Object result;
+        if (cursor_.peek() == '}') {
+            cursor_.advance();
+            depth_--;
+            return JsonValue(std::move(result));
         }
-        while (index < json.size() && std::isdigit(json[index])) {
-            index++;
+
+        while (true) {
+            if (cursor_.peek() != '"') {
+                throw std::runtime_error(
+                    "Expected '\"' at start of object key");
+            }
+            std::string key = read_string();
+
+            if (cursor_.peek() != ':') {
+                throw std::runtime_error("Expected ':' after object key");
+            }
+            cursor_.advance();
+
+            // 重复的键以最后一个为准
+            result.insert_or_assign(std::move(key), parse_value());
+
+            char c = cursor_.peek();
+            cursor_.advance();
+            if (c == '}') {
+                break;
+            }
+            if (c != ',') {
+                throw std::runtime_error("Expected ',' or '}' in object");
+            }
         }
+
+        depth_--;
+        return JsonValue(std::move(result));
     }
 
-    std::string num_str = json.substr(start, index - start);
+    json_detail::StructuralCursor &cursor_;
+    size_t depth_ = 0;
+    std::string scratch_;
+};
+
+// 长字符串的堆块：长度之后紧跟字符数据
+char *new_long_string(std::string_view s) {
+    size_t size = s.size();
+    char *block = static_cast<char *>(::operator new(sizeof(size) + size));
+    std::memcpy(block, &size, sizeof(size));
+    std::memcpy(block + sizeof(size), s.data(), size);
+    return block;
+}
 
-    if (num_str == "-0.0" || num_str == "-0") {
-        return JsonValue(-0.0);
-    }
+} // namespace
 
-    try {
-        return JsonValue(std::stod(num_str));
-    } catch (...) {
-        throw std::runtime_error("Invalid number: " + num_str);
-    }
+JsonValue::JsonValue(const Array &a) { set(Tag::Array, new Array(a)); }
+
+JsonValue::JsonValue(Array &&a) {
+    set(Tag::Array, new Array(std::move(a)));
 }
 
-JsonValue JsonValue::parse_string(const std::string &json, size_t &index) {
+JsonValue::JsonValue(const Object &o) { set(Tag::Object, new Object(o)); }
 
-    if (json[index] != '"') {
-        throw std::runtime_error("Expected '\"' at start of string");
-    }
-    index++;
+JsonValue::JsonValue(Object &&o) {
+    set(Tag::Object, new Object(std::move(o)));
+}
 
-    String result;
-    while (index < json.size() && json[index] != '"') {
-        if (json[index] == '\\') {
-            index++;
-            if (index >= json.size()) {
-                throw std::runtime_error(
-                    "Unexpected end of string after escape character");
-            }
-            switch (json[index]) {
-            case '"':
-                result += '"';
-                break;
-            case '\\':
-                result += '\\';
-                break;
-            case '/':
-                result += '/';
-                break;
-            case 'b':
-                result += '\b';
-                break;
-            case 'f':
-                result += '\f';
-                break;
-            case 'n':
-                result += '\n';
-                break;
-            case 'r':
-                result += '\r';
-                break;
-            case 't':
-                result += '\t';
-                break;
-            case 'u':
-                index += 4;
-                if (index >= json.size())
-                    throw std::runtime_error(
-                        "Unexpected end of string after Unicode escape");
-                result += '?';
-                break;
-            default:
-                throw std::runtime_error("Invalid escape sequence: \\" +
-                                         std::string(1, json[index]));
-            }
-        } else {
-            result += json[index];
-        }
-        index++;
-    }
-    if (index >= json.size() || json[index] != '"') {
-        throw std::runtime_error("Expected '\"' at end of string");
+JsonValue::JsonValue(const JsonValue &other) {
+    switch (other.tag()) {
+    case Tag::String:
+        init_string(other.as_string());
+        break;
+    case Tag::Array:
+        set(Tag::Array, new Array(other.as_array()));
+        break;
+    case Tag::Object:
+        set(Tag::Object, new Object(other.as_object()));
+        break;
+    default:
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        break;
     }
-    index++;
-    return JsonValue(result);
 }
 
-JsonValue JsonValue::parse_array(const std::string &json, size_t &index) {
-    if (json[index] != '[') {
-        throw std::runtime_error("Expected '[' at start of array");
+JsonValue &JsonValue::operator=(const JsonValue &other) {
+    if (this != &other) {
+        *this = JsonValue(other);
     }
-    index++;
+    return *this;
+}
 
-    Array result;
-    skip_whitespace(json, index);
+// other 可能是自身的子元素，先取走 other 再释放自身
+JsonValue &JsonValue::operator=(JsonValue &&other) noexcept {
+    unsigned char taken[sizeof(bytes_)];
+    std::memcpy(taken, other.bytes_, sizeof(bytes_));
+    other.set_tag(Tag::Null);
+    release();
+    std::memcpy(bytes_, taken, sizeof(bytes_));
+    return *this;
+}
 
-    if (index < json.size() && json[index] == ']') {
-        index++;
-        return JsonValue(result);
+void JsonValue::release() noexcept {
+    switch (tag()) {
+    case Tag::String:
+        ::operator delete(get<char *>(Tag::String));
+        break;
+    case Tag::Array:
+        delete get<Array *>(Tag::Array);
+        break;
+    case Tag::Object:
+        delete get<Object *>(Tag::Object);
+        break;
+    default:
+        break;
     }
+}
 
-    while (index < json.size()) {
-        result.push_back(parse_value(json, index));
-
-        skip_whitespace(json, index);
-        if (index < json.size() && json[index] == ',') {
-            index++;
-            skip_whitespace(json, index);
-        } else if (index < json.size() && json[index] == ']') {
-            index++;
-            break;
-        } else {
-            throw std::runtime_error("Expected ',' or ']' in array");
-        }
+void JsonValue::init_string(std::string_view s) {
+    if (s.size() <= kSmallCapacity) {
+        std::memcpy(bytes_, s.data(), s.size());
+        bytes_[kSmallSizeByte] = static_cast<unsigned char>(s.size());
+        set_tag(Tag::SmallString);
+    } else {
+        set(Tag::String, new_long_string(s));
     }
-
-    return JsonValue(result);
 }
 
-JsonValue JsonValue::parse_object(const String &json, size_t &index) {
-    if (json[index] != '{') {
-        throw std::runtime_error("Expected '{' at start of object");
+std::string_view JsonValue::as_string() const {
+    if (tag() == Tag::SmallString) {
+        return std::string_view(reinterpret_cast<const char *>(bytes_),
+                                bytes_[kSmallSizeByte]);
     }
-    index++;
+    const char *block = get<char *>(Tag::String);
+    size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    return std::string_view(block + sizeof(size), size);
+}
 
-    Object result;
-    skip_whitespace(json, index);
+JsonValue JsonValue::parse(std::string_view json) {
+    std::vector<uint32_t> &index = json_detail::thread_index_buffer();
+    json_detail::ThreadIndexTrim trim;
+    json::build_structural_index(json, index);
 
-    if (index < json.size() && json[index] == '}') {
-        index++;
-        return JsonValue(result);
-    }
+    json_detail::StructuralCursor cursor(json, index);
+    JsonValue result = ValueBuilder(cursor).parse_value();
 
-    while (index < json.size()) {
+    if (!cursor.at_end())
+        throw std::runtime_error("Unexpected content after JSON value");
 
-        skip_whitespace(json, index);
-        if (index >= json.size() || json[index] != '"') {
-            throw std::runtime_error("Expected '\"' at start of object key");
-        }
-        JsonValue key = parse_string(json, index);
+    return result;
+}
 
-        skip_whitespace(json, index);
-        if (index >= json.size() || json[index] != ':') {
-            throw std::runtime_error("Expected ':' after object key");
-        }
-        index++;
-
-        JsonValue value = parse_value(json, index);
-        result[key.as_string()] = value;
-
-        skip_whitespace(json, index);
-        if (index < json.size() && json[index] == ',') {
-            index++;
-            skip_whitespace(json, index);
-        } else if (index < json.size() && json[index] == '}') {
-            index++;
-            break;
-        } else {
-            throw std::runtime_error("Expected ',' or '}' in object");
-        }
-    }
-    return JsonValue(result);
-}
\ No newline at end of file
+std::string JsonValue::dump(bool pretty) const {
+    std::string out;
+    JsonWriter(out, pretty).write(*this);
+    return out;
+}
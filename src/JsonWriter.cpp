@@ -0,0 +1,337 @@
+#include "JsonWriter.h"
+#include "JsonDocument.h"
+#include "JsonValue.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr char kHex[] = "0123456789abcdef";
+
+// 返回 16 字节块中第一个需要转义的字节（< 0x20、'"'、'\\'）的偏移，
+// 没有时返回 16
+inline size_t first_escape_in_block(const char *p) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // 有符号比较：0x00-0x1f 小于 0x20，0x80 以上的字节是负数需排除
+    __m128i control = _mm_and_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)),
+                                    _mm_cmpgt_epi8(v, _mm_set1_epi8(-1)));
+    __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    unsigned mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_or_si128(control, special)));
+    return mask ? static_cast<size_t>(__builtin_ctz(mask)) : 16;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+    uint8x16_t hit = vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)),
+                              vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                                       vceqq_u8(v, vdupq_n_u8('\\'))));
+    if (vmaxvq_u8(hit) == 0) {
+        return 16;
+    }
+    for (size_t i = 0; i < 16; i++) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        if (c < 0x20 || c == '"' || c == '\\') {
+            return i;
+        }
+    }
+    return 16;
+#else
+    for (size_t i = 0; i < 16; i++) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        if (c < 0x20 || c == '"' || c == '\\') {
+            return i;
+        }
+    }
+    return 16;
+#endif
+}
+
+void append_escape(std::string &out, unsigned char c) {
+    switch (c) {
+    case '"':
+        out.append("\\\"");
+        break;
+    case '\\':
+        out.append("\\\\");
+        break;
+    case '\b':
+        out.append("\\b");
+        break;
+    case '\f':
+        out.append("\\f");
+        break;
+    case '\n':
+        out.append("\\n");
+        break;
+    case '\r':
+        out.append("\\r");
+        break;
+    case '\t':
+        out.append("\\t");
+        break;
+    default: {
+        char u[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]};
+        out.append(u, sizeof(u));
+        break;
+    }
+    }
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(std::string &out, bool pretty)
+    : out_(out), pretty_(pretty) {}
+
+JsonWriter::JsonWriter(Sink sink, bool pretty, size_t buffer_size)
+    : out_(own_buffer_), sink_(std::move(sink)),
+      flush_threshold_(buffer_size), pretty_(pretty) {
+    own_buffer_.reserve(buffer_size + 256);
+}
+
+JsonWriter::~JsonWriter() {
+    if (sink_ && !own_buffer_.empty()) {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+}
+
+void JsonWriter::flush() {
+    if (sink_ && !out_.empty()) {
+        sink_(out_);
+        out_.clear();
+    }
+}
+
+void JsonWriter::maybe_flush() {
+    if (sink_ && out_.size() >= flush_threshold_) {
+        flush();
+    }
+}
+
+void JsonWriter::raw(std::string_view s) { out_.append(s); }
+
+void JsonWriter::newline() {
+    out_ += '\n';
+    out_.append(first_.size() * 2, ' ');
+}
+
+void JsonWriter::before_value() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (first_.empty()) {
+        return;
+    }
+    if (!first_.back()) {
+        out_ += ',';
+    }
+    first_.back() = false;
+    if (pretty_) {
+        newline();
+    }
+}
+
+JsonWriter &JsonWriter::begin_object() {
+    before_value();
+    out_ += '{';
+    first_.push_back(true);
+    return *this;
+}
+
+JsonWriter &JsonWriter::end_object() {
+    bool empty = first_.back();
+    first_.pop_back();
+    if (pretty_ && !empty) {
+        newline();
+    }
+    out_ += '}';
+    maybe_flush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::begin_array() {
+    before_value();
+    out_ += '[';
+    first_.push_back(true);
+    return *this;
+}
+
+JsonWriter &JsonWriter::end_array() {
+    bool empty = first_.back();
+    first_.pop_back();
+    if (pretty_ && !empty) {
+        newline();
+    }
+    out_ += ']';
+    maybe_flush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view name) {
+    before_value();
+    write_escaped(name);
+    out_.append(pretty_ ? ": " : ":");
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+    before_value();
+    raw("null");
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(bool b) {
+    before_value();
+    raw(b ? "true" : "false");
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(double d) {
+    before_value();
+    // JSON 不能表示 NaN 和无穷大
+    if (!std::isfinite(d)) {
+        raw("null");
+        return *this;
+    }
+
+    char buffer[32];
+    std::to_chars_result result;
+    // 2^53 以内的整数按整数输出，避免 1e+06 这样的写法
+    if (d == std::trunc(d) && std::fabs(d) < 9007199254740992.0 &&
+        !(d == 0 && std::signbit(d))) {
+        result = std::to_chars(buffer, buffer + sizeof(buffer),
+                               static_cast<int64_t>(d));
+    } else {
+        // 最短且可往返的表示
+        result = std::to_chars(buffer, buffer + sizeof(buffer), d);
+    }
+    out_.append(buffer, result.ptr);
+    maybe_flush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(int64_t n) {
+    before_value();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), n);
+    out_.append(buffer, result.ptr);
+    maybe_flush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::string_view s) {
+    before_value();
+    write_escaped(s);
+    maybe_flush();
+    return *this;
+}
+
+// 以 16 字节为单位扫描，没有需要转义的字节时整块复制
+void JsonWriter::write_escaped(std::string_view s) {
+    out_ += '"';
+    const char *p = s.data();
+    const char *end = p + s.size();
+
+    while (end - p >= 16) {
+        size_t clean = first_escape_in_block(p);
+        out_.append(p, clean);
+        p += clean;
+        if (clean < 16) {
+            append_escape(out_, static_cast<unsigned char>(*p++));
+        }
+        if (sink_ && out_.size() >= flush_threshold_) {
+            flush();
+        }
+    }
+
+    const char *run = p;
+    for (; p < end; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c < 0x20 || c == '"' || c == '\\') {
+            out_.append(run, p);
+            append_escape(out_, c);
+            run = p + 1;
+        }
+    }
+    out_.append(run, end);
+    out_ += '"';
+}
+
+JsonWriter &JsonWriter::write(const JsonValue &v) {
+    if (v.is_null()) {
+        null();
+    } else if (v.is_bool()) {
+        value(v.as_bool());
+    } else if (v.is_integer()) {
+        value(v.as_integer());
+    } else if (v.is_number()) {
+        value(v.as_number());
+    } else if (v.is_string()) {
+        value(std::string_view(v.as_string()));
+    } else if (v.is_array()) {
+        begin_array();
+        for (const JsonValue &element : v.as_array()) {
+            write(element);
+        }
+        end_array();
+    } else {
+        begin_object();
+        for (const auto &[k, element] : v.as_object()) {
+            key(k);
+            write(element);
+        }
+        end_object();
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::write(const JsonNode &node) {
+    switch (node.type()) {
+    case JsonNode::Type::Null:
+        null();
+        break;
+    case JsonNode::Type::Bool:
+        value(node.as_bool());
+        break;
+    case JsonNode::Type::Number:
+        if (node.is_integer()) {
+            value(node.as_integer());
+        } else {
+            value(node.as_number());
+        }
+        break;
+    case JsonNode::Type::String:
+        value(node.as_string());
+        break;
+    case JsonNode::Type::Array:
+        begin_array();
+        for (const JsonNode &element : node) {
+            write(element);
+        }
+        end_array();
+        break;
+    case JsonNode::Type::Object:
+        begin_object();
+        for (const JsonMember *m = node.members_begin();
+             m != node.members_end(); m++) {
+            key(m->key);
+            write(m->value);
+        }
+        end_object();
+        break;
+    }
+    return *this;
+}
@@ -0,0 +1,71 @@
+#include "Method.h"
+
+namespace {
+
+constexpr std::string_view kMethodNames[kMethodCount] = {
+    "GET",     "HEAD",    "POST",  "PUT",   "DELETE",
+    "CONNECT", "OPTIONS", "TRACE", "PATCH", "",
+};
+
+// 与大写的方法名逐字节比较，兼容小写的请求行
+bool equals_upper(std::string_view token, std::string_view upper) {
+    for (size_t i = 0; i < upper.size(); i++) {
+        char c = token[i];
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - ('a' - 'A'));
+        }
+        if (c != upper[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Method match(std::string_view token, Method candidate) {
+    return equals_upper(token, kMethodNames[method_index(candidate)])
+               ? candidate
+               : Method::Extension;
+}
+
+} // namespace
+
+Method parse_method(std::string_view token) {
+    // 先按长度分桶，每个桶最多比较两次
+    switch (token.size()) {
+    case 3: {
+        Method m = match(token, Method::Get);
+        return m != Method::Extension ? m : match(token, Method::Put);
+    }
+    case 4: {
+        Method m = match(token, Method::Post);
+        return m != Method::Extension ? m : match(token, Method::Head);
+    }
+    case 5: {
+        Method m = match(token, Method::Patch);
+        return m != Method::Extension ? m : match(token, Method::Trace);
+    }
+    case 6:
+        return match(token, Method::Delete);
+    case 7: {
+        Method m = match(token, Method::Options);
+        return m != Method::Extension ? m : match(token, Method::Connect);
+    }
+    default:
+        return Method::Extension;
+    }
+}
+
+std::string_view method_name(Method m) { return kMethodNames[method_index(m)]; }
+
+std::string allow_header_value(MethodMask mask) {
+    std::string value;
+    for (size_t i = 0; i < method_index(Method::Extension); i++) {
+        if (mask & method_bit(static_cast<Method>(i))) {
+            if (!value.empty()) {
+                value += ", ";
+            }
+            value += kMethodNames[i];
+        }
+    }
+    return value;
+}
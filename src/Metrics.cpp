@@ -0,0 +1,283 @@
+#include "Metrics.h"
+
+#include <cstdio>
+#include <map>
+
+namespace {
+
+// 槽位只由一个线程写入，普通的读-加-写即可，导出线程用 relaxed 读取
+void bump(std::atomic<uint64_t> &counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+}
+
+// 各桶的计数，最后一个是溢出桶
+using BucketCounts = std::array<uint64_t, Metrics::kBuckets + 1>;
+
+struct alignas(64) RouteStats {
+    explicit RouteStats(std::string_view route) : route(route) {}
+
+    const std::string_view route;
+    std::array<std::atomic<uint64_t>, 5> status_classes{}; // 1xx 到 5xx
+    std::array<std::atomic<uint64_t>, Metrics::kBuckets + 1> buckets{};
+    std::atomic<uint64_t> sum_us{0};
+};
+
+// 导出时按路由合并的结果
+struct RouteTotals {
+    std::array<uint64_t, 5> status_classes{};
+    BucketCounts buckets{};
+    uint64_t sum_us = 0;
+};
+
+void append_label(std::string &out, std::string_view value) {
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+}
+
+// 一个带标签的直方图：各桶的累计数、+Inf、_sum 与 _count
+void append_histogram(std::string &out, std::string_view name,
+                      std::string_view label, std::string_view value,
+                      const BucketCounts &buckets, uint64_t sum_us) {
+    char number[64];
+    auto begin_line = [&](std::string_view suffix) {
+        out += name;
+        out += suffix;
+        out += '{';
+        out += label;
+        out += "=\"";
+        append_label(out, value);
+        out += '"';
+    };
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < Metrics::kBuckets; i++) {
+        cumulative += buckets[i];
+        begin_line("_bucket");
+        std::snprintf(number, sizeof(number), ",le=\"%.6f\"} %llu\n",
+                      static_cast<double>(Metrics::bucket_upper_bound(i)) / 1e6,
+                      static_cast<unsigned long long>(cumulative));
+        out += number;
+    }
+    // 溢出桶不属于任何有限的 le，只计入 +Inf
+    cumulative += buckets[Metrics::kBuckets];
+    begin_line("_bucket");
+    std::snprintf(number, sizeof(number), ",le=\"+Inf\"} %llu\n",
+                  static_cast<unsigned long long>(cumulative));
+    out += number;
+
+    begin_line("_sum");
+    std::snprintf(number, sizeof(number), "} %.6f\n",
+                  static_cast<double>(sum_us) / 1e6);
+    out += number;
+    begin_line("_count");
+    std::snprintf(number, sizeof(number), "} %llu\n",
+                  static_cast<unsigned long long>(cumulative));
+    out += number;
+}
+
+} // namespace
+
+struct alignas(64) Metrics::Slot {
+    // 按路由模式的地址区分，发布前已构造完成
+    std::array<std::atomic<RouteStats *>, kMaxRoutes> routes{};
+    std::array<std::atomic<uint64_t>, kMaxStatus> status{};
+    std::array<std::array<std::atomic<uint64_t>, kBuckets + 1>,
+               trace::kPhaseCount>
+        phase_buckets{};
+    std::array<std::atomic<uint64_t>, trace::kPhaseCount> phase_sum_us{};
+
+    ~Slot() {
+        for (auto &route : routes) {
+            delete route.load();
+        }
+    }
+};
+
+size_t Metrics::bucket_index(uint64_t latency_us) {
+    if (latency_us < kSubBuckets) {
+        return static_cast<size_t>(latency_us);
+    }
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(latency_us));
+    unsigned shift = msb - kSubBucketBits;
+    size_t sub = static_cast<size_t>(latency_us >> shift) & (kSubBuckets - 1);
+    size_t index = (shift + 1) * kSubBuckets + sub;
+    return index < kBuckets ? index : kBuckets;
+}
+
+uint64_t Metrics::bucket_upper_bound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    size_t shift = index / kSubBuckets - 1;
+    uint64_t sub = index % kSubBuckets;
+    uint64_t lower = (kSubBuckets + sub) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+Metrics::Metrics() = default;
+Metrics::~Metrics() = default;
+
+Metrics::Slot *Metrics::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+        Slot *slot = free_.back();
+        free_.pop_back();
+        return slot;
+    }
+    slots_.push_back(std::make_unique<Slot>());
+    return slots_.back().get();
+}
+
+void Metrics::release(Slot *slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slot);
+}
+
+Metrics::Recorder::Recorder(Metrics &metrics)
+    : metrics_(metrics), slot_(metrics.acquire()) {}
+
+Metrics::Recorder::~Recorder() { metrics_.release(slot_); }
+
+void Metrics::Recorder::record(std::string_view route, int status,
+                               uint64_t latency_us) {
+    if (status >= 0 && static_cast<size_t>(status) < kMaxStatus) {
+        bump(slot_->status[static_cast<size_t>(status)]);
+    }
+
+    // 路由很少，按模式字符串的地址线性查找
+    RouteStats *stats = nullptr;
+    for (auto &entry : slot_->routes) {
+        RouteStats *candidate = entry.load(std::memory_order_relaxed);
+        if (!candidate) {
+            candidate = new RouteStats(route);
+            entry.store(candidate, std::memory_order_release);
+        }
+        if (candidate->route.data() == route.data() &&
+            candidate->route.size() == route.size()) {
+            stats = candidate;
+            break;
+        }
+    }
+    if (!stats) {
+        return;
+    }
+
+    if (status >= 100 && status < 600) {
+        bump(stats->status_classes[static_cast<size_t>(status / 100 - 1)]);
+    }
+    bump(stats->buckets[bucket_index(latency_us)]);
+    bump(stats->sum_us, latency_us);
+}
+
+void Metrics::Recorder::record_phases(
+    const std::array<uint64_t, trace::kPhaseCount> &phases_us) {
+    for (size_t i = 0; i < trace::kPhaseCount; i++) {
+        bump(slot_->phase_buckets[i][bucket_index(phases_us[i])]);
+        bump(slot_->phase_sum_us[i], phases_us[i]);
+    }
+}
+
+std::string Metrics::scrape() const {
+    std::map<std::string, RouteTotals> routes;
+    std::array<uint64_t, kMaxStatus> status{};
+    std::array<BucketCounts, trace::kPhaseCount> phase_buckets{};
+    std::array<uint64_t, trace::kPhaseCount> phase_sum_us{};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &slot : slots_) {
+            for (size_t i = 0; i < kMaxStatus; i++) {
+                status[i] += slot->status[i].load(std::memory_order_relaxed);
+            }
+            for (size_t phase = 0; phase < trace::kPhaseCount; phase++) {
+                for (size_t i = 0; i <= kBuckets; i++) {
+                    phase_buckets[phase][i] +=
+                        slot->phase_buckets[phase][i].load(
+                            std::memory_order_relaxed);
+                }
+                phase_sum_us[phase] +=
+                    slot->phase_sum_us[phase].load(std::memory_order_relaxed);
+            }
+            for (const auto &entry : slot->routes) {
+                const RouteStats *stats =
+                    entry.load(std::memory_order_acquire);
+                if (!stats) {
+                    break;
+                }
+                RouteTotals &totals = routes[std::string(stats->route)];
+                for (size_t i = 0; i < 5; i++) {
+                    totals.status_classes[i] += stats->status_classes[i].load(
+                        std::memory_order_relaxed);
+                }
+                for (size_t i = 0; i <= kBuckets; i++) {
+                    totals.buckets[i] +=
+                        stats->buckets[i].load(std::memory_order_relaxed);
+                }
+                totals.sum_us += stats->sum_us.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::string out;
+    char number[64];
+    auto route_label = [&](const std::string &route) {
+        out += "route=\"";
+        append_label(out, route.empty() ? "unmatched" : route);
+        out += '"';
+    };
+
+    out += "# HELP http_requests_total Requests by route and status class.\n"
+           "# TYPE http_requests_total counter\n";
+    for (const auto &[route, totals] : routes) {
+        for (size_t i = 0; i < 5; i++) {
+            if (totals.status_classes[i] == 0) {
+                continue;
+            }
+            out += "http_requests_total{";
+            route_label(route);
+            std::snprintf(number, sizeof(number), ",status=\"%zuxx\"} %llu\n",
+                          i + 1,
+                          static_cast<unsigned long long>(
+                              totals.status_classes[i]));
+            out += number;
+        }
+    }
+
+    out += "# HELP http_responses_total Responses by status code.\n"
+           "# TYPE http_responses_total counter\n";
+    for (size_t code = 0; code < kMaxStatus; code++) {
+        if (status[code] != 0) {
+            std::snprintf(number, sizeof(number),
+                          "http_responses_total{code=\"%zu\"} %llu\n", code,
+                          static_cast<unsigned long long>(status[code]));
+            out += number;
+        }
+    }
+
+    out += "# HELP http_request_duration_seconds Request latency by route.\n"
+           "# TYPE http_request_duration_seconds histogram\n";
+    for (const auto &[route, totals] : routes) {
+        append_histogram(out, "http_request_duration_seconds", "route",
+                         route.empty() ? "unmatched" : route, totals.buckets,
+                         totals.sum_us);
+    }
+
+    // 没有经过某阶段的请求记为 0，各阶段的 _count 相同
+    out += "# HELP http_request_phase_seconds Time spent in each request "
+           "phase.\n"
+           "# TYPE http_request_phase_seconds histogram\n";
+    for (size_t phase = 0; phase < trace::kPhaseCount; phase++) {
+        append_histogram(out, "http_request_phase_seconds", "phase",
+                         trace::phase_name(static_cast<trace::Phase>(phase)),
+                         phase_buckets[phase], phase_sum_us[phase]);
+    }
+    return out;
+}
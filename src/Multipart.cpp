@@ -0,0 +1,348 @@
+#include "Multipart.h"
+#include "HeaderMap.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// Content-Disposition 的参数，如 form-data; name="a"; filename="b.txt"，
+// 带引号的值中 '\' 转义下一个字符
+template <typename Callback>
+void for_each_param(std::string_view value, Callback &&callback) {
+    size_t semicolon = value.find(';');
+    value = semicolon == std::string_view::npos ? std::string_view()
+                                                : value.substr(semicolon + 1);
+    while (!value.empty()) {
+        size_t end = value.find_first_of("=;");
+        std::string_view key = trim(value.substr(0, end));
+        if (end == std::string_view::npos || value[end] == ';') {
+            value.remove_prefix(end == std::string_view::npos ? value.size()
+                                                              : end + 1);
+            continue;
+        }
+        value.remove_prefix(end + 1);
+        value = trim(value);
+
+        std::string param;
+        if (!value.empty() && value.front() == '"') {
+            size_t i = 1;
+            for (; i < value.size() && value[i] != '"'; i++) {
+                if (value[i] == '\\' && i + 1 < value.size()) {
+                    i++;
+                }
+                param += value[i];
+            }
+            value.remove_prefix(std::min(i + 1, value.size()));
+            semicolon = value.find(';');
+        } else {
+            semicolon = value.find(';');
+            param = trim(value.substr(0, semicolon));
+        }
+        value.remove_prefix(semicolon == std::string_view::npos ? value.size()
+                                                                : semicolon + 1);
+        callback(key, std::move(param));
+    }
+}
+
+} // namespace
+
+MultipartParser::MultipartParser(std::string_view boundary,
+                                 MultipartHandler &handler, size_t max_header)
+    : handler_(handler), max_header_(max_header) {
+    // RFC 2046: 边界为 1 到 70 个字符
+    if (boundary.empty() || boundary.size() > 70) {
+        throw MultipartParseError("Invalid multipart boundary");
+    }
+    delimiter_ = "\r\n--";
+    delimiter_.append(boundary);
+
+    // 第一个分隔符可以位于请求体开头，前面补一个换行即可统一处理
+    carry_ = "\r\n";
+
+    const size_t n = delimiter_.size();
+    skip_.fill(static_cast<uint8_t>(n));
+    for (size_t i = 0; i + 1 < n; i++) {
+        skip_[static_cast<uint8_t>(delimiter_[i])] =
+            static_cast<uint8_t>(n - 1 - i);
+    }
+}
+
+size_t MultipartParser::find_delimiter(std::string_view data) const {
+    const size_t n = delimiter_.size();
+    const char last = delimiter_[n - 1];
+    size_t i = 0;
+    while (i + n <= data.size()) {
+        char c = data[i + n - 1];
+        if (c == last &&
+            std::memcmp(data.data() + i, delimiter_.data(), n - 1) == 0) {
+            return i;
+        }
+        i += skip_[static_cast<uint8_t>(c)];
+    }
+    return std::string_view::npos;
+}
+
+size_t MultipartParser::partial_delimiter(std::string_view data) const {
+    // 分隔符以 '\r' 开头，只需检查末尾 n - 1 字节中的 '\r'
+    const size_t n = delimiter_.size();
+    size_t i = data.size() > n - 1 ? data.size() - (n - 1) : 0;
+    for (; i < data.size(); i++) {
+        if (data[i] == '\r' &&
+            std::string_view(delimiter_).substr(0, data.size() - i) ==
+                data.substr(i)) {
+            return data.size() - i;
+        }
+    }
+    return 0;
+}
+
+void MultipartParser::emit(std::string_view data) {
+    if (state_ == State::Body && !data.empty()) {
+        handler_.on_part_data(data);
+    }
+}
+
+void MultipartParser::on_delimiter() {
+    if (state_ == State::Body) {
+        handler_.on_part_end();
+    }
+    state_ = State::Delimiter;
+}
+
+std::string_view MultipartParser::feed_data(std::string_view chunk) {
+    const size_t n = delimiter_.size();
+
+    // 上一段末尾可能是分隔符的开头，与本段开头拼接后再查找
+    if (!carry_.empty()) {
+        const size_t k = carry_.size();
+        scratch_.assign(carry_);
+        scratch_.append(chunk.substr(0, n));
+        size_t found = find_delimiter(scratch_);
+        if (found != std::string_view::npos) {
+            emit(std::string_view(scratch_).substr(0, found));
+            carry_.clear();
+            on_delimiter();
+            return chunk.substr(found + n - k);
+        }
+
+        size_t safe = scratch_.size() - partial_delimiter(scratch_);
+        if (safe < k) {
+            // 本段不足一个分隔符长度，全部并入 carry_
+            emit(std::string_view(scratch_).substr(0, safe));
+            carry_.assign(scratch_, safe, std::string::npos);
+            return {};
+        }
+        emit(carry_);
+        carry_.clear();
+    }
+
+    size_t found = find_delimiter(chunk);
+    if (found != std::string_view::npos) {
+        emit(chunk.substr(0, found));
+        on_delimiter();
+        return chunk.substr(found + n);
+    }
+
+    size_t keep = partial_delimiter(chunk);
+    emit(chunk.substr(0, chunk.size() - keep));
+    carry_.assign(chunk.substr(chunk.size() - keep));
+    return {};
+}
+
+std::string_view MultipartParser::feed_headers(std::string_view chunk) {
+    // header_ 以 "\r\n" 开头，没有头部时也以 "\r\n\r\n" 结束
+    const size_t old = header_.size();
+    header_.append(chunk.substr(0, max_header_ + 4));
+    size_t end = header_.find("\r\n\r\n", old >= 3 ? old - 3 : 0);
+    if (end == std::string::npos) {
+        if (header_.size() > max_header_ + 2) {
+            throw MultipartParseError("Multipart headers too large");
+        }
+        return {};
+    }
+    if (end > max_header_) {
+        throw MultipartParseError("Multipart headers too large");
+    }
+
+    parse_headers(std::string_view(header_).substr(2, end));
+    header_.clear();
+    state_ = State::Body;
+    count_++;
+    handler_.on_part_begin(part_);
+    return chunk.substr(end + 4 - old);
+}
+
+void MultipartParser::parse_headers(std::string_view block) {
+    part_ = MultipartPart();
+    bool has_disposition = false;
+
+    while (!block.empty()) {
+        size_t eol = block.find("\r\n");
+        std::string_view line = block.substr(0, eol);
+        block.remove_prefix(eol == std::string_view::npos ? block.size()
+                                                          : eol + 2);
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            throw MultipartParseError("Malformed multipart header");
+        }
+        std::string_view name = trim(line.substr(0, colon));
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if (iequals(name, "Content-Disposition")) {
+            has_disposition = true;
+            for_each_param(value, [&](std::string_view key, std::string param) {
+                if (iequals(key, "name")) {
+                    part_.name = std::move(param);
+                } else if (iequals(key, "filename")) {
+                    part_.filename = std::move(param);
+                    part_.is_file = true;
+                }
+            });
+        } else if (iequals(name, "Content-Type")) {
+            part_.content_type = value;
+        }
+    }
+
+    if (!has_disposition) {
+        throw MultipartParseError("Multipart part without Content-Disposition");
+    }
+}
+
+void MultipartParser::feed(std::string_view chunk) {
+    while (!chunk.empty()) {
+        switch (state_) {
+        case State::Preamble:
+        case State::Body:
+            chunk = feed_data(chunk);
+            break;
+        case State::Delimiter:
+            // 分隔符后可以有空白，之后是行尾或表示结束的 "--"
+            if (chunk[0] == '-') {
+                state_ = State::CloseDash;
+            } else if (chunk[0] == '\r') {
+                state_ = State::LineFeed;
+            } else if (chunk[0] != ' ' && chunk[0] != '\t') {
+                throw MultipartParseError("Malformed multipart delimiter");
+            }
+            chunk.remove_prefix(1);
+            break;
+        case State::CloseDash:
+        case State::LineFeed:
+            if (chunk[0] != (state_ == State::CloseDash ? '-' : '\n')) {
+                throw MultipartParseError("Malformed multipart delimiter");
+            }
+            chunk.remove_prefix(1);
+            if (state_ == State::CloseDash) {
+                state_ = State::Epilogue;
+            } else {
+                state_ = State::Headers;
+                header_.assign("\r\n");
+            }
+            break;
+        case State::Headers:
+            chunk = feed_headers(chunk);
+            break;
+        case State::Epilogue:
+            return;
+        }
+    }
+}
+
+void MultipartParser::finish() {
+    if (state_ != State::Epilogue) {
+        throw MultipartParseError("Unexpected end of multipart body");
+    }
+}
+
+MultipartFileSaver::MultipartFileSaver(std::filesystem::path directory,
+                                       size_t max_field, size_t max_fields)
+    : directory_(std::move(directory)), max_field_(max_field),
+      max_fields_(max_fields) {
+    std::filesystem::create_directories(directory_);
+}
+
+MultipartFileSaver::~MultipartFileSaver() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        std::error_code ec;
+        std::filesystem::remove(files_.back().path, ec);
+    }
+}
+
+void MultipartFileSaver::on_part_begin(const MultipartPart &part) {
+    if (!part.is_file) {
+        if (++field_count_ > max_fields_) {
+            throw MultipartParseError("Too many form fields");
+        }
+        field_name_ = part.name;
+        field_value_.clear();
+        return;
+    }
+
+    std::string path = (directory_ / "upload-XXXXXX").string();
+    fd_ = ::mkstemp(path.data());
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot create upload file: " +
+                                 std::string(std::strerror(errno)));
+    }
+    files_.push_back(
+        SavedFile{part.name, part.filename, part.content_type, path, 0});
+    SPDLOG_DEBUG("saving upload {} to {}", part.filename, path);
+}
+
+void MultipartFileSaver::on_part_data(std::string_view data) {
+    if (fd_ < 0) {
+        if (field_value_.size() + data.size() > max_field_) {
+            throw MultipartParseError("Form field too large");
+        }
+        field_value_.append(data);
+        return;
+    }
+
+    files_.back().size += data.size();
+    while (!data.empty()) {
+        ssize_t n = ::write(fd_, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot write upload file: " +
+                                     std::string(std::strerror(errno)));
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+}
+
+void MultipartFileSaver::on_part_end() {
+    if (fd_ < 0) {
+        fields_.emplace(std::move(field_name_), std::move(field_value_));
+        return;
+    }
+    close_file();
+}
+
+void MultipartFileSaver::close_file() {
+    int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0) {
+        std::error_code ec;
+        std::filesystem::remove(files_.back().path, ec);
+        throw std::runtime_error("Cannot write upload file: " +
+                                 std::string(std::strerror(errno)));
+    }
+}
@@ -1,23 +1,260 @@
 #include "Request.h"
+#include "HttpError.h"
+#include "JsonBinary.h"
+#include "JsonStream.h"
+#include "Multipart.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
 #include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <sys/socket.h>
+
+namespace {
+
+bool is_json_media_type(std::string_view type) {
+    if (iequals(type, "application/json")) {
+        return true;
+    }
+    // application/problem+json 等结构化后缀
+    return type.size() > 5 && iequals(type.substr(type.size() - 5), "+json");
+}
+
+// 请求体与响应体支持的媒体类型
+std::optional<json::Format> format_of(std::string_view type) {
+    if (is_json_media_type(type)) {
+        return json::Format::Json;
+    }
+    if (iequals(type, "application/msgpack") ||
+        iequals(type, "application/x-msgpack") ||
+        iequals(type, "application/vnd.msgpack")) {
+        return json::Format::MsgPack;
+    }
+    if (iequals(type, "application/cbor")) {
+        return json::Format::Cbor;
+    }
+    return std::nullopt;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// Accept 中某一项的 q 值，缺省为 1，格式错误按 0 处理
+double quality_of(std::string_view params) {
+    while (!params.empty()) {
+        size_t semi = params.find(';');
+        std::string_view param = trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view()
+                                                : params.substr(semi + 1);
+        if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') ||
+            param[1] != '=') {
+            continue;
+        }
+        std::string value(param.substr(2));
+        char *end = nullptr;
+        double q = std::strtod(value.c_str(), &end);
+        if (end != value.c_str() + value.size() || !(q >= 0 && q <= 1)) {
+            return 0;
+        }
+        return q;
+    }
+    return 1;
+}
+
+// Content-Type 中 multipart 的 boundary 参数，可以带引号
+std::string_view boundary_of(std::string_view content_type) {
+    size_t semi = content_type.find(';');
+    std::string_view params = semi == std::string_view::npos
+                                  ? std::string_view()
+                                  : content_type.substr(semi + 1);
+    while (!params.empty()) {
+        semi = params.find(';');
+        std::string_view param = trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view()
+                                                : params.substr(semi + 1);
+        size_t eq = param.find('=');
+        if (eq == std::string_view::npos ||
+            !iequals(trim(param.substr(0, eq)), "boundary")) {
+            continue;
+        }
+        std::string_view value = trim(param.substr(eq + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+    return {};
+}
+
+// 逗号分隔的头部值中是否有某一项（大小写无关）
+bool has_token(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        if (iequals(trim(list.substr(0, comma)), token)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// arena 的初始缓冲区在连接之间复用。每个连接由一个新线程处理，
+// thread_local 的缓冲区会随线程结束释放，因此空闲的块放在进程级的
+// 池中，最多保留 kMaxPooledBlocks 块
+constexpr size_t kArenaBlockSize = 64 * 1024;
+constexpr size_t kMaxPooledBlocks = 128;
+
+class BlockPool {
+  public:
+    std::unique_ptr<std::byte[]> acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                std::unique_ptr<std::byte[]> block = std::move(free_.back());
+                free_.pop_back();
+                return block;
+            }
+        }
+        return std::make_unique<std::byte[]>(kArenaBlockSize);
+    }
+
+    void release(std::unique_ptr<std::byte[]> block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < kMaxPooledBlocks) {
+            free_.push_back(std::move(block));
+        }
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<std::byte[]>> free_;
+};
+
+// 不析构：分离的连接线程可能在静态对象析构之后才归还缓冲区
+BlockPool &block_pool() {
+    static BlockPool *pool = new BlockPool;
+    return *pool;
+}
+
+// 让容器放弃 arena 中的缓冲区。交换而不是移动赋值：
+// 从短字符串移动赋值时 std::basic_string 会保留原来的缓冲区
+template <typename Container> void release(Container &container) {
+    Container(container.get_allocator()).swap(container);
+}
+
+} // namespace
+
+// 请求级单调 arena，超出初始缓冲区的部分向全局分配器申请，
+// release() 时归还并回到初始缓冲区
+class RequestArena {
+  public:
+    RequestArena() : block_(block_pool().acquire()) {
+        resource_.emplace(block_.get(), kArenaBlockSize);
+    }
+
+    ~RequestArena() {
+        resource_.reset();
+        block_pool().release(std::move(block_));
+    }
+
+    RequestArena(const RequestArena &) = delete;
+    RequestArena &operator=(const RequestArena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &*resource_; }
+    void release() { resource_->release(); }
+
+  private:
+    std::unique_ptr<std::byte[]> block_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+Request::Request(int fd)
+    : arena_(std::make_unique<RequestArena>()), client_fd_(fd) {}
+Request::Request() : arena_(std::make_unique<RequestArena>()) {}
+Request::~Request() = default;
+Request::Request(Request &&) = default;
+
+std::pmr::memory_resource *Request::resource() const {
+    return arena_->resource();
+}
+
+void Request::reset() {
+    // 先让容器放弃 arena 中的内存，再整体回收
+    method = Method::Extension;
+    release(extension_method);
+    release(path);
+    release(query_string);
+    release(version);
+    headers.release();
+    release(relative_path);
+    release(params);
+    release(param_names);
+    route = {};
+    release(body_);
+    release(body_chunk_);
+    json_.reset();
+    json_lazy_.reset();
+    form_.reset();
+    arena_->release();
+
+    body_unread_ = 0;
+    body_prefix_ = false;
+    body_loaded_ = false;
+    body_streamed_ = false;
+    body_read_ticks_ = 0;
+}
+
+bool Request::keep_alive() const {
+    std::string_view connection = headers.get(Header::Connection);
+    if (version == "HTTP/1.1") {
+        return !has_token(connection, "close");
+    }
+    return has_token(connection, "keep-alive");
+}
+
+bool Request::discard_body() {
+    // 剩余部分太大时直接关闭连接，比读完更省
+    constexpr size_t kMaxDiscard = 1 << 20;
+    if (body_unread_ > kMaxDiscard) {
+        return false;
+    }
+    try {
+        while (!next_body_chunk().empty()) {
+        }
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+    return true;
+}
 
 void Request::info() {
-    spdlog::debug("method={}", method);
+    spdlog::debug("method={}", method == Method::Extension
+                                     ? std::string_view(extension_method)
+                                     : method_name(method));
     spdlog::debug("path={}", path);
     spdlog::debug("version={}", version);
-    spdlog::debug("body={}", body_str);
-    for (auto &[k, v] : headers) {
+    spdlog::debug("body={}", body_str());
+    for (auto [k, v] : headers) {
         spdlog::debug("{}:{}", k, v);
     }
 }
 
 bool Request::isBodyLikelyString() {
-    auto it = headers.find("Content-Type");
-    if (it == headers.end())
+    std::string_view contentType = headers.get(Header::ContentType);
+    if (contentType.empty())
         return false;
 
-    std::string contentType = it->second;
-
     // 文本类型
     if (contentType.find("text/") == 0)
         return true;
@@ -41,4 +278,280 @@ bool Request::isBodyLikelyString() {
 
     // 默认情况下，如果未指定，尝试其他方法
     return false;
-}
\ No newline at end of file
+}
+
+void Request::set_body_source(std::string_view received,
+                              size_t content_length) {
+    // 流水线请求的后续数据不属于本请求体
+    received = received.substr(0, content_length);
+    body_chunk_.assign(received);
+    body_prefix_ = !received.empty();
+    body_unread_ = content_length;
+    body_.clear();
+    body_loaded_ = false;
+    body_streamed_ = false;
+}
+
+std::string_view Request::next_body_chunk() const {
+    constexpr size_t kChunkSize = 16 * 1024;
+
+    if (body_unread_ == 0) {
+        return {};
+    }
+    if (body_prefix_) {
+        body_prefix_ = false;
+        body_unread_ -= body_chunk_.size();
+        return body_chunk_;
+    }
+
+    body_chunk_.resize(std::min(body_unread_, kChunkSize));
+    uint64_t begin = trace::now();
+    ssize_t n = recv(client_fd_, body_chunk_.data(), body_chunk_.size(), 0);
+    body_read_ticks_ += trace::now() - begin;
+    if (n <= 0) {
+        SPDLOG_DEBUG("connection closed with {} body bytes unread",
+                     body_unread_);
+        body_unread_ = 0;
+        throw HttpError(400);
+    }
+    body_chunk_.resize(static_cast<size_t>(n));
+    body_unread_ -= static_cast<size_t>(n);
+    return body_chunk_;
+}
+
+std::string_view Request::read_body_chunk() {
+    if (body_loaded_) {
+        throw std::runtime_error("Request body already consumed");
+    }
+    body_streamed_ = true;
+    return next_body_chunk();
+}
+
+const std::pmr::vector<uint8_t> &Request::body() const {
+    if (body_loaded_) {
+        return body_;
+    }
+    if (body_streamed_) {
+        throw std::runtime_error("Request body already consumed");
+    }
+
+    // 第一次追加前按 Content-Length 一次预留，因为 arena 中扩容换下的
+    // 旧缓冲区不会被复用；长度由客户端给出，预留的空间有上限
+    constexpr size_t kMaxReserve = 1 << 20;
+    body_.reserve(std::min(body_unread_, kMaxReserve));
+    for (std::string_view chunk = next_body_chunk(); !chunk.empty();
+         chunk = next_body_chunk()) {
+        body_.insert(body_.end(), chunk.begin(), chunk.end());
+    }
+    body_chunk_.clear();
+    body_loaded_ = true;
+    return body_;
+}
+
+std::string_view Request::body_str() const {
+    const std::pmr::vector<uint8_t> &data = body();
+    return std::string_view(reinterpret_cast<const char *>(data.data()),
+                            data.size());
+}
+
+void Request::stream_json(JsonHandler &handler) {
+    if (!body_loaded_ && body_unread_ == 0) {
+        handler.on_null();
+        return;
+    }
+    JsonStreamParser parser(handler);
+    stream_body(parser, is_json_media_type(media_type()));
+}
+
+void Request::stream_json_elements(
+    const std::function<void(std::string_view)> &callback) {
+    if (!body_loaded_ && body_unread_ == 0) {
+        return;
+    }
+    JsonElementSplitter splitter(callback);
+    stream_body(splitter, is_json_media_type(media_type()));
+}
+
+bool Request::is_json_lines() const {
+    std::string_view type = media_type();
+    return iequals(type, "application/x-ndjson") ||
+           iequals(type, "application/ndjson") ||
+           iequals(type, "application/jsonl") ||
+           iequals(type, "application/x-jsonlines");
+}
+
+void Request::stream_json_lines(
+    const std::function<void(std::string_view, size_t)> &callback,
+    size_t max_line) {
+    if (!body_loaded_ && body_unread_ == 0) {
+        return;
+    }
+    JsonLineSplitter splitter(callback, max_line);
+    stream_body(splitter, is_json_lines());
+}
+
+void Request::stream_multipart(MultipartHandler &handler) {
+    if (!iequals(media_type(), "multipart/form-data")) {
+        throw HttpError(415);
+    }
+    std::string_view boundary = boundary_of(headers.get(Header::ContentType));
+    if (boundary.empty() || boundary.size() > 70) {
+        SPDLOG_DEBUG("invalid multipart boundary: '{}'", boundary);
+        throw HttpError(400);
+    }
+    MultipartParser parser(boundary, handler);
+    stream_body(parser, true);
+}
+
+template <typename Parser>
+void Request::stream_body(Parser &parser, bool accepted) {
+    if (!accepted) {
+        throw HttpError(415);
+    }
+
+    try {
+        for (std::string_view chunk = read_body_chunk(); !chunk.empty();
+             chunk = read_body_chunk()) {
+            parser.feed(chunk);
+        }
+        parser.finish();
+    } catch (const JsonParseError &e) {
+        SPDLOG_DEBUG("invalid JSON body: {}", e.what());
+        throw HttpError(400);
+    } catch (const MultipartParseError &e) {
+        SPDLOG_DEBUG("invalid multipart body: {}", e.what());
+        throw HttpError(400);
+    }
+}
+
+std::string_view Request::media_type() const {
+    std::string_view type = headers.get(Header::ContentType);
+    type = type.substr(0, type.find(';'));
+    while (!type.empty() && (type.back() == ' ' || type.back() == '\t')) {
+        type.remove_suffix(1);
+    }
+    return type;
+}
+
+const JsonValue &Request::json() const {
+    if (json_) {
+        return *json_;
+    }
+
+    if (body().empty()) {
+        return json_.emplace();
+    }
+    std::optional<json::Format> format = body_format();
+    if (!format) {
+        throw HttpError(415);
+    }
+
+    try {
+        switch (*format) {
+        case json::Format::MsgPack:
+            return json_.emplace(json::decode_msgpack(body_str()));
+        case json::Format::Cbor:
+            return json_.emplace(json::decode_cbor(body_str()));
+        case json::Format::Json:
+            break;
+        }
+        return json_.emplace(JsonValue::parse(body_str()));
+    } catch (const std::runtime_error &e) {
+        SPDLOG_DEBUG("invalid request body: {}", e.what());
+        throw HttpError(400);
+    }
+}
+
+std::optional<json::Format> Request::body_format() const {
+    return format_of(media_type());
+}
+
+std::optional<json::Format> Request::accepted_format() const {
+    std::optional<json::Format> best;
+    double best_q = 0;
+    std::string_view accept = headers.get(Header::Accept);
+    while (!accept.empty()) {
+        size_t comma = accept.find(',');
+        std::string_view item = accept.substr(0, comma);
+        accept = comma == std::string_view::npos ? std::string_view()
+                                                 : accept.substr(comma + 1);
+        size_t semi = item.find(';');
+        std::optional<json::Format> format =
+            format_of(trim(item.substr(0, semi)));
+        if (!format) {
+            continue;
+        }
+        double q = semi == std::string_view::npos
+                       ? 1
+                       : quality_of(item.substr(semi + 1));
+        // q 相同时取先出现的
+        if (q > best_q) {
+            best = format;
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+const JsonLazyDocument &Request::json_lazy() const {
+    if (json_lazy_) {
+        return *json_lazy_;
+    }
+
+    if (body().empty()) {
+        return json_lazy_.emplace(JsonLazyDocument::parse("null"));
+    }
+    if (!is_json_media_type(media_type())) {
+        throw HttpError(415);
+    }
+
+    // 文档引用 body_，请求体读入后不再变化
+    try {
+        return json_lazy_.emplace(JsonLazyDocument::parse(body_str()));
+    } catch (const std::runtime_error &e) {
+        SPDLOG_DEBUG("invalid JSON body: {}", e.what());
+        throw HttpError(400);
+    }
+}
+
+const Request::Form &Request::form() const {
+    if (form_) {
+        return *form_;
+    }
+
+    bool empty = body().empty();
+    Form &result = form_.emplace(resource());
+    if (empty) {
+        return result;
+    }
+    if (!iequals(media_type(), "application/x-www-form-urlencoded")) {
+        form_.reset();
+        throw HttpError(415);
+    }
+
+    for (const url::QueryParam &param : url::QueryParams(body_str())) {
+        // 键和值由 arena 的分配器构造，直接解码进去
+        auto &[key, value] = result.emplace_back();
+        url::percent_decode(param.key, key, true);
+        url::percent_decode(param.value, value, true);
+    }
+    return result;
+}
+
+std::unordered_map<std::string, std::string> Request::query_params() const {
+    std::unordered_map<std::string, std::string> result;
+    for (const url::QueryParam &param : query()) {
+        result.emplace(url::percent_decode(param.key, true),
+                       url::percent_decode(param.value, true));
+    }
+    return result;
+}
+
+std::string Request::get_path_param(std::string_view key) const {
+    for (size_t i = 0; i < param_names.size() && i < params.size(); i++) {
+        if (param_names[i] == key) {
+            return url::percent_decode(params[i], false);
+        }
+    }
+    return {};
+}
@@ -1,11 +1,75 @@
 #include "RequestHandler.h"
+#include "HttpError.h"
+#include "JsonBind.h"
+#include "JsonWriter.h"
+#include "Multipart.h"
+#include <deque>
+
+namespace {
+
+// POST /api/v1/commands 中的一条命令，其余字段忽略
+struct Command {
+    std::string host;
+};
+JSON_BIND(Command, host)
+
+// NDJSON 上传中交给一个工作线程解析的若干行
+struct LineBatch {
+    static constexpr size_t kMaxLines = 256;
+    static constexpr size_t kMaxBytes = 64 * 1024;
+
+    std::string text;                               // 各行首尾相接
+    std::vector<std::pair<size_t, size_t>> lines;   // 行号与在 text 中的终点
+
+    bool full() const {
+        return lines.size() >= kMaxLines || text.size() >= kMaxBytes;
+    }
+};
+
+// 每行一个结果对象，按行的顺序写成 NDJSON
+struct BatchResult {
+    std::string output;
+    size_t accepted = 0;
+    size_t rejected = 0;
+};
+
+BatchResult parse_batch(const LineBatch &batch) {
+    BatchResult result;
+    JsonWriter writer(result.output);
+    Command command;
+    std::string error;
+    size_t begin = 0;
+    for (auto [number, end] : batch.lines) {
+        std::string_view line(batch.text.data() + begin, end - begin);
+        begin = end;
+
+        command = Command();
+        error.clear();
+        if (json::from_json(line, command, &error) && command.host.empty()) {
+            error = "Missing host";
+        }
+        writer.begin_object().key("line").value(static_cast<int64_t>(number));
+        if (error.empty()) {
+            SPDLOG_DEBUG("Server IP: {}", command.host);
+            writer.key("host").value(command.host);
+            result.accepted++;
+        } else {
+            writer.key("error").value(error);
+            result.rejected++;
+        }
+        writer.end_object();
+        result.output += '\n';
+    }
+    return result;
+}
+
+} // namespace
 
 void RequestHandler::setup_routes() {
     // 静态文件服务
-    router_.add_route("GET", "/*", [this](Request &req, Response &res) {
-
-        auto relative_path = req.path.substr(1);
-        auto absolute_path = root_path_ / relative_path;
+    router_.add_route(Method::Get, "/*", [this](Request &req, Response &res) {
+        fs::path absolute_path =
+            root_path_ / std::string_view(req.relative_path);
 
         if (fs::exists(absolute_path)) {
             if (fs::is_directory(absolute_path)) {
@@ -14,61 +78,214 @@ void RequestHandler::setup_routes() {
                 res.send_file(absolute_path);
             }
         } else {
-            throw std::runtime_error("404 Not Found");
+            throw HttpError(404);
         }
     });
 
     // API 端点
     router_.add_route(
-        "POST", "/api/v1/commands", [this](Request &req, Response &res) {
+        Method::Post, "/api/v1/commands", [this](Request &req, Response &res) {
             SPDLOG_DEBUG("POST request to: {}", req.path);
-            SPDLOG_DEBUG("JSON data: {}", req.body_str);
 
-            if (req.json_value.is_object()) {
-                auto server_ip =
-                    req.json_value.as_object().at("host").as_string();
-                SPDLOG_INFO("Server IP: {}", server_ip);
+            if (req.is_json_lines()) {
+                ingest_json_lines(req, res);
+                return;
             }
 
-            if (!req.splited_path.empty() &&
-                req.splited_path.back() == "commands") {
-                res.status(200).send("Command received\n");
+            // 批量上传时请求体是命令数组，逐条绑定到 Command，不构建整棵树；
+            // MessagePack 与 CBOR 请求体先解码为 JsonValue 再绑定
+            Command command;
+            std::string error;
+            size_t count = 0;
+            auto accept = [&](auto &&bind) {
+                command = Command();
+                if (!bind(command)) {
+                    SPDLOG_DEBUG("invalid command: {}", error);
+                    throw HttpError(400);
+                }
+                if (command.host.empty()) {
+                    SPDLOG_DEBUG("command without host");
+                    throw HttpError(400);
+                }
+                SPDLOG_DEBUG("Server IP: {}", command.host);
+                count++;
+            };
+            auto from_value = [&](const JsonValue &value) {
+                accept([&](Command &c) {
+                    return json::from_value(value, c, &error);
+                });
+            };
+
+            std::optional<json::Format> format = req.body_format();
+            if (format && *format != json::Format::Json) {
+                const JsonValue &body = req.json();
+                if (body.is_array()) {
+                    for (const JsonValue &element : body.as_array()) {
+                        from_value(element);
+                    }
+                } else if (!body.is_null()) {
+                    from_value(body);
+                }
             } else {
-                res.status(200).send("POST request processed\n");
+                req.stream_json_elements([&](std::string_view text) {
+                    accept([&](Command &c) {
+                        return json::from_json(text, c, &error);
+                    });
+                });
+            }
+            SPDLOG_DEBUG("{} command(s) received", count);
+
+            // 客户端明确要求结构化响应时按其格式返回
+            if (std::optional<json::Format> reply = req.accepted_format()) {
+                JsonValue::Object result;
+                result.emplace("received", static_cast<int64_t>(count));
+                res.status(200).send_value(JsonValue(std::move(result)),
+                                           *reply);
+            } else {
+                res.status(200).send("Command received\n");
             }
         });
+
+    // multipart/form-data 上传，文件部分边接收边写入 upload_dir_
+    router_.add_route(
+        Method::Post, "/api/v1/uploads", [this](Request &req, Response &res) {
+            MultipartFileSaver saver(upload_dir_);
+            try {
+                req.stream_multipart(saver);
+            } catch (...) {
+                // 上传不完整时已写完的文件也不保留
+                std::error_code ec;
+                for (const auto &file : saver.files()) {
+                    fs::remove(file.path, ec);
+                }
+                throw;
+            }
+
+            std::string body;
+            JsonWriter writer(body);
+            writer.begin_object().key("files").begin_array();
+            for (const auto &file : saver.files()) {
+                SPDLOG_INFO("Uploaded {} ({} bytes) to {}", file.filename,
+                            file.size, file.path.string());
+                writer.begin_object()
+                    .key("name")
+                    .value(file.name)
+                    .key("filename")
+                    .value(file.filename)
+                    .key("size")
+                    .value(static_cast<int64_t>(file.size))
+                    .end_object();
+            }
+            writer.end_array().key("fields").begin_object();
+            for (const auto &[name, value] : saver.fields()) {
+                writer.key(name).value(value);
+            }
+            writer.end_object().end_object();
+
+            res.status(200).header("Content-Type", "application/json");
+            res.send(body);
+        });
 }
 
-void RequestHandler::process_request(Request &req, Response &res) {
-    auto relative_path = req.path.substr(1);
-    auto absolute_path = root_path_ / relative_path;
+// 每行一条命令，边接收边按批交给线程池解析，结果按原顺序以 NDJSON
+// 分块写回；未写回的批次数有上限，内存占用与上传大小无关
+void RequestHandler::ingest_json_lines(Request &req, Response &res) {
+    const size_t max_pending = 2 * workers_.size();
+    std::deque<std::future<BatchResult>> pending;
+    size_t accepted = 0;
+    size_t rejected = 0;
 
-    SPDLOG_INFO("Requested path: {}", absolute_path.string());
+    res.status(200).header("Content-Type", "application/x-ndjson");
+    res.begin_chunked();
 
-    // 安全路径检查
-    if (absolute_path.lexically_normal().string().find(root_path_.string()) !=
-        0) {
-        throw std::runtime_error("Invalid path traversal attempt");
+    auto write_oldest = [&] {
+        BatchResult result = pending.front().get();
+        pending.pop_front();
+        accepted += result.accepted;
+        rejected += result.rejected;
+        res.write_chunk(result.output);
+    };
+    LineBatch batch;
+    auto submit = [&] {
+        pending.push_back(workers_.submit(
+            [batch = std::move(batch)] { return parse_batch(batch); }));
+        batch = LineBatch();
+        if (pending.size() >= max_pending) {
+            write_oldest();
+        }
+    };
+
+    std::string error;
+    try {
+        req.stream_json_lines([&](std::string_view line, size_t number) {
+            batch.text.append(line);
+            batch.lines.emplace_back(number, batch.text.size());
+            if (batch.full()) {
+                submit();
+            }
+        });
+    } catch (const std::exception &e) {
+        // 状态行已经发出，错误作为最后一行返回
+        SPDLOG_DEBUG("NDJSON upload aborted: {}", e.what());
+        error = e.what();
+    }
+    if (!batch.lines.empty()) {
+        submit();
+    }
+    while (!pending.empty()) {
+        write_oldest();
     }
+    SPDLOG_DEBUG("{} command(s) received, {} rejected", accepted, rejected);
 
-    if (!router_.route(req, res)) {
+    std::string tail;
+    JsonWriter writer(tail);
+    writer.begin_object()
+        .key("received")
+        .value(static_cast<int64_t>(accepted))
+        .key("rejected")
+        .value(static_cast<int64_t>(rejected));
+    if (!error.empty()) {
+        writer.key("error").value(error);
+    }
+    writer.end_object();
+    tail += '\n';
+    res.write_chunk(tail);
+    res.end_chunked();
+}
 
-        throw std::runtime_error("Method not allowed");
+void RequestHandler::process_request(Request &req, Response &res) {
+    // 路径只解码、规范化一次，安全检查与静态文件查找共用结果
+    if (!url::normalize_path(req.path, req.relative_path)) {
+        throw HttpError(403, "Invalid path traversal attempt");
+    }
 
+    switch (router_.route(req, res)) {
+    case Router::Result::Handled:
+        break;
+    case Router::Result::NotFound:
+        throw HttpError(404);
+    case Router::Result::MethodNotAllowed:
+        // Allow 头已由 Router 设置，由 handle_error 一并发送
+        throw HttpError(405);
     }
 }
 
 void RequestHandler::handle_error(const Request &req, Response &res,
                                   const std::exception &e) {
-    SPDLOG_ERROR("Error handling request {}: {}", req.path, e.what());
-
-    if (e.what() == std::string("404 Not Found")) {
-        res.status(404).send("404 Not Found");
-    } else if (e.what() == std::string("Method not allowed")) {
-        res.status(405).send("405 Method Not Allowed");
-    } else if (e.what() == std::string("Invalid path traversal attempt")) {
-        res.status(403).send("403 Forbidden");
-    } else {
-        res.status(500).send("500 Internal Server Error");
+    // 每个失败请求都已记入访问日志，这里只限流记录原因
+    uint64_t suppressed = 0;
+    if (error_log_limit_.allow(suppressed)) {
+        if (suppressed > 0) {
+            SPDLOG_WARN("{} request errors were not logged", suppressed);
+        }
+        SPDLOG_ERROR("Error handling request {}: {}", req.path, e.what());
     }
+
+    // 响应已经开始发送，无法再改为错误响应；未完成的响应会使连接关闭
+    if (res.headers_sent()) {
+        return;
+    }
+
+    int status = error_status(e);
+    res.status(status).send(status_text(status));
 }
\ No newline at end of file
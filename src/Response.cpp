@@ -1,5 +1,11 @@
 #include "Response.h"
+#include "JsonBinary.h"
+#include "JsonValue.h"
+#include "JsonWriter.h"
+#include "ResponseFragments.h"
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -7,113 +13,266 @@
 #include <sstream>
 #include <string>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace fs = std::filesystem;
 
-// Response类实现
-Response::Response(int client_fd) : client_fd_(client_fd), status_code_(200) {
-    // 设置默认头部
-    header("Server", "HttpServer/1.0");
-    headers_["Content-Type"] = "text/plain";
+namespace {
+
+// 每个线程复用的输出缓冲区，超大的响应发送后释放
+std::string &output_buffer() {
+    constexpr size_t kMaxRetained = 1 << 20;
+    thread_local std::string buffer;
+    if (buffer.capacity() > kMaxRetained) {
+        std::string().swap(buffer);
+    }
+    buffer.clear();
+    return buffer;
 }
 
+} // namespace
+
+// Response类实现
+Response::Response(int client_fd, std::pmr::memory_resource *resource)
+    : client_fd_(client_fd), status_code_(200), headers_(resource) {}
+
 Response::~Response() {}
 
+void Response::reset() {
+    status_code_ = 200;
+    headers_.release();
+    headers_sent_ = false;
+    head_only_ = false;
+    chunked_ = false;
+    ended_ = false;
+    keep_alive_ = false;
+    failed_ = false;
+    bytes_sent_ = 0;
+    write_ticks_ = 0;
+}
+
+Response &Response::keep_alive(bool enable) {
+    keep_alive_ = enable;
+    return *this;
+}
+
 Response &Response::status(int code) {
     status_code_ = code;
     return *this;
 }
 
-Response &Response::header(const std::string &key, const std::string &value) {
-    headers_[key] = value;
+Response &Response::header(std::string_view key, std::string_view value) {
+    headers_.set(key, value);
     return *this;
 }
 
-void Response::send_headers() {
-    SPDLOG_DEBUG("send headers {}", status_code_);
-    if (headers_sent_)
+void Response::transmit(std::string_view data) {
+    iovec part = {const_cast<char *>(data.data()), data.size()};
+    transmit(&part, 1);
+}
+
+// 写完全部数据才返回，部分写入时从断点继续。对端已关闭时 send 默认
+// 会触发 SIGPIPE 终止进程，因此用 MSG_NOSIGNAL 改为返回 EPIPE
+void Response::transmit(iovec *parts, size_t count) {
+    if (failed_) {
         return;
-    std::ostringstream headers;
-    headers << "HTTP/1.1 " << status_code_ << " ";
-    switch (status_code_) {
-    case 200:
-        headers << "OK";
-        break;
-    case 404:
-        headers << "Not Found";
-        break;
-    case 500:
-        headers << "Internal Server Error";
-        break;
-    default:
-        headers << "Unknown";
-        break;
-    }
-    headers << "\r\n";
-
-    for (const auto &[key, value] : headers_) {
-        headers << key << ": " << value << "\r\n";
-    }
-
-    headers << "\r\n"; // 空行分隔头部和正文
-
-    std::string headers_str = headers.str();
-    ::send(client_fd_, headers_str.c_str(), headers_str.size(), 0);
-    headers_sent_ = true;
+    }
+    uint64_t begin = trace::now();
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = count;
+    while (message.msg_iovlen > 0) {
+        ssize_t n = ::sendmsg(client_fd_, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            SPDLOG_DEBUG("send failed: {}", std::strerror(errno));
+            failed_ = true;
+            break;
+        }
+        bytes_sent_ += static_cast<uint64_t>(n);
+
+        size_t written = static_cast<size_t>(n);
+        while (message.msg_iovlen > 0 &&
+               written >= message.msg_iov->iov_len) {
+            written -= message.msg_iov->iov_len;
+            message.msg_iov++;
+            message.msg_iovlen--;
+        }
+        if (message.msg_iovlen > 0) {
+            message.msg_iov->iov_base =
+                static_cast<char *>(message.msg_iov->iov_base) + written;
+            message.msg_iov->iov_len -= written;
+        }
+    }
+    write_ticks_ += trace::now() - begin;
 }
 
-void Response::send(const std::string &body_str) {
+Response &Response::head_only(bool enable) {
+    head_only_ = enable;
+    return *this;
+}
+
+void Response::write_head(std::string &out, size_t content_length) {
+    SPDLOG_DEBUG("send headers {}", status_code_);
+
+    out.append(status_line(status_code_));
+    if (!headers_.contains(Header::Server)) {
+        out.append(server_header());
+    }
+    if (!headers_.contains(Header::Date)) {
+        out.append(date_header());
+    }
+    // 1xx 与 204 不能带 Content-Length (RFC 9110 8.6)
+    bool no_content = status_code_ < 200 || status_code_ == 204;
+    if (no_content) {
+        headers_.erase(Header::ContentLength);
+    }
 
-    std::string response = "HTTP/1.1 " + std::to_string(status_code_) + " " +
-                           status_message() + "\r\n";
+    // 默认头部在发送时补上，reset() 因此不需要分配
+    if (!headers_.contains(Header::ContentType)) {
+        out.append("Content-Type: text/plain\r\n");
+    }
 
-    headers_["Content-Length"] = std::to_string(body_str.size());
+    for (auto [key, value] : headers_) {
+        out.append(key).append(": ").append(value).append("\r\n");
+    }
 
-    for (const auto &[key, value] : headers_) {
-        response += key + ": " + value + "\r\n";
+    if (!keep_alive_) {
+        out.append("Connection: close\r\n");
     }
 
-    response += "\r\n";
+    // 自动设置Content-Length，分块传输时改为 Transfer-Encoding
+    if (chunked_) {
+        out.append("Transfer-Encoding: chunked\r\n");
+    } else if (!no_content && !headers_.contains(Header::ContentLength)) {
+        out.append("Content-Length: ");
+        append_decimal(out, content_length);
+        out.append("\r\n");
+    }
+
+    out.append("\r\n"); // 空行分隔头部和正文
+    headers_sent_ = true;
+}
+
+void Response::send(const std::string &body_str) {
+    headers_.erase(Header::ContentLength);
 
-    response += body_str;
+    std::string &out = output_buffer();
+    write_head(out, body_str.size());
+    if (!head_only_) {
+        out.append(body_str);
+    }
 
-    ::send(client_fd_, response.c_str(), response.size(), 0);
+    transmit(out);
+    ended_ = true;
 }
 
 Response &Response::end(const std::string &content) {
-    if (client_fd_ == -1) {
+    return finish(content);
+}
+
+Response &Response::finish(std::string_view content) {
+    if (ended_) {
         spdlog::warn("Response already ended");
         return *this;
     }
 
+    std::string &out = output_buffer();
     if (!headers_sent_) {
-        // 自动设置Content-Length
-        if (headers_.find("Content-Length") == headers_.end()) {
-            header("Content-Length", std::to_string(content.size()));
-        }
+        write_head(out, content.size());
+    }
 
-        // 自动设置Content-Type
-        if (headers_.find("Content-Type") == headers_.end()) {
-            header("Content-Type", "text/plain");
-        }
+    if (!head_only_) {
+        out.append(content);
+    }
+
+    if (!out.empty()) {
+        transmit(out);
+    }
+    ended_ = true;
+    return *this;
+}
+
+Response &Response::begin_chunked() {
+    headers_.erase(Header::ContentLength);
+    chunked_ = true;
+
+    std::string &out = output_buffer();
+    write_head(out, 0);
+    transmit(out);
+    return *this;
+}
+
+Response &Response::write_chunk(std::string_view data) {
+    // 空块表示正文结束，这里直接忽略
+    if (head_only_ || data.empty()) {
+        return *this;
+    }
 
-        send_headers();
+    char size_line[20];
+    size_t n = 0;
+    for (size_t size = data.size(); size != 0; size >>= 4) {
+        size_line[n++] = "0123456789abcdef"[size & 0xf];
     }
+    std::reverse(size_line, size_line + n);
+    size_line[n++] = '\r';
+    size_line[n++] = '\n';
+
+    // 块头、数据和结尾 CRLF 一次系统调用写出，避免拷贝数据
+    iovec parts[3] = {
+        {size_line, n},
+        {const_cast<char *>(data.data()), data.size()},
+        {const_cast<char *>("\r\n"), 2},
+    };
+    transmit(parts, 3);
+    return *this;
+}
 
-    if (!content.empty()) {
-        ::send(client_fd_, content.c_str(), content.size(), 0);
+Response &Response::end_chunked() {
+    if (ended_) {
+        spdlog::warn("Response already ended");
+        return *this;
     }
+    if (!head_only_) {
+        transmit("0\r\n\r\n");
+    }
+    ended_ = true;
+    return *this;
+}
 
-    // 关闭连接
-    close(client_fd_);
-    client_fd_ = -1;
+Response &Response::send_json(const JsonValue &value, bool pretty) {
+    headers_.set(Header::ContentType, "application/json");
+
+    // 序列化结束前写缓冲区就满了，说明结果较大，改为分块发送
+    bool finished = false;
+    JsonWriter writer(
+        [&](std::string_view data) {
+            if (!finished && !chunked_) {
+                begin_chunked();
+            }
+            if (chunked_) {
+                write_chunk(data);
+            } else {
+                finish(data);
+            }
+        },
+        pretty);
+    writer.write(value);
+    finished = true;
+    writer.flush();
+
+    if (chunked_) {
+        end_chunked();
+    }
     return *this;
 }
 
 Response &Response::send_file(const std::string &file_path) {
     SPDLOG_DEBUG("send file {}", file_path);
-    std::ifstream file(file_path, std::ios::binary);
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
     if (!file) {
         return status(404).end("File not found");
     }
@@ -124,24 +283,25 @@ Response &Response::send_file(const std::string &file_path) {
         header("Content-Type", mime);
     }
 
-    // 读取文件内容
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    std::string content = ss.str();
-
-    // 发送响应
-    header("Content-Length", std::to_string(content.size()));
-    send_headers();
-    ::send(client_fd_, content.c_str(), content.size(), 0);
+    size_t file_size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    // 头部和文件内容写入同一个缓冲区，一次发送
+    std::string &out = output_buffer();
+    headers_.erase(Header::ContentLength);
+    write_head(out, file_size);
+    if (!head_only_) {
+        size_t head_size = out.size();
+        out.resize(head_size + file_size);
+        file.read(&out[head_size], static_cast<std::streamsize>(file_size));
+    }
 
-    // 关闭连接
-    close(client_fd_);
-    client_fd_ = -1;
+    transmit(out);
+    ended_ = true;
     return *this;
 }
 
 std::string Response::get_mime_type(const std::string &path) {
-    SPDLOG_INFO("get mime type");
     static const std::unordered_map<std::string, std::string> mime_types = {
         {".html", "text/html"},        {".htm", "text/html"},
         {".css", "text/css"},          {".js", "application/javascript"},
@@ -175,7 +335,7 @@ std::string Response::get_mime_type(const std::string &path) {
 Response &Response::send_directory_listing(const std::string &path,
                                            const std::string &root_dir) {
 
-    SPDLOG_INFO("send directory listing");
+    SPDLOG_DEBUG("send directory listing {}", path);
     // 生成目录列表 HTML
     std::ostringstream html;
     html << "<!DOCTYPE html><html><head><title>Directory "
@@ -207,4 +367,21 @@ Response &Response::send_directory_listing(const std::string &path,
     status(200).header("Content-Type", "text/html").end(html.str());
 
     return *this;
-}
\ No newline at end of file
+}
+
+Response &Response::send_value(const JsonValue &value, json::Format format) {
+    headers_.set(Header::Vary, "Accept");
+    if (format == json::Format::Json) {
+        return send_json(value);
+    }
+
+    std::string body;
+    if (format == json::Format::MsgPack) {
+        headers_.set(Header::ContentType, "application/msgpack");
+        json::encode_msgpack(value, body);
+    } else {
+        headers_.set(Header::ContentType, "application/cbor");
+        json::encode_cbor(value, body);
+    }
+    return finish(body);
+}
@@ -0,0 +1,196 @@
+#include "ResponseFragments.h"
+
+#include <array>
+#include <charconv>
+#include <ctime>
+
+namespace {
+
+constexpr int kMinStatus = 100;
+constexpr int kMaxStatus = 599;
+
+constexpr std::string_view kServerHeader = "Server: HttpServer/1.0\r\n";
+
+std::string_view known_reason(int code) {
+    switch (code) {
+    case 100:
+        return "Continue";
+    case 101:
+        return "Switching Protocols";
+    case 200:
+        return "OK";
+    case 201:
+        return "Created";
+    case 202:
+        return "Accepted";
+    case 204:
+        return "No Content";
+    case 206:
+        return "Partial Content";
+    case 301:
+        return "Moved Permanently";
+    case 302:
+        return "Found";
+    case 303:
+        return "See Other";
+    case 304:
+        return "Not Modified";
+    case 307:
+        return "Temporary Redirect";
+    case 308:
+        return "Permanent Redirect";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 403:
+        return "Forbidden";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 406:
+        return "Not Acceptable";
+    case 408:
+        return "Request Timeout";
+    case 409:
+        return "Conflict";
+    case 411:
+        return "Length Required";
+    case 413:
+        return "Content Too Large";
+    case 414:
+        return "URI Too Long";
+    case 415:
+        return "Unsupported Media Type";
+    case 416:
+        return "Range Not Satisfiable";
+    case 417:
+        return "Expectation Failed";
+    case 422:
+        return "Unprocessable Content";
+    case 429:
+        return "Too Many Requests";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 502:
+        return "Bad Gateway";
+    case 503:
+        return "Service Unavailable";
+    case 504:
+        return "Gateway Timeout";
+    case 505:
+        return "HTTP Version Not Supported";
+    default:
+        return "Unknown Status";
+    }
+}
+
+// 启动时一次性生成所有状态行
+struct StatusLines {
+    std::array<std::string, kMaxStatus - kMinStatus + 1> lines;
+    std::string unknown = "HTTP/1.1 500 Internal Server Error\r\n";
+
+    StatusLines() {
+        for (int code = kMinStatus; code <= kMaxStatus; code++) {
+            std::string &line = lines[code - kMinStatus];
+            line = "HTTP/1.1 ";
+            line += std::to_string(code);
+            line += ' ';
+            line += known_reason(code);
+            line += "\r\n";
+        }
+    }
+};
+
+const StatusLines &status_lines() {
+    static const StatusLines table;
+    return table;
+}
+
+void write_2digits(char *out, int value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+struct DateCache {
+    time_t second = -1;
+    char buffer[64];
+    size_t size = 0;
+
+    void refresh(time_t now) {
+        static constexpr char kDays[7][4] = {"Sun", "Mon", "Tue", "Wed",
+                                             "Thu", "Fri", "Sat"};
+        static constexpr char kMonths[12][4] = {"Jan", "Feb", "Mar", "Apr",
+                                                "May", "Jun", "Jul", "Aug",
+                                                "Sep", "Oct", "Nov", "Dec"};
+        std::tm tm{};
+        gmtime_r(&now, &tm);
+
+        // Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n
+        char *p = buffer;
+        for (char c : std::string_view("Date: ")) {
+            *p++ = c;
+        }
+        for (int i = 0; i < 3; i++) {
+            *p++ = kDays[tm.tm_wday][i];
+        }
+        *p++ = ',';
+        *p++ = ' ';
+        write_2digits(p, tm.tm_mday);
+        p += 2;
+        *p++ = ' ';
+        for (int i = 0; i < 3; i++) {
+            *p++ = kMonths[tm.tm_mon][i];
+        }
+        *p++ = ' ';
+        int year = tm.tm_year + 1900;
+        write_2digits(p, year / 100);
+        write_2digits(p + 2, year % 100);
+        p += 4;
+        *p++ = ' ';
+        write_2digits(p, tm.tm_hour);
+        p[2] = ':';
+        write_2digits(p + 3, tm.tm_min);
+        p[5] = ':';
+        write_2digits(p + 6, tm.tm_sec);
+        p += 8;
+        for (char c : std::string_view(" GMT\r\n")) {
+            *p++ = c;
+        }
+        size = static_cast<size_t>(p - buffer);
+        second = now;
+    }
+};
+
+} // namespace
+
+std::string_view status_line(int code) {
+    if (code < kMinStatus || code > kMaxStatus) {
+        return status_lines().unknown;
+    }
+    return status_lines().lines[code - kMinStatus];
+}
+
+std::string_view reason_phrase(int code) { return known_reason(code); }
+
+std::string_view server_header() { return kServerHeader; }
+
+std::string_view date_header() {
+    thread_local DateCache cache;
+    time_t now = std::time(nullptr);
+    if (now != cache.second) {
+        cache.refresh(now);
+    }
+    return std::string_view(cache.buffer, cache.size);
+}
+
+void append_decimal(std::string &out, size_t value) {
+    char digits[20];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+}
@@ -4,46 +4,156 @@
 #include <spdlog/spdlog.h>
 #include <string>
 
-void Router::add_route(const std::string &method, const std::string &path,
-                       Handler handler) {
-
+Router::Route Router::make_route(const std::string &path, Handler handler) {
     std::string patter_str =
         std::regex_replace(path, std::regex("\\:([\\w]+)"), "([^/]+)");
+    patter_str = std::regex_replace(patter_str, std::regex("\\*"), "(.*)");
     patter_str = "^" + patter_str + "$";
 
-    routes_[method].push_back({std::regex(patter_str), handler});
+    std::vector<std::string> names;
+    std::regex name_pattern("\\:([\\w]+)|\\*");
+    for (std::sregex_iterator it(path.begin(), path.end(), name_pattern), end;
+         it != end; ++it) {
+        names.push_back((*it)[1].matched ? (*it)[1].str() : "*");
+    }
 
-    SPDLOG_DEBUG("Added route: {} {}", method, path);
     SPDLOG_DEBUG("patter_str: {}", patter_str);
+    return {path, std::regex(patter_str), std::move(names),
+            std::move(handler)};
+}
+
+void Router::add_route(Method method, const std::string &path,
+                       Handler handler) {
+    routes_[method_index(method)].push_back(
+        make_route(path, std::move(handler)));
+
+    SPDLOG_DEBUG("Added route: {} {}", method_name(method), path);
+}
+
+void Router::add_route(const std::string &method, const std::string &path,
+                       Handler handler) {
+    Method m = parse_method(method);
+    if (m != Method::Extension) {
+        add_route(m, path, std::move(handler));
+        return;
+    }
+
+    extension_routes_.emplace_back(method,
+                                   make_route(path, std::move(handler)));
+    SPDLOG_DEBUG("Added route: {} {}", method, path);
 }
 
 void Router::add_middleware(Handler middleware) {
     middlewares_.push_back(middleware);
 }
 
-bool Router::route(Request& req, Response& res)
+bool Router::match(const Route &route, std::string_view path,
+                   std::cmatch &matches) {
+    return std::regex_match(path.data(), path.data() + path.size(), matches,
+                            route.path_pattern);
+}
+
+const Router::Route *Router::find(const std::vector<Route> &routes,
+                                  std::string_view path,
+                                  std::cmatch &matches) {
+    for (auto &route : routes) {
+        if (match(route, path, matches)) {
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+void Router::dispatch(const Route &route, const std::cmatch &matches,
+                      Request &req, Response &res) {
+    req.trace.mark(trace::Phase::Route);
+    req.route = route.pattern;
+    for (size_t i = 1; i < matches.size(); i++) {
+        req.params.emplace_back(matches[i].first, matches[i].second);
+        if (i - 1 < route.param_names.size()) {
+            req.param_names.emplace_back(route.param_names[i - 1]);
+        }
+    }
+    route.handler(req, res);
+}
+
+Router::Result Router::route(Request& req, Response& res)
 {
     // for (auto& middleware : middlewares_) {
     //     middleware(req, res);
     //     if (res.sent()) return true; 
     // }
 
-    if (routes_.find(req.method) != routes_.end()) {
-        
-        for (auto& route : routes_[req.method]) {
-            std::smatch matches;
-            if (std::regex_match(req.path, matches, route.path_pattern)) {
-                for (size_t i = 1; i < matches.size(); i++) {
-                    req.params.push_back(matches[i].str());
-                }
-                route.handler(req, res);
-                return true;
+    std::cmatch matches;
+
+    if (req.method == Method::Extension) {
+        for (auto &[name, route] : extension_routes_) {
+            if (name == std::string_view(req.extension_method) &&
+                match(route, req.path, matches)) {
+                dispatch(route, matches, req, res);
+                return Result::Handled;
             }
         }
+    } else if (const Route *route =
+                   find(routes_[method_index(req.method)], req.path, matches)) {
+        dispatch(*route, matches, req, res);
+        return Result::Handled;
+    }
+
+    // 未注册 HEAD 时复用 GET 路由，只发送头部
+    if (req.method == Method::Head) {
+        if (const Route *route =
+                find(routes_[method_index(Method::Get)], req.path, matches)) {
+            res.head_only();
+            dispatch(*route, matches, req, res);
+            return Result::Handled;
+        }
+    }
+
+    std::string allow = allowed_methods(req.path);
+    req.trace.mark(trace::Phase::Route);
+    if (allow.empty()) {
+        return Result::NotFound;
+    }
 
-    } else {
-        SPDLOG_ERROR("request metod not found");
+    res.header("Allow", allow);
+    if (req.method == Method::Options) {
+        res.status(204).send("");
+        return Result::Handled;
     }
 
-    return false;
-}
\ No newline at end of file
+    SPDLOG_DEBUG("method not allowed for {}, allow: {}", req.path, allow);
+    return Result::MethodNotAllowed;
+}
+
+std::string Router::allowed_methods(std::string_view path) const {
+    // OPTIONS * 询问的是整个服务器支持的方法
+    bool any_path = path == "*";
+
+    MethodMask mask = 0;
+    std::cmatch matches;
+    for (size_t i = 0; i < method_index(Method::Extension); i++) {
+        if (!routes_[i].empty() &&
+            (any_path || find(routes_[i], path, matches))) {
+            mask |= method_bit(static_cast<Method>(i));
+        }
+    }
+
+    std::string allow_extensions;
+    for (auto &[name, route] : extension_routes_) {
+        if (any_path || match(route, path, matches)) {
+            allow_extensions += ", " + name;
+        }
+    }
+
+    if (mask == 0 && allow_extensions.empty()) {
+        return "";
+    }
+
+    if (mask & method_bit(Method::Get)) {
+        mask |= method_bit(Method::Head);
+    }
+    mask |= method_bit(Method::Options);
+
+    return allow_header_value(mask) + allow_extensions;
+}
@@ -0,0 +1,77 @@
+#include "Trace.h"
+
+#include <thread>
+
+#ifdef TRACE_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+namespace trace {
+
+namespace {
+
+// 频率随 P 状态变化或各核不同步的 TSC 不能用来计时
+bool detect_invariant_tsc() {
+#ifdef TRACE_HAVE_TSC
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) ||
+        eax < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+// 每微秒的计数，对照 steady_clock 测量
+double measure_ticks_per_us() {
+    if (!detail::use_tsc) {
+        return 1000.0;
+    }
+    using namespace std::chrono;
+    auto clock_begin = steady_clock::now();
+    uint64_t ticks_begin = now();
+    std::this_thread::sleep_for(milliseconds(20));
+    auto clock_end = steady_clock::now();
+    uint64_t ticks_end = now();
+    auto us = duration_cast<duration<double, std::micro>>(clock_end -
+                                                          clock_begin);
+    return static_cast<double>(ticks_end - ticks_begin) / us.count();
+}
+
+double ticks_per_us() {
+    static const double value = measure_ticks_per_us();
+    return value;
+}
+
+const char *const kPhaseNames[kPhaseCount] = {
+    "accept", "read", "parse", "route", "handle", "write",
+};
+
+} // namespace
+
+namespace detail {
+const bool use_tsc = detect_invariant_tsc();
+} // namespace detail
+
+uint64_t to_us(uint64_t ticks) {
+    return static_cast<uint64_t>(static_cast<double>(ticks) / ticks_per_us());
+}
+
+void calibrate() { ticks_per_us(); }
+
+const char *phase_name(Phase phase) {
+    return kPhaseNames[static_cast<size_t>(phase)];
+}
+
+std::array<uint64_t, kPhaseCount> RequestTrace::phases_us() const {
+    std::array<uint64_t, kPhaseCount> us;
+    for (size_t i = 0; i < kPhaseCount; i++) {
+        us[i] = to_us(phases_[i]);
+    }
+    return us;
+}
+
+} // namespace trace
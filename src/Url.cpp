@@ -0,0 +1,226 @@
+#include "Url.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define URL_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define URL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace url {
+
+namespace {
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+size_t find_escape_scalar(std::string_view s, size_t from, bool plus) {
+    for (size_t i = from; i < s.size(); i++) {
+        if (s[i] == '%' || (plus && s[i] == '+')) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+} // namespace
+
+void PathSegments::iterator::advance() {
+    while (!rest_.empty()) {
+        size_t slash = rest_.find('/');
+        std::string_view segment = rest_.substr(0, slash);
+        rest_.remove_prefix(slash == std::string_view::npos ? rest_.size()
+                                                            : slash + 1);
+        if (!segment.empty()) {
+            current_ = segment;
+            return;
+        }
+    }
+    current_ = {};
+}
+
+size_t PathSegments::size() const {
+    size_t n = 0;
+    for (auto it = begin(); it != end(); ++it) {
+        n++;
+    }
+    return n;
+}
+
+std::string_view PathSegments::back() const {
+    std::string_view last;
+    for (std::string_view segment : *this) {
+        last = segment;
+    }
+    return last;
+}
+
+void QueryParams::iterator::advance() {
+    while (!rest_.empty()) {
+        size_t amp = rest_.find('&');
+        std::string_view pair = rest_.substr(0, amp);
+        rest_.remove_prefix(amp == std::string_view::npos ? rest_.size()
+                                                          : amp + 1);
+        if (pair.empty()) {
+            continue;
+        }
+        size_t eq = pair.find('=');
+        current_.key = pair.substr(0, eq);
+        current_.value = eq == std::string_view::npos ? std::string_view()
+                                                      : pair.substr(eq + 1);
+        return;
+    }
+    rest_ = {};
+    current_ = {};
+}
+
+bool QueryParams::find(std::string_view key, std::string_view &value) const {
+    for (const QueryParam &param : *this) {
+        if (param.key == key) {
+            value = param.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t find_escape(std::string_view s, bool plus_as_space) {
+    size_t i = 0;
+#if defined(URL_X86)
+    const __m128i percent = _mm_set1_epi8('%');
+    // 不处理 '+' 时与 '%' 比较两次，结果不变
+    const __m128i plus = _mm_set1_epi8(plus_as_space ? '+' : '%');
+    for (; i + 16 <= s.size(); i += 16) {
+        __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(s.data() + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(v, percent), _mm_cmpeq_epi8(v, plus)));
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+#elif defined(URL_NEON)
+    const uint8x16_t percent = vdupq_n_u8('%');
+    const uint8x16_t plus = vdupq_n_u8(plus_as_space ? '+' : '%');
+    for (; i + 16 <= s.size(); i += 16) {
+        uint8x16_t v =
+            vld1q_u8(reinterpret_cast<const uint8_t *>(s.data() + i));
+        uint8x16_t hit = vorrq_u8(vceqq_u8(v, percent), vceqq_u8(v, plus));
+        if (vmaxvq_u8(hit) != 0) {
+            return find_escape_scalar(s, i, plus_as_space);
+        }
+    }
+#endif
+    return find_escape_scalar(s, i, plus_as_space);
+}
+
+namespace {
+
+template <typename String>
+void decode_into(std::string_view s, String &out, bool plus_as_space) {
+    // 不需要解码的部分整段复制，用 find_escape 跳到下一个转义字符
+    while (!s.empty()) {
+        size_t escape = find_escape(s, plus_as_space);
+        if (escape == std::string_view::npos) {
+            out.append(s);
+            return;
+        }
+        out.append(s.data(), escape);
+        s.remove_prefix(escape);
+
+        if (s[0] == '+') {
+            out += ' ';
+            s.remove_prefix(1);
+        } else if (s.size() >= 3 && hex_value(s[1]) >= 0 &&
+                   hex_value(s[2]) >= 0) {
+            out += static_cast<char>(hex_value(s[1]) * 16 + hex_value(s[2]));
+            s.remove_prefix(3);
+        } else {
+            out += '%';
+            s.remove_prefix(1);
+        }
+    }
+}
+
+} // namespace
+
+void percent_decode(std::string_view s, std::string &out,
+                    bool plus_as_space) {
+    decode_into(s, out, plus_as_space);
+}
+
+void percent_decode(std::string_view s, std::pmr::string &out,
+                    bool plus_as_space) {
+    decode_into(s, out, plus_as_space);
+}
+
+std::string percent_decode(std::string_view s, bool plus_as_space) {
+    std::string out;
+    percent_decode(s, out, plus_as_space);
+    return out;
+}
+
+namespace {
+
+template <typename String>
+bool normalize_into(std::string_view path, String &out) {
+    out.clear();
+    while (!path.empty()) {
+        size_t slash = path.find('/');
+        std::string_view segment = path.substr(0, slash);
+        path.remove_prefix(slash == std::string_view::npos ? path.size()
+                                                           : slash + 1);
+        if (segment.empty() || segment == ".") {
+            continue;
+        }
+        if (segment == "..") {
+            if (out.empty()) {
+                return false;
+            }
+            size_t parent = out.rfind('/');
+            out.resize(parent == std::string::npos ? 0 : parent);
+            continue;
+        }
+
+        // 段直接解码到 out 的末尾，检查不通过时整个路径作废
+        if (!out.empty()) {
+            out += '/';
+        }
+        size_t start = out.size();
+        if (find_escape(segment, false) == std::string_view::npos) {
+            if (segment.find('\0') != std::string_view::npos) {
+                return false;
+            }
+            out.append(segment);
+            continue;
+        }
+        decode_into(segment, out, false);
+        std::string_view decoded(out.data() + start, out.size() - start);
+        if (decoded == "." || decoded == ".." ||
+            decoded.find_first_of(std::string_view("/\0", 2)) !=
+                std::string_view::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool normalize_path(std::string_view path, std::string &out) {
+    return normalize_into(path, out);
+}
+
+bool normalize_path(std::string_view path, std::pmr::string &out) {
+    return normalize_into(path, out);
+}
+
+} // namespace url
@@ -1,10 +1,2299 @@
 #include <gtest/gtest.h>
 
+#include "JsonBinary.h"
+#include "JsonBind.h"
+#include "JsonDocument.h"
+#include "JsonLazy.h"
+#include "JsonStream.h"
+#include "JsonStructural.h"
+#include "AccessLog.h"
+#include "BinaryAccessLog.h"
+#include "HeaderMap.h"
+#include "HttpError.h"
+#include "HttpServer.h"
+#include "JsonValue.h"
+#include "JsonWriter.h"
+#include "Metrics.h"
+#include "Multipart.h"
+#include "ResponseFragments.h"
+#include "Router.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "Url.h"
+
+#include "JsonDetail.h"
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <type_traits>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 统计全局 operator new 的调用次数
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+// 执行 fn 期间发生的分配次数
+template <typename F> size_t count_allocations(F &&fn) {
+    size_t before = g_allocations.load();
+    fn();
+    return g_allocations.load() - before;
+}
+
+std::string nested_arrays(int depth) {
+    return std::string(depth, '[') + "1" + std::string(depth, ']');
+}
+
+std::string nested_objects(int depth) {
+    std::string s;
+    for (int i = 0; i < depth; i++) {
+        s += "{\"a\":";
+    }
+    s += "1";
+    s += std::string(depth, '}');
+    return s;
+}
+
+// 在套接字对的一端执行 fn(fd)，返回另一端收到的全部数据
+template <typename F> std::string capture_output(F &&fn) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return {};
+    }
+    fn(fds[0]);
+    ::close(fds[0]);
+    std::string out;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::read(fds[1], buffer, sizeof(buffer))) > 0) {
+        out.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fds[1]);
+    return out;
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
 TEST(SimpleTest, BasicAssertion) {
     EXPECT_EQ(1 + 1, 2);
 }
 
+// vector 扩容时只有 noexcept 的移动构造才会被使用
+TEST(JsonValueTest, NothrowMovable) {
+    EXPECT_TRUE(std::is_nothrow_move_constructible_v<JsonValue>);
+}
+
+TEST(JsonValueTest, CompactLayout) {
+    EXPECT_EQ(sizeof(JsonValue), 16u);
+
+    // 不超过 14 字节的字符串存放在值内
+    size_t n = count_allocations([] {
+        JsonValue empty("");
+        JsonValue small("fourteen bytes");
+        EXPECT_EQ(small.as_string(), "fourteen bytes");
+        EXPECT_TRUE(empty.is_string());
+        EXPECT_EQ(empty.as_string(), "");
+    });
+    EXPECT_EQ(n, 0u);
+
+    JsonValue large("fifteen bytes!!");
+    EXPECT_EQ(large.as_string(), "fifteen bytes!!");
+    JsonValue copy(large);
+    EXPECT_EQ(copy.as_string(), "fifteen bytes!!");
+    EXPECT_NE(copy.as_string().data(), large.as_string().data());
+
+    EXPECT_THROW(large.as_number(), std::bad_variant_access);
+    EXPECT_THROW(JsonValue(1.5).as_integer(), std::bad_variant_access);
+    EXPECT_EQ(JsonValue(7).as_number(), 7.0);
+}
+
+// 容器从右值构造时只分配一次外层，移动值本身不分配
+TEST(JsonValueTest, MoveConstructionDoesNotCopy) {
+    JsonValue::Array array(100, JsonValue("a string longer than SSO"));
+    JsonValue::Object object;
+    object["key"] = JsonValue(array);
+
+    size_t n = count_allocations([&] {
+        JsonValue a(std::move(array));
+        JsonValue o(std::move(object));
+        JsonValue moved_a(std::move(a));
+        JsonValue moved_o;
+        moved_o = std::move(o);
+    });
+    EXPECT_EQ(n, 2u);
+}
+
+// 把子元素移动赋值给其所在的容器
+TEST(JsonValueTest, MoveAssignFromChild) {
+    JsonValue v = JsonValue::parse(R"([["a long string in a child"]])");
+    v = std::move(v.as_array()[0]);
+    ASSERT_TRUE(v.is_array());
+    EXPECT_EQ(v.as_array()[0].as_string(), "a long string in a child");
+    v = v;
+    EXPECT_EQ(v.as_array()[0].as_string(), "a long string in a child");
+}
+
+TEST(JsonValueTest, EmplaceAndMutableAccess) {
+    JsonValue array{JsonValue::Array()};
+    array.emplace_back(1);
+    array.emplace_back("two");
+    array.as_array()[0] = JsonValue(3);
+    ASSERT_EQ(array.as_array().size(), 2u);
+    EXPECT_EQ(array.as_array()[0].as_integer(), 3);
+    EXPECT_EQ(array.as_array()[1].as_string(), "two");
+
+    JsonValue object{JsonValue::Object()};
+    object.emplace("k", 1);
+    object.emplace("k", "replaced");
+    object.as_object()["n"] = JsonValue(nullptr);
+    EXPECT_EQ(object.as_object().at("k").as_string(), "replaced");
+    EXPECT_TRUE(object.as_object().at("n").is_null());
+
+    object.as_object().at("k") = JsonValue::Array{1, 2};
+    object.as_object().at("k").emplace_back(3);
+    EXPECT_EQ(object.as_object().at("k").as_array().size(), 3u);
+}
+
+// 嵌套的每一层只分配自身的容器和值内指向它的堆块，不复制子树
+TEST(JsonValueTest, ParseAllocationsLinearInDepth) {
+    const int depth = 200;
+    std::string arrays = nested_arrays(depth);
+    std::string objects = nested_objects(depth);
+    // 预热线程内复用的索引缓冲区
+    JsonValue::parse(arrays);
+    JsonValue::parse(objects);
+
+    EXPECT_LE(count_allocations([&] { JsonValue::parse(arrays); }),
+              static_cast<size_t>(2 * depth + 1));
+    EXPECT_LE(count_allocations([&] { JsonValue::parse(objects); }),
+              static_cast<size_t>(2 * depth + 1));
+}
+
+TEST(JsonValueTest, ParseDuplicateKeyKeepsLast) {
+    JsonValue v = JsonValue::parse(R"({"a":1,"a":{"b":[2]}})");
+    EXPECT_EQ(v.as_object().size(), 1u);
+    EXPECT_EQ(v.as_object().at("a").as_object().at("b").as_array()[0]
+                  .as_integer(),
+              2);
+}
+
+TEST(JsonValueTest, DocumentToValueAllocationsLinearInDepth) {
+    const int depth = 200;
+    std::string arrays = nested_arrays(depth);
+    JsonDocument doc = JsonDocument::parse(arrays);
+
+    // 每层一个 reserve 过的 vector 及其堆块
+    EXPECT_LE(count_allocations([&] { doc.root().to_value(); }),
+              static_cast<size_t>(2 * depth + 1));
+}
+
+TEST(ArenaTest, AllocatesAlignedAndResetsToLargestBlock) {
+    Arena arena(256);
+    EXPECT_EQ(arena.block_count(), 0u);
+    char *a = arena.allocate_array<char>(3);
+    double *d = arena.allocate_array<double>(4);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % alignof(double), 0u);
+    EXPECT_GT(reinterpret_cast<char *>(d), a);
+    EXPECT_EQ(arena.block_count(), 1u);
+
+    // 超过当前块的分配开新块，超大分配独占一个块
+    arena.allocate(240);
+    arena.allocate(10000);
+    EXPECT_EQ(arena.block_count(), 3u);
+    size_t reserved = arena.bytes_reserved();
+
+    std::string_view copy = arena.copy_string("hello");
+    EXPECT_EQ(copy, "hello");
+    EXPECT_TRUE(arena.copy_string("").empty());
+
+    arena.reset();
+    EXPECT_EQ(arena.block_count(), 1u);
+    EXPECT_GE(arena.bytes_reserved(), 10000u);
+    EXPECT_LT(arena.bytes_reserved(), reserved);
+    // 复用保留的块，不再向系统要内存
+    EXPECT_EQ(count_allocations([&] { arena.allocate(5000); }), 0u);
+
+    Arena moved(std::move(arena));
+    EXPECT_EQ(moved.block_count(), 1u);
+    EXPECT_EQ(arena.block_count(), 0u);
+    EXPECT_EQ(arena.bytes_reserved(), 0u);
+}
+
+TEST(JsonDocumentTest, ParsesScalarsAndContainers) {
+    std::string json = R"({"s":"x","t":true,"n":null,"a":[1,2.5,[]],"o":{}})";
+    JsonDocument doc = JsonDocument::parse(json);
+    const JsonNode &root = doc.root();
+    ASSERT_TRUE(root.is_object());
+    EXPECT_EQ(root.size(), 5u);
+    EXPECT_EQ(root.at("s").as_string(), "x");
+    EXPECT_TRUE(root.at("t").as_bool());
+    EXPECT_TRUE(root.at("n").is_null());
+    EXPECT_EQ(root.find("missing"), nullptr);
+    EXPECT_THROW(root.at("missing"), std::out_of_range);
+
+    const JsonNode &a = root.at("a");
+    ASSERT_EQ(a.size(), 3u);
+    EXPECT_EQ(a[0].as_integer(), 1);
+    EXPECT_EQ(a[1].as_number(), 2.5);
+    EXPECT_TRUE(a[2].is_array());
+    EXPECT_EQ(a[2].size(), 0u);
+    EXPECT_THROW(a[3], std::out_of_range);
+    EXPECT_TRUE(root.at("o").is_object());
+    EXPECT_EQ(root.at("o").members_begin(), root.at("o").members_end());
+
+    EXPECT_THROW(root.at("s").as_number(), std::runtime_error);
+    EXPECT_THROW(root.at("t").as_string(), std::runtime_error);
+    EXPECT_EQ(doc.root().to_value().dump(), JsonValue::parse(json).dump());
+}
+
+TEST(JsonDocumentTest, KeepsIntegersExact) {
+    // 9007199254740993 = 2^53 + 1，存成 double 会变成 ...992
+    std::string json = "[9007199254740993,9223372036854775807,"
+                       "-9223372036854775808,9223372036854775808,"
+                       "-0,0,1.0,1e3]";
+    JsonDocument doc = JsonDocument::parse(json);
+    const JsonNode &root = doc.root();
+    ASSERT_EQ(root.size(), 8u);
+
+    EXPECT_TRUE(root[0].is_integer());
+    EXPECT_EQ(root[0].as_integer(), 9007199254740993);
+    EXPECT_EQ(root[1].as_integer(), std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(root[2].as_integer(), std::numeric_limits<int64_t>::min());
+    // 超出 int64 的整数退回 double
+    EXPECT_TRUE(root[3].is_number());
+    EXPECT_FALSE(root[3].is_integer());
+    EXPECT_EQ(root[3].as_number(), 9223372036854775808.0);
+    EXPECT_THROW(root[3].as_integer(), std::runtime_error);
+    // "-0" 保留符号，按浮点处理
+    EXPECT_FALSE(root[4].is_integer());
+    EXPECT_TRUE(std::signbit(root[4].as_number()));
+    EXPECT_TRUE(root[5].is_integer());
+    EXPECT_FALSE(root[6].is_integer());
+    EXPECT_FALSE(root[7].is_integer());
+    EXPECT_EQ(root[7].as_number(), 1000.0);
+    EXPECT_EQ(root[0].as_number(), 9007199254740992.0);
+
+    // 转为 JsonValue 时整数不经过 double
+    JsonValue value = root.to_value();
+    EXPECT_EQ(value.as_array()[0].as_integer(), 9007199254740993);
+    EXPECT_EQ(value.as_array()[2].as_integer(),
+              std::numeric_limits<int64_t>::min());
+    EXPECT_FALSE(value.as_array()[3].is_integer());
+    EXPECT_EQ(value.dump(), JsonValue::parse(json).dump());
+    std::string written;
+    JsonWriter(written).write(root);
+    EXPECT_EQ(written, value.dump());
+
+    // 区分整数的标志放在原有的填充字节里，节点不变大
+    EXPECT_EQ(sizeof(JsonNode), 16u);
+}
+
+TEST(JsonDocumentTest, StringsReferenceInputUnlessEscaped) {
+    std::string json = R"(["plain","a\nb",{"k\u0041":"v"}])";
+    JsonDocument doc = JsonDocument::parse(json);
+    const JsonNode &root = doc.root();
+    auto in_input = [&](std::string_view s) {
+        return s.data() >= json.data() && s.data() < json.data() + json.size();
+    };
+
+    EXPECT_EQ(root[0].as_string(), "plain");
+    EXPECT_TRUE(in_input(root[0].as_string()));
+    EXPECT_EQ(root[1].as_string(), "a\nb");
+    EXPECT_FALSE(in_input(root[1].as_string()));
+    const JsonMember &member = *root[2].members_begin();
+    EXPECT_EQ(member.key, "kA");
+    EXPECT_FALSE(in_input(member.key));
+    EXPECT_TRUE(in_input(member.value.as_string()));
+
+    // 整个文档只占一个 arena 块
+    EXPECT_EQ(doc.arena().block_count(), 1u);
+}
+
+TEST(JsonDocumentTest, RejectsMalformedInput) {
+    for (const char *json :
+         {"", "[1,]", "{\"a\" 1}", "[1 2]", "{\"a\":1,}", "01", "1e400",
+          "[\"x]", "{1:2}", "[1] x"}) {
+        EXPECT_THROW(JsonDocument::parse(json), std::runtime_error) << json;
+    }
+    std::string deep(2000, '[');
+    deep += std::string(2000, ']');
+    EXPECT_THROW(JsonDocument::parse(deep), std::runtime_error);
+}
+
+TEST(JsonValueTest, ElementReaderAllocationsLinearInDepth) {
+    const int depth = 200;
+    std::string objects = "[" + nested_objects(depth) + "]";
+    size_t elements = 0;
+
+    // 每层一个 map 节点和一个堆块，外加帧栈扩容等对数级的开销
+    size_t n = count_allocations([&] {
+        JsonElementReader reader([&](const JsonValue &) { elements++; });
+        JsonStreamParser parser(reader);
+        parser.feed(objects);
+        parser.finish();
+    });
+    EXPECT_EQ(elements, 1u);
+    EXPECT_LE(n, static_cast<size_t>(3 * depth));
+}
+
+namespace {
+
+struct Point {
+    int64_t x = 0;
+    std::optional<std::string> label;
+    std::vector<double> weights;
+};
+JSON_BIND(Point, x, label, weights)
+
+const char *kSample =
+    R"({"a":[1,-1,255,-129,65536,-2147483649,4294967296,1.5,-0.25],)"
+    R"("b":{"":null,"t":true,"f":false},)"
+    R"("s":"fourteen bytes and then some \u00e9\u4e2d"})";
+
+} // namespace
+
+TEST(JsonBinaryTest, MsgPackRoundTrip) {
+    JsonValue value = JsonValue::parse(kSample);
+    std::string packed;
+    json::encode_msgpack(value, packed);
+    EXPECT_EQ(json::decode_msgpack(packed).dump(), value.dump());
+
+    // 固定长度的小整数、短字符串和映射各占一个字节的头部
+    packed.clear();
+    json::encode_msgpack(JsonValue::parse(R"({"a":1})"), packed);
+    EXPECT_EQ(packed, std::string("\x81\xa1" "a" "\x01"));
+}
+
+TEST(JsonBinaryTest, CborRoundTrip) {
+    JsonValue value = JsonValue::parse(kSample);
+    std::string encoded;
+    json::encode_cbor(value, encoded);
+    EXPECT_EQ(json::decode_cbor(encoded).dump(), value.dump());
+
+    // 不定长数组与半精度浮点数
+    std::string indefinite("\x9f\x01\xf9\x3c\x00\xff", 6);
+    JsonValue decoded = json::decode_cbor(indefinite);
+    ASSERT_EQ(decoded.as_array().size(), 2u);
+    EXPECT_EQ(decoded.as_array()[0].as_integer(), 1);
+    EXPECT_FALSE(decoded.as_array()[1].is_integer());
+    EXPECT_EQ(decoded.as_array()[1].as_number(), 1.0);
+}
+
+TEST(JsonBinaryTest, RejectsMalformedInput) {
+    EXPECT_THROW(json::decode_msgpack(std::string("\x92\x01", 2)),
+                 std::runtime_error);
+    EXPECT_THROW(json::decode_msgpack(std::string("\x01\x01", 2)),
+                 std::runtime_error);
+    // 键不是字符串
+    EXPECT_THROW(json::decode_cbor(std::string("\xa1\x01\x01", 3)),
+                 std::runtime_error);
+    // 数组长度超过剩余数据，不应预先分配
+    EXPECT_THROW(json::decode_cbor(std::string("\x9b\xff\xff\xff\xff"
+                                               "\xff\xff\xff\xff", 9)),
+                 std::runtime_error);
+}
+
+TEST(JsonBindTest, FromValueMatchesFromJson) {
+    const char *text = R"({"x":3,"label":"p","weights":[0.5,2],"extra":{}})";
+    Point a, b;
+    ASSERT_TRUE(json::from_json(text, a));
+    ASSERT_TRUE(json::from_value(JsonValue::parse(text), b));
+    EXPECT_EQ(a.x, b.x);
+    EXPECT_EQ(a.label, b.label);
+    EXPECT_EQ(a.weights, b.weights);
+
+    std::string error;
+    Point c;
+    EXPECT_FALSE(json::from_value(JsonValue::parse(R"({"x":1.5})"), c,
+                                  &error));
+    EXPECT_EQ(error, "Expected integer");
+}
+
+TEST(JsonLineSplitterTest, SplitsAcrossChunks) {
+    const std::string input = "{\"a\":1}\r\n\n  \n[2,\n3]\n\"tail\"";
+    // 每种切分方式都应得到同样的行
+    for (size_t step = 1; step <= input.size(); step++) {
+        std::vector<std::pair<std::string, size_t>> lines;
+        JsonLineSplitter splitter([&](std::string_view line, size_t number) {
+            lines.emplace_back(line, number);
+        });
+        for (size_t i = 0; i < input.size(); i += step) {
+            splitter.feed(std::string_view(input).substr(i, step));
+        }
+        splitter.finish();
+
+        ASSERT_EQ(lines.size(), 4u);
+        EXPECT_EQ(lines[0], std::make_pair(std::string("{\"a\":1}"), 1ul));
+        EXPECT_EQ(lines[1], std::make_pair(std::string("[2,"), 4ul));
+        EXPECT_EQ(lines[2], std::make_pair(std::string("3]"), 5ul));
+        EXPECT_EQ(lines[3], std::make_pair(std::string("\"tail\""), 6ul));
+        EXPECT_EQ(splitter.count(), 4u);
+    }
+}
+
+TEST(JsonLineSplitterTest, RejectsLongLine) {
+    size_t lines = 0;
+    JsonLineSplitter splitter([&](std::string_view, size_t) { lines++; }, 8);
+    splitter.feed("12345678\n1234");
+    EXPECT_THROW(splitter.feed("56789"), JsonParseError);
+    EXPECT_EQ(lines, 1u);
+}
+
+TEST(ThreadPoolTest, RunsTasksAndForwardsExceptions) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.size(), 3u);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; i++) {
+        results.push_back(pool.submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+
+    auto failed = pool.submit([]() -> int { throw std::runtime_error("x"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+// 连接复用 Request/Response 后，每个请求的容器都落在请求级 arena 中
+TEST(RequestArenaTest, SteadyStateRequestsDoNotAllocate) {
+    std::string raw =
+        "POST /api/v1/commands/batch?dry_run=1 HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "User-Agent: test-client/1.0\r\n"
+        "Accept: application/json\r\n"
+        "Content-Type: application/json\r\n";
+    // 超过内联容量的头部放在溢出表中
+    for (int i = 0; i < 20; i++) {
+        raw += "X-Custom-Header-" + std::to_string(i) + ": value\r\n";
+    }
+    std::string body = R"({"host":"10.0.0.1","padding":")" +
+                       std::string(200, 'x') + "\"}";
+    raw += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    raw += body;
+
+    Request req;
+    Response res(-1, req.resource());
+    auto handle_one = [&] {
+        res.reset();
+        req.reset();
+        EXPECT_EQ(parse_request(raw, req), raw.size());
+        EXPECT_EQ(req.body_str(), body);
+        EXPECT_EQ(req.path_segments().size(), 4u);
+        EXPECT_EQ(req.query_string, "dry_run=1");
+        EXPECT_EQ(req.headers.get("X-Custom-Header-19"), "value");
+        EXPECT_TRUE(req.keep_alive());
+        res.status(200)
+            .header("Content-Type", "application/json")
+            .header("X-Request-Path", req.path);
+        res.end("{}");
+    };
+
+    // 第一个请求预热线程内的输出缓冲区
+    handle_one();
+    EXPECT_EQ(count_allocations([&] {
+                  for (int i = 0; i < 100; i++) {
+                      handle_one();
+                  }
+              }),
+              0u);
+}
+
+TEST(RequestArenaTest, ParseRequestLeavesPipelinedBytes) {
+    std::string first = "GET /a//b/ HTTP/1.0\r\nConnection: keep-alive\r\n"
+                        "Content-Length: 3\r\n\r\nabc";
+    std::string raw = first + "GET /next HTTP/1.1\r\n\r\n";
+
+    Request req;
+    EXPECT_EQ(parse_request(raw, req), first.size());
+    EXPECT_EQ(req.method, Method::Get);
+    EXPECT_EQ(req.version, "HTTP/1.0");
+    ASSERT_EQ(req.path_segments().size(), 2u);
+    EXPECT_EQ(req.path_segments().back(), "b");
+    EXPECT_TRUE(req.keep_alive());
+    EXPECT_EQ(req.body_str(), "abc");
+
+    req.reset();
+    EXPECT_TRUE(req.path.empty());
+    EXPECT_TRUE(req.headers.empty());
+    EXPECT_THROW(parse_request("GET / HTTP/1.1\r\n", req), std::runtime_error);
+}
+
+TEST(UrlTest, PathSegmentsSkipEmpty) {
+    std::vector<std::string_view> segments;
+    for (std::string_view segment : url::PathSegments("//a/bc///d/")) {
+        segments.push_back(segment);
+    }
+    EXPECT_EQ(segments, (std::vector<std::string_view>{"a", "bc", "d"}));
+    EXPECT_TRUE(url::PathSegments("/").empty());
+    EXPECT_EQ(url::PathSegments("/").back(), "");
+}
+
+TEST(UrlTest, QueryParamsAreRawViews) {
+    url::QueryParams query("a=1&&flag&b=x%20y&a=2");
+    std::vector<std::pair<std::string_view, std::string_view>> pairs;
+    for (const url::QueryParam &param : query) {
+        pairs.emplace_back(param.key, param.value);
+    }
+    ASSERT_EQ(pairs.size(), 4u);
+    EXPECT_EQ(pairs[1].first, "flag");
+    EXPECT_EQ(pairs[1].second, "");
+    EXPECT_EQ(pairs[2].second, "x%20y");
+
+    std::string_view value;
+    EXPECT_TRUE(query.find("a", value));
+    EXPECT_EQ(value, "1");
+    EXPECT_FALSE(query.find("c", value));
+}
+
+TEST(UrlTest, PercentDecode) {
+    EXPECT_EQ(url::percent_decode("a+b%2Fc%zz%4", true), "a b/c%zz%4");
+    EXPECT_EQ(url::percent_decode("a+b%2f", false), "a+b/");
+
+    // 转义字符落在 SIMD 分组内、分组边界与尾部时结果一致
+    for (size_t pos = 0; pos < 40; pos++) {
+        std::string s(40, 'x');
+        s[pos] = '+';
+        EXPECT_EQ(url::find_escape(s, true), pos);
+        EXPECT_EQ(url::find_escape(s, false), std::string_view::npos);
+    }
+    std::string long_text(100, 'y');
+    EXPECT_EQ(url::percent_decode(long_text + "%41" + long_text, false),
+              long_text + "A" + long_text);
+}
+
+TEST(UrlTest, RequestQueryAndPathParams) {
+    Request req;
+    parse_request("GET /users/j%C3%B6rg/files/a%2Bb/c.txt?q=a+b&q=c&x "
+                  "HTTP/1.1\r\n\r\n",
+                  req);
+    EXPECT_EQ(req.path, "/users/j%C3%B6rg/files/a%2Bb/c.txt");
+
+    auto query = req.query_params();
+    EXPECT_EQ(query.at("q"), "a b");
+    EXPECT_EQ(query.at("x"), "");
+
+    Router router;
+    std::string user, rest;
+    router.add_route(Method::Get, "/users/:name/files/*",
+                     [&](Request &r, Response &) {
+                         user = r.get_path_param("name");
+                         rest = r.get_path_param("*");
+                     });
+    Response res(-1, req.resource());
+    EXPECT_EQ(router.route(req, res), Router::Result::Handled);
+    EXPECT_EQ(user, "j\xC3\xB6rg");
+    EXPECT_EQ(rest, "a+b/c.txt");
+    EXPECT_EQ(req.get_path_param("missing"), "");
+}
+
+TEST(UrlTest, NormalizePath) {
+    std::string out;
+    EXPECT_TRUE(url::normalize_path("/", out));
+    EXPECT_EQ(out, "");
+    EXPECT_TRUE(url::normalize_path("//a/./b/../c%20d/", out));
+    EXPECT_EQ(out, "a/c d");
+    EXPECT_TRUE(url::normalize_path("/a/b/../../x.html", out));
+    EXPECT_EQ(out, "x.html");
+    EXPECT_TRUE(url::normalize_path("/a/..%2e/b", out));
+    EXPECT_EQ(out, "a/.../b");
+
+    EXPECT_FALSE(url::normalize_path("/..", out));
+    EXPECT_FALSE(url::normalize_path("/a/../../etc/passwd", out));
+    EXPECT_FALSE(url::normalize_path("/%2e%2e/etc/passwd", out));
+    EXPECT_FALSE(url::normalize_path("/a/%2E", out));
+    EXPECT_FALSE(url::normalize_path("/a%2f..%2f..%2fetc", out));
+    EXPECT_FALSE(url::normalize_path("/a%00.html", out));
+    EXPECT_FALSE(url::normalize_path(std::string_view("/a\0b", 4), out));
+}
+
+namespace {
+
+// 把事件记录成 "[name|filename]data" 形式的文本
+class RecordingPartHandler : public MultipartHandler {
+  public:
+    std::string events;
+
+    void on_part_begin(const MultipartPart &part) override {
+        events += "[" + part.name + (part.is_file ? "|" + part.filename : "") +
+                  "]";
+    }
+    void on_part_data(std::string_view data) override { events += data; }
+    void on_part_end() override { events += ";"; }
+};
+
+const std::string kMultipartBody =
+    "preamble\r\n"
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"title\"\r\n"
+    "\r\n"
+    "a\r\n--Xy not a delimiter\r\n-\r\n--X\r\n"
+    "--XyZ  \r\n"
+    "content-disposition: form-data; name=\"doc\"; "
+    "filename=\"q\\\"uote;d.txt\"\r\n"
+    "Content-Type: text/plain\r\n"
+    "\r\n"
+    "\r\n\r\nline\r\r\n"
+    "--XyZ--\r\n"
+    "epilogue";
+
+const std::string kMultipartEvents =
+    "[title]a\r\n--Xy not a delimiter\r\n-\r\n--X;"
+    "[doc|q\"uote;d.txt]\r\n\r\nline\r;";
+
+} // namespace
+
+TEST(MultipartTest, ParsesAcrossAnySplit) {
+    for (size_t step = 1; step <= kMultipartBody.size(); step++) {
+        RecordingPartHandler handler;
+        MultipartParser parser("XyZ", handler);
+        for (size_t i = 0; i < kMultipartBody.size(); i += step) {
+            parser.feed(std::string_view(kMultipartBody).substr(i, step));
+        }
+        parser.finish();
+        EXPECT_EQ(handler.events, kMultipartEvents) << "step " << step;
+        EXPECT_EQ(parser.count(), 2u);
+    }
+}
+
+TEST(MultipartTest, RejectsMalformedInput) {
+    auto parse = [](std::string_view body) {
+        RecordingPartHandler handler;
+        MultipartParser parser("b", handler, 64);
+        parser.feed(body);
+        parser.finish();
+    };
+    EXPECT_NO_THROW(parse("--b\r\nContent-Disposition: form-data\r\n\r\n"
+                          "\r\n--b--"));
+    EXPECT_THROW(parse("--b\r\nContent-Disposition: form-data\r\n\r\nx"),
+                 MultipartParseError);
+    EXPECT_THROW(parse("--b\r\n\r\nx\r\n--b--"), MultipartParseError);
+    EXPECT_THROW(parse("--bx\r\n"), MultipartParseError);
+    EXPECT_THROW(parse("--b\r\nX-Long: " + std::string(100, 'v') + "\r\n"),
+                 MultipartParseError);
+    EXPECT_THROW(parse(""), MultipartParseError);
+
+    RecordingPartHandler handler;
+    EXPECT_THROW(MultipartParser(std::string(71, 'b'), handler),
+                 MultipartParseError);
+}
+
+TEST(MultipartTest, FileSaverWritesFilesToDisk) {
+    fs::path dir = fs::temp_directory_path() /
+                   ("multipart-test-" + std::to_string(::getpid()));
+    std::string content(100000, '\0');
+    for (size_t i = 0; i < content.size(); i++) {
+        content[i] = static_cast<char>(i * 7 + i / 251);
+    }
+    std::string body = "--b\r\nContent-Disposition: form-data; name=\"f\"; "
+                       "filename=\"../../etc/passwd\"\r\n\r\n" +
+                       content +
+                       "\r\n--b\r\nContent-Disposition: form-data; "
+                       "name=\"note\"\r\n\r\nhi\r\n--b--\r\n";
+    {
+        MultipartFileSaver saver(dir);
+        MultipartParser parser("b", saver);
+        for (size_t i = 0; i < body.size(); i += 4096) {
+            parser.feed(std::string_view(body).substr(i, 4096));
+        }
+        parser.finish();
+
+        ASSERT_EQ(saver.files().size(), 1u);
+        const auto &file = saver.files()[0];
+        EXPECT_EQ(file.filename, "../../etc/passwd");
+        EXPECT_EQ(file.path.parent_path(), dir);
+        EXPECT_EQ(file.size, content.size());
+        std::ifstream in(file.path, std::ios::binary);
+        std::string saved((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+        EXPECT_EQ(saved, content);
+        EXPECT_EQ(saver.fields().at("note"), "hi");
+    }
+    {
+        // 没写完的文件在析构时删除
+        MultipartFileSaver saver(dir);
+        MultipartParser parser("b", saver);
+        parser.feed(body.substr(0, 1000));
+        EXPECT_THROW(parser.finish(), MultipartParseError);
+    }
+    EXPECT_EQ(std::distance(fs::directory_iterator(dir),
+                            fs::directory_iterator()),
+              1);
+    fs::remove_all(dir);
+}
+
+TEST(AccessLogTest, WritesRecordsFromManyThreads) {
+    std::string path = (fs::temp_directory_path() /
+                        ("access-test-" + std::to_string(::getpid())))
+                           .string();
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 2000;
+    {
+        // 队列远小于记录数，Block 时仍然一条不丢
+        AccessLog log(path, 64, AccessLog::Overflow::Block);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&log, t] {
+                AccessRecord record;
+                record.method = Method::Get;
+                record.status = 404;
+                record.bytes = 10;
+                record.latency_us = 5;
+                record.time_us = 1700000000000000;
+                std::string target = "/t" + std::to_string(t);
+                record.set_target(target, "a=1");
+                for (int i = 0; i < kPerThread; i++) {
+                    log.record(record);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(log.dropped(), 0u);
+    }
+
+    std::ifstream in(path);
+    std::string line;
+    int count = 0;
+    while (std::getline(in, line)) {
+        count++;
+        ASSERT_NE(line.find(" GET /t"), std::string::npos) << line;
+        EXPECT_NE(line.find("?a=1 404 10 5us"), std::string::npos) << line;
+    }
+    EXPECT_EQ(count, kThreads * kPerThread);
+    fs::remove(path);
+
+    AccessRecord record;
+    record.set_target(std::string(200, 'p'), "q=1");
+    EXPECT_EQ(record.target_view(), std::string(AccessRecord::kMaxTarget, 'p'));
+}
+
+TEST(AccessLogTest, RateLimiterSuppressesBursts) {
+    RateLimiter limiter(3);
+    uint64_t suppressed = 0;
+    int allowed = 0;
+    for (int i = 0; i < 10; i++) {
+        allowed += limiter.allow(suppressed);
+    }
+    // 循环可能恰好跨过一秒的边界
+    EXPECT_GE(allowed, 3);
+    EXPECT_LE(allowed, 6);
+}
+
+TEST(AccessLogTest, BinaryRecordsRoundTrip) {
+    access_log::BinaryEncoder encoder;
+    std::string data;
+    encoder.begin(1, data);
+    for (int i = 0; i < 3; i++) {
+        AccessRecord record;
+        record.time_us = 1700000000000000 + i;
+        record.bytes = 100 + i;
+        record.latency_us = 7;
+        record.status = i == 2 ? 404 : 200;
+        record.method = i == 1 ? Method::Post : Method::Get;
+        record.set_target(i == 2 ? "/missing" : "/users/42", "");
+        record.route = i == 2 ? "" : "/users/:id";
+        encoder.encode(record, data);
+    }
+    encoder.dropped(5, data);
+    // 重复的字符串只写一次
+    EXPECT_EQ(data.size(), 16u + 3 * access_log::kAccessEntrySize +
+                               (8 + 16) + (8 + 16) + (8 + 8) + 16);
+
+    std::vector<std::string> lines;
+    uint64_t dropped = 0;
+    access_log::BinaryDecoder decoder(
+        [&](const access_log::DecodedRecord &r) {
+            lines.push_back(std::string(method_name(r.method)) + " " +
+                            std::string(r.target) + " " +
+                            std::to_string(r.status) + " " +
+                            std::to_string(r.bytes) + " " +
+                            std::string(r.route));
+        },
+        [&](uint64_t count) { dropped += count; });
+    // 逐字节输入，条目跨段也能解码
+    for (char c : data) {
+        decoder.feed(std::string_view(&c, 1));
+    }
+    decoder.finish();
+    EXPECT_EQ(lines, (std::vector<std::string>{
+                         "GET /users/42 200 100 /users/:id",
+                         "POST /users/42 200 101 /users/:id",
+                         "GET /missing 404 102 ",
+                     }));
+    EXPECT_EQ(dropped, 5u);
+
+    access_log::BinaryDecoder truncated([](const auto &) {});
+    truncated.feed(std::string_view(data).substr(0, data.size() - 3));
+    EXPECT_THROW(truncated.finish(), std::runtime_error);
+    access_log::BinaryDecoder corrupt([](const auto &) {});
+    EXPECT_THROW(corrupt.feed(std::string(16, '\x7f')), std::runtime_error);
+}
+
+TEST(AccessLogTest, BinaryLogFileDecodes) {
+    std::string path = (fs::temp_directory_path() /
+                        ("access-bin-test-" + std::to_string(::getpid())))
+                           .string();
+    // 两次打开同一文件，第二段的 Header 使字符串重新编号
+    for (int run = 0; run < 2; run++) {
+        AccessLog log(path, 16, AccessLog::Overflow::Block,
+                      AccessLog::Format::Binary);
+        AccessRecord record;
+        record.status = 200;
+        record.set_target(run == 0 ? "/a" : "/b", "");
+        for (int i = 0; i < 100; i++) {
+            log.record(record);
+        }
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    std::map<std::string, int> counts;
+    access_log::BinaryDecoder decoder(
+        [&](const access_log::DecodedRecord &r) {
+            counts[std::string(r.target)]++;
+        });
+    decoder.feed(data);
+    decoder.finish();
+    EXPECT_EQ(counts, (std::map<std::string, int>{{"/a", 100}, {"/b", 100}}));
+    fs::remove(path);
+}
+
+TEST(MetricsTest, BucketsAreLogLinear) {
+    for (uint64_t v : {0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 9ull, 100ull,
+                       1000ull, 123456ull, 9999999ull}) {
+        size_t index = Metrics::bucket_index(v);
+        EXPECT_LE(v, Metrics::bucket_upper_bound(index)) << v;
+        if (index > 0) {
+            EXPECT_GT(v, Metrics::bucket_upper_bound(index - 1)) << v;
+        }
+    }
+    for (size_t i = 1; i < Metrics::kBuckets; i++) {
+        EXPECT_GT(Metrics::bucket_upper_bound(i),
+                  Metrics::bucket_upper_bound(i - 1));
+        EXPECT_EQ(Metrics::bucket_index(Metrics::bucket_upper_bound(i)), i);
+    }
+    // 超出最后一个有限桶的值落在溢出桶
+    uint64_t last = Metrics::bucket_upper_bound(Metrics::kBuckets - 1);
+    EXPECT_EQ(Metrics::bucket_index(last), Metrics::kBuckets - 1);
+    EXPECT_EQ(Metrics::bucket_index(last + 1), Metrics::kBuckets);
+    EXPECT_EQ(Metrics::bucket_index(UINT64_MAX), Metrics::kBuckets);
+}
+
+TEST(MetricsTest, OverflowCountsOnlyInInf) {
+    static const std::string route = "/slow";
+    Metrics metrics;
+    {
+        Metrics::Recorder recorder(metrics);
+        recorder.record(route, 200, 100000000); // 100 秒
+        recorder.record(route, 200, 1000);
+    }
+
+    std::string text = metrics.scrape();
+    auto contains = [&](const std::string &line) {
+        return text.find(line + "\n") != std::string::npos;
+    };
+    EXPECT_TRUE(contains("http_request_duration_seconds_bucket{route="
+                         "\"/slow\",le=\"67.108863\"} 1"))
+        << text;
+    EXPECT_TRUE(contains("http_request_duration_seconds_bucket{route="
+                         "\"/slow\",le=\"+Inf\"} 2"));
+    EXPECT_TRUE(contains(
+        "http_request_duration_seconds_count{route=\"/slow\"} 2"));
+    EXPECT_TRUE(contains(
+        "http_request_duration_seconds_sum{route=\"/slow\"} 100.001000"));
+}
+
+TEST(MetricsTest, MergesSlotsOnScrape) {
+    static const std::string users = "/users/:id";
+    static const std::string quoted = "/a\"b\\c";
+    Metrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            Metrics::Recorder recorder(metrics);
+            for (int i = 0; i < 1000; i++) {
+                recorder.record(users, i % 10 == 0 ? 404 : 200, 150);
+            }
+            recorder.record({}, 400, 3);
+            recorder.record(quoted, 200, 10);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::string text = metrics.scrape();
+    auto contains = [&](const std::string &line) {
+        return text.find(line + "\n") != std::string::npos;
+    };
+    EXPECT_TRUE(contains(
+        "http_requests_total{route=\"/users/:id\",status=\"2xx\"} 3600"));
+    EXPECT_TRUE(contains(
+        "http_requests_total{route=\"/users/:id\",status=\"4xx\"} 400"));
+    EXPECT_TRUE(contains(
+        "http_requests_total{route=\"unmatched\",status=\"4xx\"} 4"));
+    EXPECT_TRUE(contains("http_responses_total{code=\"200\"} 3604"));
+    EXPECT_TRUE(contains("http_responses_total{code=\"404\"} 400"));
+    EXPECT_TRUE(contains("http_request_duration_seconds_bucket{route="
+                         "\"/users/:id\",le=\"0.000127\"} 0"));
+    EXPECT_TRUE(contains("http_request_duration_seconds_bucket{route="
+                         "\"/users/:id\",le=\"0.000159\"} 4000"));
+    EXPECT_TRUE(contains("http_request_duration_seconds_bucket{route="
+                         "\"/users/:id\",le=\"+Inf\"} 4000"));
+    EXPECT_TRUE(contains(
+        "http_request_duration_seconds_sum{route=\"/users/:id\"} 0.600000"));
+    EXPECT_TRUE(contains(
+        "http_request_duration_seconds_count{route=\"/a\\\"b\\\\c\"} 4"));
+
+    // 归还的槽位保留计数，由新的记录者继续累加
+    {
+        Metrics::Recorder recorder(metrics);
+        recorder.record(users, 500, 1);
+    }
+    EXPECT_NE(metrics.scrape().find(
+                  "http_requests_total{route=\"/users/:id\",status=\"5xx\"} 1\n"),
+              std::string::npos);
+}
+
+TEST(TraceTest, PhasesSplitElapsedTime) {
+    using namespace std::chrono_literals;
+    trace::calibrate();
+    trace::RequestTrace trace;
+    uint64_t begin = trace::now();
+    trace.start(begin);
+    std::this_thread::sleep_for(5ms);
+    trace.mark(trace::Phase::Read);
+    std::this_thread::sleep_for(5ms);
+    trace.skip(); // 空闲时间不计入
+    std::this_thread::sleep_for(5ms);
+    // Handle 中有一段实际属于 Write
+    trace.nested(trace::Phase::Write, trace.ticks(trace::Phase::Read));
+    std::this_thread::sleep_for(10ms);
+    trace.mark(trace::Phase::Handle);
+
+    auto us = trace.phases_us();
+    auto at = [&](trace::Phase phase) { return us[size_t(phase)]; };
+    EXPECT_GE(at(trace::Phase::Read), 4000u);
+    EXPECT_EQ(at(trace::Phase::Write), at(trace::Phase::Read));
+    EXPECT_GE(at(trace::Phase::Handle), 5000u);
+    EXPECT_EQ(at(trace::Phase::Accept), 0u);
+    uint64_t total = 0;
+    for (uint64_t phase_us : us) {
+        total += phase_us;
+    }
+    EXPECT_LE(total + 4000, trace::to_us(trace::now() - begin));
+    EXPECT_STREQ(trace::phase_name(trace::Phase::Route), "route");
+
+    trace.start(trace::now());
+    EXPECT_EQ(trace.ticks(trace::Phase::Read), 0u);
+}
+
+TEST(TraceTest, PhaseHistogramsInScrape) {
+    Metrics metrics;
+    {
+        Metrics::Recorder recorder(metrics);
+        recorder.record_phases({0, 20, 3, 150, 150, 0});
+        recorder.record_phases({0, 20, 3, 150, 2000, 7});
+    }
+    std::string text = metrics.scrape();
+    auto contains = [&](const std::string &line) {
+        return text.find(line + "\n") != std::string::npos;
+    };
+    EXPECT_TRUE(contains("# TYPE http_request_phase_seconds histogram"));
+    EXPECT_TRUE(contains(
+        "http_request_phase_seconds_bucket{phase=\"handle\",le=\"0.000159\"} 1"));
+    EXPECT_TRUE(contains(
+        "http_request_phase_seconds_count{phase=\"handle\"} 2"));
+    EXPECT_TRUE(contains(
+        "http_request_phase_seconds_sum{phase=\"handle\"} 0.002150"));
+    EXPECT_TRUE(contains(
+        "http_request_phase_seconds_bucket{phase=\"accept\",le=\"0.000000\"} 2"));
+}
+
+TEST(RouterTest, ParseMethod) {
+    EXPECT_EQ(parse_method("GET"), Method::Get);
+    EXPECT_EQ(parse_method("get"), Method::Get);
+    EXPECT_EQ(parse_method("PUT"), Method::Put);
+    EXPECT_EQ(parse_method("PoSt"), Method::Post);
+    EXPECT_EQ(parse_method("HEAD"), Method::Head);
+    EXPECT_EQ(parse_method("PATCH"), Method::Patch);
+    EXPECT_EQ(parse_method("TRACE"), Method::Trace);
+    EXPECT_EQ(parse_method("DELETE"), Method::Delete);
+    EXPECT_EQ(parse_method("OPTIONS"), Method::Options);
+    EXPECT_EQ(parse_method("CONNECT"), Method::Connect);
+    EXPECT_EQ(parse_method("PROPFIND"), Method::Extension);
+    EXPECT_EQ(parse_method("GE"), Method::Extension);
+    EXPECT_EQ(parse_method("GOT"), Method::Extension);
+    EXPECT_EQ(parse_method(""), Method::Extension);
+    EXPECT_EQ(method_name(Method::Options), "OPTIONS");
+}
+
+TEST(RouterTest, MethodNotAllowedSetsAllow) {
+    Router router;
+    router.add_route(Method::Get, "/a", [](Request &, Response &) {});
+    router.add_route(Method::Post, "/a", [](Request &, Response &) {});
+    router.add_route("PROPFIND", "/a", [](Request &, Response &) {});
+
+    Request req;
+    parse_request("PUT /a HTTP/1.1\r\n\r\n", req);
+    std::string out = capture_output([&](int fd) {
+        Response res(fd, req.resource());
+        EXPECT_EQ(router.route(req, res), Router::Result::MethodNotAllowed);
+        res.status(405).send("");
+    });
+    EXPECT_EQ(out.rfind("HTTP/1.1 405", 0), 0u) << out;
+    EXPECT_NE(out.find("Allow: GET, HEAD, POST, OPTIONS, PROPFIND\r\n"),
+              std::string::npos)
+        << out;
+
+    req.reset();
+    parse_request("PUT /b HTTP/1.1\r\n\r\n", req);
+    Response res(-1, req.resource());
+    EXPECT_EQ(router.route(req, res), Router::Result::NotFound);
+}
+
+TEST(RouterTest, HeadFallsBackToGet) {
+    Router router;
+    router.add_route(Method::Get, "/a", [](Request &, Response &res) {
+        res.send("hello");
+    });
+
+    Request req;
+    parse_request("HEAD /a HTTP/1.1\r\n\r\n", req);
+    std::string out = capture_output([&](int fd) {
+        Response res(fd, req.resource());
+        EXPECT_EQ(router.route(req, res), Router::Result::Handled);
+    });
+    EXPECT_NE(out.find("Content-Length: 5\r\n"), std::string::npos) << out;
+    EXPECT_EQ(out.substr(out.size() - 4), "\r\n\r\n") << out;
+}
+
+TEST(RouterTest, OptionsAsteriskListsAllMethods) {
+    Router router;
+    router.add_route(Method::Get, "/a", [](Request &, Response &) {});
+    router.add_route(Method::Delete, "/b", [](Request &, Response &) {});
+
+    Request req;
+    parse_request("OPTIONS * HTTP/1.1\r\n\r\n", req);
+    std::string out = capture_output([&](int fd) {
+        Response res(fd, req.resource());
+        EXPECT_EQ(router.route(req, res), Router::Result::Handled);
+    });
+    EXPECT_EQ(out.rfind("HTTP/1.1 204", 0), 0u) << out;
+    EXPECT_NE(out.find("Allow: GET, HEAD, DELETE, OPTIONS\r\n"),
+              std::string::npos)
+        << out;
+    // 204 不带 Content-Length
+    EXPECT_EQ(out.find("Content-Length"), std::string::npos) << out;
+}
+
+TEST(HeaderMapTest, CaseInsensitiveLookup) {
+    EXPECT_EQ(lookup_header("content-LENGTH"), Header::ContentLength);
+    EXPECT_EQ(lookup_header("ETAG"), Header::ETag);
+    EXPECT_EQ(lookup_header("X-Request-Id"), Header::Unknown);
+    EXPECT_EQ(lookup_header("Content-Lengthx"), Header::Unknown);
+
+    HeaderMap headers;
+    headers.add("HOST", "example.com");
+    headers.add("x-request-id", "42");
+    EXPECT_TRUE(headers.contains(Header::Host));
+    EXPECT_EQ(headers.get("host"), "example.com");
+    EXPECT_EQ(headers.get(Header::Host), "example.com");
+    EXPECT_EQ(headers.get("X-Request-ID"), "42");
+    EXPECT_TRUE(headers.contains("X-REQUEST-ID"));
+    EXPECT_FALSE(headers.contains("X-Other"));
+    EXPECT_EQ(headers.get("X-Other"), "");
+    // 常用头部按规范的名字迭代，其余保留原样
+    auto it = headers.begin();
+    EXPECT_EQ((*it).first, "Host");
+    ++it;
+    EXPECT_EQ((*it).first, "x-request-id");
+}
+
+TEST(HeaderMapTest, DuplicateAddAndSet) {
+    HeaderMap headers;
+    headers.add("Set-Cookie", "a=1");
+    headers.add("set-cookie", "b=2");
+    headers.add("X-Tag", "x");
+    headers.add("x-tag", "y");
+    EXPECT_EQ(headers.size(), 4u);
+    EXPECT_EQ(headers.get(Header::SetCookie), "a=1");
+    EXPECT_EQ(headers.get("X-TAG"), "x");
+
+    std::vector<std::string> values;
+    for (auto [name, value] : headers) {
+        values.emplace_back(value);
+    }
+    EXPECT_EQ(values, (std::vector<std::string>{"a=1", "b=2", "x", "y"}));
+
+    // set 覆盖第一个同名头部
+    headers.set("x-tag", "z");
+    EXPECT_EQ(headers.get("X-Tag"), "z");
+    EXPECT_EQ(headers.size(), 4u);
+
+    headers.erase("SET-COOKIE");
+    headers.erase("X-Tag");
+    EXPECT_TRUE(headers.empty());
+    EXPECT_FALSE(headers.contains(Header::SetCookie));
+}
+
+TEST(HeaderMapTest, EraseAcrossInlineAndOverflow) {
+    HeaderMap headers;
+    for (int i = 0; i < 24; i++) {
+        headers.add("X-H" + std::to_string(i), std::to_string(i));
+    }
+    headers.add("Content-Type", "text/plain");
+    ASSERT_GT(headers.size(), HeaderMap::kInlineEntries);
+
+    headers.erase("x-h3");                 // 内联部分
+    headers.erase("X-H20");                // 溢出部分
+    headers.erase(Header::ContentType);    // 溢出部分的常用头部
+    headers.erase("X-Missing");
+    EXPECT_EQ(headers.size(), 22u);
+    EXPECT_FALSE(headers.contains("X-H3"));
+    EXPECT_FALSE(headers.contains("X-H20"));
+    EXPECT_FALSE(headers.contains(Header::ContentType));
+
+    // 其余条目保持顺序，跨越内联与溢出边界后仍能找到
+    std::vector<std::string> values;
+    for (auto [name, value] : headers) {
+        values.emplace_back(value);
+    }
+    std::vector<std::string> expected;
+    for (int i = 0; i < 24; i++) {
+        if (i != 3 && i != 20) {
+            expected.push_back(std::to_string(i));
+        }
+    }
+    EXPECT_EQ(values, expected);
+    EXPECT_EQ(headers.get("X-H16"), "16");
+    EXPECT_EQ(headers.get("X-H23"), "23");
+
+    headers.set(Header::ContentType, "application/json");
+    EXPECT_EQ(headers.get("content-type"), "application/json");
+}
+
+TEST(HeaderMapTest, ReleaseBeforeArenaReset) {
+    std::pmr::monotonic_buffer_resource arena;
+    HeaderMap headers(&arena);
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 20; i++) {
+            headers.add("X-Long-Header-Name-" + std::to_string(i),
+                        std::string(64, 'v'));
+        }
+        headers.add("Host", "example.com");
+        EXPECT_EQ(headers.get(Header::Host), "example.com");
+        // release 后容器不再引用 arena 中的内存，arena 可以整体回收
+        headers.release();
+        EXPECT_TRUE(headers.empty());
+        EXPECT_FALSE(headers.contains(Header::Host));
+        arena.release();
+    }
+    headers.add("Host", "after");
+    EXPECT_EQ(headers.get(Header::Host), "after");
+    EXPECT_EQ(headers.size(), 1u);
+}
+
+TEST(ResponseFragmentsTest, StatusLines) {
+    EXPECT_EQ(status_line(200), "HTTP/1.1 200 OK\r\n");
+    EXPECT_EQ(status_line(204), "HTTP/1.1 204 No Content\r\n");
+    EXPECT_EQ(status_line(404), "HTTP/1.1 404 Not Found\r\n");
+    EXPECT_EQ(status_line(100), "HTTP/1.1 100 Continue\r\n");
+    // 范围内没有标准原因短语的状态码仍有自己的状态行
+    EXPECT_EQ(status_line(418), "HTTP/1.1 418 Unknown Status\r\n");
+    EXPECT_EQ(status_line(599), "HTTP/1.1 599 Unknown Status\r\n");
+    EXPECT_EQ(reason_phrase(413), "Content Too Large");
+
+    // 超出 100-599 的状态码按 500 发送
+    for (int code : {-1, 0, 99, 600, 1000}) {
+        EXPECT_EQ(status_line(code), "HTTP/1.1 500 Internal Server Error\r\n")
+            << code;
+    }
+
+    std::string out = "n=";
+    append_decimal(out, 0);
+    out += ',';
+    append_decimal(out, SIZE_MAX);
+    EXPECT_EQ(out, "n=0," + std::to_string(SIZE_MAX));
+}
+
+TEST(ResponseFragmentsTest, DateHeaderFormatAndRefresh) {
+    auto expected = [](time_t now) {
+        std::tm tm{};
+        gmtime_r(&now, &tm);
+        char text[64];
+        std::strftime(text, sizeof(text),
+                      "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        return std::string(text);
+    };
+    // 取值前后处于同一秒时才比较
+    auto check = [&] {
+        for (;;) {
+            time_t before = std::time(nullptr);
+            std::string header(date_header());
+            if (std::time(nullptr) == before) {
+                EXPECT_EQ(header, expected(before));
+                return header;
+            }
+        }
+    };
+
+    std::string first = check();
+    EXPECT_EQ(first.size(),
+              std::string_view("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n")
+                  .size());
+
+    // 跨过秒边界后缓存刷新
+    time_t start = std::time(nullptr);
+    while (std::time(nullptr) == start) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::string second = check();
+    EXPECT_NE(first, second);
+}
+
+namespace {
+
+// 解析一个带请求体的 POST 请求，请求体随头部一起收到
+void parse_post(Request &req, std::string_view content_type,
+                std::string_view body) {
+    std::string raw = "POST /x HTTP/1.1\r\n";
+    if (!content_type.empty()) {
+        raw += "Content-Type: " + std::string(content_type) + "\r\n";
+    }
+    raw += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    raw += body;
+    req.reset();
+    parse_request(raw, req);
+}
+
+// 调用 fn 并返回它抛出的异常信息
+template <typename F> std::string error_of(F &&fn) {
+    try {
+        fn();
+    } catch (const std::runtime_error &e) {
+        return e.what();
+    }
+    return "";
+}
+
+} // namespace
+
+TEST(RequestBodyTest, JsonStatusMapping) {
+    Request req;
+    parse_post(req, "application/json; charset=utf-8", R"({"a":[1,2]})");
+    const JsonValue &a = req.json().as_object().at("a");
+    EXPECT_EQ(a.as_array().at(1).as_integer(), 2);
+
+    parse_post(req, "", "");
+    EXPECT_TRUE(req.json().is_null());
+
+    parse_post(req, "text/plain", R"({"a":1})");
+    EXPECT_EQ(error_of([&] { req.json(); }), "415 Unsupported Media Type");
+    parse_post(req, "application/json", R"({"a":1)");
+    EXPECT_EQ(error_of([&] { req.json(); }), "400 Bad Request");
+    parse_post(req, "application/msgpack", "\xc1");
+    EXPECT_EQ(error_of([&] { req.json(); }), "400 Bad Request");
+    parse_post(req, "application/x-www-form-urlencoded", "a=1");
+    EXPECT_EQ(error_of([&] { req.json(); }), "415 Unsupported Media Type");
+}
+
+TEST(RequestBodyTest, FormDecoding) {
+    Request req;
+    parse_post(req, "application/x-www-form-urlencoded",
+               "a=1+2&b=%41%2b%2F&x%20y=%E4%B8%AD&flag&=v&c=%zz");
+    EXPECT_EQ(req.form(), (Request::Form{{"a", "1 2"},
+                                         {"b", "A+/"},
+                                         {"x y", "\xE4\xB8\xAD"},
+                                         {"flag", ""},
+                                         {"", "v"},
+                                         {"c", "%zz"}}));
+
+    parse_post(req, "", "");
+    EXPECT_TRUE(req.form().empty());
+
+    parse_post(req, "application/json", "a=1");
+    EXPECT_EQ(error_of([&] { req.form(); }), "415 Unsupported Media Type");
+    // 类型不匹配时不缓存结果，再次访问仍然报错
+    EXPECT_EQ(error_of([&] { req.form(); }), "415 Unsupported Media Type");
+}
+
+namespace {
+
+constexpr json::SimdLevel kAllSimdLevels[] = {
+    json::SimdLevel::Scalar, json::SimdLevel::SSE2, json::SimdLevel::AVX2,
+    json::SimdLevel::NEON};
+
+// 逐字节的参考实现：字符串外的结构字符，以及每个标量或字符串的首字节；
+// 字符串未闭合时返回空
+std::optional<std::vector<uint32_t>> reference_index(std::string_view json) {
+    std::vector<uint32_t> out;
+    bool in_string = false;
+    bool escaped = false;
+    bool in_scalar = false;
+    for (uint32_t i = 0; i < json.size(); i++) {
+        char c = json[i];
+        bool is_escaped = escaped;
+        escaped = c == '\\' && !is_escaped;
+        bool quote = c == '"' && !is_escaped;
+        if (in_string) {
+            in_string = !quote;
+            in_scalar = false;
+        } else if (std::string_view("{}[]:,").find(c) !=
+                   std::string_view::npos) {
+            out.push_back(i);
+            in_scalar = false;
+        } else if (json_detail::is_space(c)) {
+            in_scalar = false;
+        } else {
+            if (!in_scalar) {
+                out.push_back(i);
+            }
+            in_scalar = true;
+            in_string = quote;
+        }
+    }
+    if (in_string) {
+        return std::nullopt;
+    }
+    out.push_back(static_cast<uint32_t>(json.size()));
+    return out;
+}
+
+// 每种 SimdLevel 的结果都与参考实现一致
+void expect_index_matches(const std::string &json) {
+    std::optional<std::vector<uint32_t>> expected = reference_index(json);
+    for (json::SimdLevel level : kAllSimdLevels) {
+        std::vector<uint32_t> index;
+        if (expected) {
+            EXPECT_NO_THROW(json::build_structural_index(json, index, level))
+                << json::simd_level_name(level) << ": " << json;
+            EXPECT_EQ(index, *expected)
+                << json::simd_level_name(level) << ": " << json;
+        } else {
+            EXPECT_THROW(json::build_structural_index(json, index, level),
+                         std::runtime_error)
+                << json::simd_level_name(level) << ": " << json;
+        }
+    }
+}
+
+} // namespace
+
+TEST(JsonStructuralTest, BackslashRunsAcrossBlocks) {
+    // 反斜杠串的结尾落在第 64 字节前后，奇数个时引号被转义
+    for (size_t end = 56; end < 72; end++) {
+        for (size_t run = 1; run <= 6; run++) {
+            std::string json = "[\"";
+            json += std::string(end - run - json.size(), 'a');
+            json += std::string(run, '\\');
+            json += "\",1]\" , 2]";
+            expect_index_matches(json);
+            // 字符串外的反斜杠同样转义下一个字节
+            expect_index_matches(std::string(end - run, ' ') +
+                                 std::string(run, '\\') + "\"x\"");
+        }
+    }
+}
+
+TEST(JsonStructuralTest, BlockSizesAndTail) {
+    for (size_t size : {0, 1, 63, 64, 65, 127, 128, 129}) {
+        // 恰好 size 字节的字符串、数组和空白
+        if (size >= 2) {
+            expect_index_matches("\"" + std::string(size - 2, 'x') + "\"");
+            // 缺少闭引号
+            expect_index_matches("\"" + std::string(size - 1, 'x'));
+            expect_index_matches(std::string(size - 2, ' ') + "[]");
+        }
+        std::string numbers;
+        while (numbers.size() + 2 <= size) {
+            numbers += numbers.empty() ? "1" : ",1";
+        }
+        expect_index_matches("[" + numbers + "]");
+    }
+    // 字符串开于一块、闭于下一块
+    expect_index_matches("[" + std::string(62, ' ') + "\"ab\"]");
+    expect_index_matches(std::string(63, ' ') + "\"");
+}
+
+TEST(JsonStructuralTest, WhitespaceAfterStrings) {
+    for (size_t pad = 0; pad < 70; pad += 3) {
+        std::string json = "{" + std::string(pad, ' ') + "\"key\"" +
+                           std::string(pad % 7, ' ') + "\t\n:\r \"v\\\"\"" +
+                           std::string(pad, '\n') + ", \"n\" :-1.5e3 }";
+        expect_index_matches(json);
+    }
+}
+
+TEST(JsonStructuralTest, RandomInputsMatchReference) {
+    const std::string alphabet = "{}[]:,\"\"\\\\ \t\n\rab01-";
+    std::mt19937 rng(12345);
+    for (int round = 0; round < 2000; round++) {
+        std::string json(rng() % 200, ' ');
+        for (char &c : json) {
+            c = alphabet[rng() % alphabet.size()];
+        }
+        expect_index_matches(json);
+    }
+}
+
+TEST(JsonStructuralTest, StringTokenSkipsTrailingWhitespace) {
+    std::string json = "{\"a\"   :  \"x\\\"y\" \n\t, \"k\":\"\"}";
+    std::vector<uint32_t> index;
+    json::build_structural_index(json, index);
+    json_detail::StructuralCursor cursor(json, index);
+
+    bool has_escape = true;
+    EXPECT_EQ(cursor.peek(), '{');
+    cursor.advance();
+    EXPECT_EQ(cursor.string_token(has_escape), "a");
+    EXPECT_FALSE(has_escape);
+    EXPECT_EQ(cursor.peek(), ':');
+    cursor.advance();
+    EXPECT_EQ(cursor.string_token(has_escape), "x\\\"y");
+    EXPECT_TRUE(has_escape);
+    EXPECT_EQ(cursor.peek(), ',');
+    cursor.advance();
+    EXPECT_EQ(cursor.string_token(has_escape), "k");
+    cursor.advance();
+    EXPECT_EQ(cursor.string_token(has_escape), "");
+    EXPECT_EQ(cursor.peek(), '}');
+    cursor.advance();
+    EXPECT_TRUE(cursor.at_end());
+
+    // 标量不是字符串
+    std::string numbers = "[12  , 3]";
+    json::build_structural_index(numbers, index);
+    json_detail::StructuralCursor scalar(numbers, index);
+    scalar.advance();
+    EXPECT_THROW(scalar.string_token(has_escape), std::runtime_error);
+}
+
+TEST(JsonStructuralTest, IndexBufferDoesNotStayLarge) {
+    std::string big = "[1";
+    while (big.size() < 4 * json_detail::kMaxRetainedIndex) {
+        big += ",1";
+    }
+    big += "]";
+    EXPECT_EQ(JsonValue::parse(big).as_array().size(), big.size() / 2);
+    EXPECT_LE(json_detail::thread_index_buffer().capacity(),
+              json_detail::kMaxRetainedIndex);
+
+    // 出错时同样释放
+    big.back() = ',';
+    EXPECT_THROW(JsonValue::parse(big), std::runtime_error);
+    EXPECT_LE(json_detail::thread_index_buffer().capacity(),
+              json_detail::kMaxRetainedIndex);
+
+    // 小输入的缓冲区保留下来复用
+    JsonValue::parse("[1,2,3]");
+    EXPECT_GT(json_detail::thread_index_buffer().capacity(), 0u);
+}
+
+TEST(JsonWriterTest, EscapesControlCharactersAndQuotes) {
+    auto expected_escape = [](std::string_view s) {
+        std::string out = "\"";
+        for (char c : s) {
+            unsigned char u = static_cast<unsigned char>(c);
+            const char *named = nullptr;
+            switch (c) {
+            case '"':
+                named = "\\\"";
+                break;
+            case '\\':
+                named = "\\\\";
+                break;
+            case '\b':
+                named = "\\b";
+                break;
+            case '\f':
+                named = "\\f";
+                break;
+            case '\n':
+                named = "\\n";
+                break;
+            case '\r':
+                named = "\\r";
+                break;
+            case '\t':
+                named = "\\t";
+                break;
+            }
+            if (named) {
+                out += named;
+            } else if (u < 0x20) {
+                char u_escape[8];
+                std::snprintf(u_escape, sizeof(u_escape), "\\u%04x", u);
+                out += u_escape;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    };
+
+    // 每个需要转义的字节分别出现在 16 字节块内的各个位置和不足一块的尾部
+    std::string specials;
+    for (int c = 0; c < 0x20; c++) {
+        specials += static_cast<char>(c);
+    }
+    specials += "\"\\\x7f\xc3\xa9/";
+    for (char special : specials) {
+        for (size_t at = 0; at < 40; at += 3) {
+            std::string s(40, 'a');
+            s[at] = special;
+            std::string out;
+            JsonWriter(out).value(s);
+            EXPECT_EQ(out, expected_escape(s)) << int(special) << " @" << at;
+        }
+    }
+
+    std::string all = specials + specials + "tail";
+    std::string out;
+    JsonWriter(out).begin_object().key(all).value(all).end_object();
+    EXPECT_EQ(out, "{" + expected_escape(all) + ":" + expected_escape(all) +
+                       "}");
+    EXPECT_EQ(JsonValue::parse(out).as_object().at(all).as_string(), all);
+
+    // 分段交给 sink 时结果不变
+    std::string streamed;
+    {
+        JsonWriter writer([&](std::string_view data) { streamed += data; },
+                          false, 8);
+        writer.begin_object().key(all).value(all).end_object();
+        writer.flush();
+    }
+    EXPECT_EQ(streamed, out);
+}
+
+TEST(JsonWriterTest, NumberFormatting) {
+    auto write = [](double d) {
+        std::string out;
+        JsonWriter(out).value(d);
+        return out;
+    };
+    // JSON 不能表示 NaN 与无穷大
+    EXPECT_EQ(write(std::nan("")), "null");
+    EXPECT_EQ(write(std::numeric_limits<double>::infinity()), "null");
+    EXPECT_EQ(write(-std::numeric_limits<double>::infinity()), "null");
+
+    // 2^53 以内的整数值按整数输出
+    EXPECT_EQ(write(1e6), "1000000");
+    EXPECT_EQ(write(-3.0), "-3");
+    EXPECT_EQ(write(0.0), "0");
+    EXPECT_EQ(write(9007199254740991.0), "9007199254740991");
+    EXPECT_EQ(write(-9007199254740991.0), "-9007199254740991");
+    // -0 保留符号，2^53 及以上走浮点的最短表示
+    EXPECT_EQ(write(-0.0), "-0");
+    EXPECT_EQ(write(1e20), "1e+20");
+    EXPECT_EQ(write(0.5), "0.5");
+    EXPECT_EQ(write(0.1), "0.1");
+    EXPECT_EQ(write(1.5e300), "1.5e+300");
+    EXPECT_EQ(JsonValue::parse(write(1e20)).as_number(), 1e20);
+
+    std::string out;
+    JsonWriter(out).begin_array().value(INT64_MIN).value(INT64_MAX).end_array();
+    EXPECT_EQ(out, "[-9223372036854775808,9223372036854775807]");
+}
+
+namespace {
+
+// 把事件序列化成文本，便于比较
+class EventRecorder : public JsonHandler {
+  public:
+    void on_null() override { events += "null;"; }
+    void on_bool(bool b) override { events += b ? "true;" : "false;"; }
+    void on_number(double n) override {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "d%.17g;", n);
+        events += buffer;
+    }
+    void on_integer(int64_t n) override {
+        events += "i" + std::to_string(n) + ";";
+    }
+    void on_string(std::string_view s) override {
+        events += "s" + std::string(s) + ";";
+    }
+    void on_key(std::string_view key) override {
+        events += "k" + std::string(key) + ";";
+    }
+    void on_begin_object() override { events += "{;"; }
+    void on_end_object() override { events += "};"; }
+    void on_begin_array() override { events += "[;"; }
+    void on_end_array() override { events += "];"; }
+
+    std::string events;
+};
+
+// 按 JsonValue 的内容产生与流式解析相同的事件
+void replay(const JsonValue &value, JsonHandler &handler) {
+    if (value.is_null()) {
+        handler.on_null();
+    } else if (value.is_bool()) {
+        handler.on_bool(value.as_bool());
+    } else if (value.is_integer()) {
+        handler.on_integer(value.as_integer());
+    } else if (value.is_number()) {
+        handler.on_number(value.as_number());
+    } else if (value.is_string()) {
+        handler.on_string(value.as_string());
+    } else if (value.is_array()) {
+        handler.on_begin_array();
+        for (const JsonValue &item : value.as_array()) {
+            replay(item, handler);
+        }
+        handler.on_end_array();
+    } else {
+        handler.on_begin_object();
+        for (const auto &[key, item] : value.as_object()) {
+            handler.on_key(key);
+            replay(item, handler);
+        }
+        handler.on_end_object();
+    }
+}
+
+} // namespace
+
+TEST(JsonStreamParserTest, ResumesAtEveryOffset) {
+    // 键按字典序排列，与 JsonValue::Object 的遍历顺序一致
+    const std::vector<std::string> documents = {
+        R"( {"a":[1,-2.5e3,true,false,null],"b\"c":"x\\yé😀",)"
+        R"("d":{"e":[],"f":{}},"g":"中文","h":-0,)"
+        R"("i":9223372036854775807,"j":123456789012345678901} )",
+        "12345",
+        "\"top\\nlevel\"",
+        "true",
+        "[[[\"\\\\\"]]]",
+    };
+    for (const std::string &document : documents) {
+        EventRecorder expected;
+        replay(JsonValue::parse(document), expected);
+
+        for (size_t split = 0; split <= document.size(); split++) {
+            EventRecorder recorder;
+            JsonStreamParser parser(recorder);
+            parser.feed(std::string_view(document).substr(0, split));
+            parser.feed(std::string_view(document).substr(split));
+            parser.finish();
+            EXPECT_EQ(recorder.events, expected.events)
+                << document << " split at " << split;
+        }
+
+        EventRecorder bytes;
+        JsonStreamParser parser(bytes);
+        for (char c : document) {
+            parser.feed(std::string_view(&c, 1));
+        }
+        parser.finish();
+        EXPECT_EQ(bytes.events, expected.events) << document;
+    }
+}
+
+TEST(JsonStreamParserTest, RejectsLongToken) {
+    EventRecorder recorder;
+    JsonStreamParser parser(recorder, 8);
+    // 完整落在一段内的 token 不经过缓冲区，不受限制
+    parser.feed(R"(["0123456789abcdef",)");
+    parser.feed("\"0123");
+    EXPECT_THROW(parser.feed("456789\""), JsonParseError);
+
+    JsonStreamParser numbers(recorder, 4);
+    numbers.feed("[12");
+    EXPECT_THROW(numbers.feed("345]"), JsonParseError);
+}
+
+TEST(JsonElementSplitterTest, ResumesAtEveryOffset) {
+    const std::string input =
+        R"( [ {"a":"],\"["} , [1,[2]] ,"x,y" , 3 ] )";
+    const std::vector<std::string> expected = {
+        R"({"a":"],\"["} )", "[1,[2]] ", R"("x,y" )", "3 "};
+    for (size_t split = 0; split <= input.size(); split++) {
+        std::vector<std::string> elements;
+        JsonElementSplitter splitter(
+            [&](std::string_view element) { elements.emplace_back(element); });
+        splitter.feed(std::string_view(input).substr(0, split));
+        splitter.feed(std::string_view(input).substr(split));
+        splitter.finish();
+        EXPECT_EQ(elements, expected) << "split at " << split;
+    }
+}
+
+TEST(JsonElementSplitterTest, RejectsLongElement) {
+    size_t elements = 0;
+    JsonElementSplitter splitter([&](std::string_view) { elements++; }, 8);
+    splitter.feed(R"(["0123456789abcdef",[1,)");
+    EXPECT_EQ(elements, 1u);
+    EXPECT_THROW(splitter.feed("2,3,4,5]]"), JsonParseError);
+    EXPECT_EQ(elements, 1u);
+}
+
+TEST(JsonNumberTest, IntegersAndFallbacks) {
+    using json_detail::parse_number_token;
+
+    auto zero = parse_number_token("0");
+    EXPECT_TRUE(zero.is_integer);
+    EXPECT_EQ(zero.integer, 0);
+
+    // -0 按浮点数处理以保留符号
+    auto negative_zero = parse_number_token("-0");
+    EXPECT_FALSE(negative_zero.is_integer);
+    EXPECT_EQ(negative_zero.number, 0.0);
+    EXPECT_TRUE(std::signbit(negative_zero.number));
+
+    auto max = parse_number_token("9223372036854775807");
+    EXPECT_TRUE(max.is_integer);
+    EXPECT_EQ(max.integer, std::numeric_limits<int64_t>::max());
+    auto min = parse_number_token("-9223372036854775808");
+    EXPECT_TRUE(min.is_integer);
+    EXPECT_EQ(min.integer, std::numeric_limits<int64_t>::min());
+
+    // 超出 int64 的整数退回浮点数
+    auto over = parse_number_token("9223372036854775808");
+    EXPECT_FALSE(over.is_integer);
+    EXPECT_EQ(over.number, 9223372036854775808.0);
+    auto under = parse_number_token("-9223372036854775809");
+    EXPECT_FALSE(under.is_integer);
+    EXPECT_EQ(under.number, -9223372036854775808.0);
+
+    // 有小数或指数部分的总是浮点数
+    auto fraction = parse_number_token("1.0");
+    EXPECT_FALSE(fraction.is_integer);
+    EXPECT_EQ(fraction.number, 1.0);
+    auto exponent = parse_number_token("-2E+2");
+    EXPECT_FALSE(exponent.is_integer);
+    EXPECT_EQ(exponent.number, -200.0);
+    EXPECT_EQ(parse_number_token("1e-2").number, 0.01);
+}
+
+TEST(JsonNumberTest, RejectsMalformedNumbers) {
+    auto error = [](std::string_view token) {
+        return error_of([&] { json_detail::parse_number_token(token); });
+    };
+
+    EXPECT_EQ(error("01"), "Leading zero in number is not allowed");
+    EXPECT_EQ(error("-01"), "Leading zero in number is not allowed");
+    EXPECT_EQ(error("00.5"), "Leading zero in number is not allowed");
+
+    EXPECT_EQ(error("-"), "Invalid number format");
+    EXPECT_EQ(error(""), "Invalid number format");
+    EXPECT_EQ(error("+1"), "Invalid number format");
+    EXPECT_EQ(error(".5"), "Invalid number format");
+    EXPECT_EQ(error("-.5"), "Invalid number format");
+
+    EXPECT_EQ(error("1."), "Invalid number format after decimal point");
+    EXPECT_EQ(error("1.e5"), "Invalid number format after decimal point");
+
+    EXPECT_EQ(error("1e"), "Invalid number format in exponent");
+    EXPECT_EQ(error("1e+"), "Invalid number format in exponent");
+    EXPECT_EQ(error("1E-x"), "Invalid number format in exponent");
+
+    EXPECT_EQ(error("1x"), "Unexpected character: x");
+    EXPECT_EQ(error("1.5.2"), "Unexpected character: .");
+    EXPECT_EQ(error("1e400"), "Invalid number: 1e400");
+}
+
+TEST(JsonLazyPointerTest, ResolvesRfc6901Pointers) {
+    JsonLazyDocument doc = JsonLazyDocument::parse(
+        R"({"a":[10,{"b":"x"}],"":1,"m~n":2,"c/d":3," ":4,"~1":5})");
+
+    EXPECT_TRUE(doc.find_pointer("")->is_object());
+    EXPECT_EQ(doc.at_pointer("/a/0").as_integer(), 10);
+    EXPECT_EQ(doc.at_pointer("/a/1/b").as_string(), "x");
+    // 空键与只含空格的键
+    EXPECT_EQ(doc.at_pointer("/").as_integer(), 1);
+    EXPECT_EQ(doc.at_pointer("/ ").as_integer(), 4);
+    // ~0 与 ~1 转义，~01 先解 ~0 得到 "~1"
+    EXPECT_EQ(doc.at_pointer("/m~0n").as_integer(), 2);
+    EXPECT_EQ(doc.at_pointer("/c~1d").as_integer(), 3);
+    EXPECT_EQ(doc.at_pointer("/~01").as_integer(), 5);
+
+    // 前导零、"-"、越界和非数字下标都不存在
+    EXPECT_FALSE(doc.find_pointer("/a/01"));
+    EXPECT_FALSE(doc.find_pointer("/a/-"));
+    EXPECT_FALSE(doc.find_pointer("/a/2"));
+    EXPECT_FALSE(doc.find_pointer("/a/18446744073709551616"));
+    EXPECT_FALSE(doc.find_pointer("/a/+1"));
+    EXPECT_FALSE(doc.find_pointer("/a/1/c"));
+    EXPECT_FALSE(doc.find_pointer("/a/0/0"));
+    EXPECT_THROW(doc.at_pointer("/missing"), std::out_of_range);
+
+    // 相对于子值解析
+    JsonLazyValue a = doc.at_pointer("/a");
+    EXPECT_EQ(a.at_pointer("/1/b").as_string(), "x");
+}
+
+TEST(JsonLazyPointerTest, RejectsMalformedPointers) {
+    JsonLazyDocument doc = JsonLazyDocument::parse(R"({"a":[1,{"b":2}]})");
+    auto error = [&](std::string_view pointer) {
+        return error_of([&] { doc.find_pointer(pointer); });
+    };
+
+    EXPECT_EQ(error("a"), "Invalid JSON pointer: a");
+    EXPECT_EQ(error("/a/~2"), "Invalid JSON pointer: /a/~2");
+    EXPECT_EQ(error("/a~"), "Invalid JSON pointer: /a~");
+    EXPECT_EQ(error("/~/a"), "Invalid JSON pointer: /~/a");
+    // 格式错误与路径是否存在无关
+    EXPECT_EQ(error("/a/1/b~2"), "Invalid JSON pointer: /a/1/b~2");
+    EXPECT_EQ(error("/missing/b~2"), "Invalid JSON pointer: /missing/b~2");
+    EXPECT_EQ(error("/a/5/~"), "Invalid JSON pointer: /a/5/~");
+}
+
+namespace {
+
+std::string decode(std::string_view raw) {
+    std::string out(raw.size(), '\0');
+    out.resize(json_detail::decode_escapes(raw, out.data()));
+    return out;
+}
+
+} // namespace
+
+TEST(JsonEscapeTest, DecodesEscapes) {
+    EXPECT_EQ(decode(R"(a\"b\\c\/d\b\f\n\r\t)"), "a\"b\\c/d\b\f\n\r\t");
+    EXPECT_EQ(decode(R"(\u0041\u00e9\u4E2D)"), "A\xc3\xa9\xe4\xb8\xad");
+    EXPECT_EQ(decode(R"(\u0000)"), std::string("\0", 1));
+    EXPECT_EQ(decode(R"(x\u0000y)"), std::string("x\0y", 3));
+    // 代理对合并为一个四字节码点
+    EXPECT_EQ(decode(R"(\ud83d\ude00)"), "\xf0\x9f\x98\x80");
+    EXPECT_EQ(decode(R"(\uDBFF\uDFFF)"), "\xf4\x8f\xbf\xbf");
+    EXPECT_EQ(decode("no escapes"), "no escapes");
+}
+
+TEST(JsonEscapeTest, RejectsInvalidEscapes) {
+    auto error = [](std::string_view raw) {
+        return error_of([&] { decode(raw); });
+    };
+
+    // 单独的高代理项、低代理项，以及高代理项后不是 \u 转义
+    EXPECT_EQ(error(R"(\ud83d)"), "Invalid Unicode surrogate pair");
+    EXPECT_EQ(error(R"(\ud83dx)"), "Invalid Unicode surrogate pair");
+    EXPECT_EQ(error(R"(\ude00)"), "Invalid Unicode surrogate pair");
+    EXPECT_EQ(error(R"(\ud83d\n\ude00)"), "Invalid Unicode surrogate pair");
+    EXPECT_EQ(error(R"(\ud83dA)"), "Invalid Unicode surrogate pair");
+    EXPECT_EQ(error(R"(\ud83d\ud83d)"), "Invalid Unicode surrogate pair");
+
+    EXPECT_EQ(error(R"(\u12)"),
+              "Unexpected end of string after Unicode escape");
+    EXPECT_EQ(error(R"(\u12g4)"), "Invalid Unicode escape");
+    EXPECT_EQ(error(R"(\ud83d\u12g4)"), "Invalid Unicode escape");
+    EXPECT_EQ(error("abc\\"),
+              "Unexpected end of string after escape character");
+    EXPECT_EQ(error(R"(\q)"), "Invalid escape sequence: \\q");
+    EXPECT_EQ(error(R"(\U0041)"), "Invalid escape sequence: \\U");
+}
+
+TEST(JsonUtf8Test, ClassifiesSequences) {
+    const std::vector<std::pair<std::string, bool>> cases = {
+        {"", true},
+        {"\x7f", true},
+        {"\xc2\x80", true},
+        {"\xdf\xbf", true},
+        {"\xe0\xa0\x80", true},
+        {"\xed\x9f\xbf", true},
+        {"\xee\x80\x80", true},
+        {"\xf0\x90\x80\x80", true},
+        {"\xf4\x8f\xbf\xbf", true},
+        // 过长编码
+        {"\xc0\x80", false},
+        {"\xc1\xbf", false},
+        {"\xe0\x9f\xbf", false},
+        {"\xf0\x8f\xbf\xbf", false},
+        // 代理项 U+D800 到 U+DFFF
+        {"\xed\xa0\x80", false},
+        {"\xed\xbf\xbf", false},
+        // 超过 U+10FFFF
+        {"\xf4\x90\x80\x80", false},
+        {"\xf5\x80\x80\x80", false},
+        {"\xff", false},
+        // 截断与多余的后续字节
+        {"\xc2", false},
+        {"\xe0\xa0", false},
+        {"\xf0\x90\x80", false},
+        {"\x80", false},
+        {"\xc2\x80\x80", false},
+        {"\xe0\xa0\x80\x80", false},
+    };
+
+    for (json::SimdLevel level : kAllSimdLevels) {
+        for (const auto &[bytes, valid] : cases) {
+            EXPECT_EQ(json::validate_utf8(bytes, level), valid)
+                << json::simd_level_name(level) << " "
+                << ::testing::PrintToString(bytes);
+        }
+    }
+}
+
+TEST(JsonUtf8Test, SimdMatchesScalarAtEveryOffset) {
+    const std::vector<std::string> sequences = {
+        "\xc3\xa9",         "\xe4\xb8\xad",     "\xf0\x9f\x98\x80",
+        "\xf4\x8f\xbf\xbf", "\xc0\x80",         "\xe0\x9f\xbf",
+        "\xed\xa0\x80",     "\xf4\x90\x80\x80", "\xf8\x88\x80\x80\x80",
+        "\xc2",             "\xe0\xa0",         "\xf0\x90\x80",
+        "\x80",             "\xbf\xbf",
+    };
+
+    // 序列放在两块 64 字节的每个位置上，包括跨块和截断在输入末尾
+    for (const std::string &sequence : sequences) {
+        for (size_t total : {64u, 65u, 128u}) {
+            for (size_t at = 0; at < total; at++) {
+                std::string data(total, 'a');
+                data.replace(at, std::min(sequence.size(), total - at),
+                             sequence.substr(0, total - at));
+                const bool expected =
+                    json::validate_utf8(data, json::SimdLevel::Scalar);
+                for (json::SimdLevel level : kAllSimdLevels) {
+                    EXPECT_EQ(json::validate_utf8(data, level), expected)
+                        << json::simd_level_name(level) << " "
+                        << ::testing::PrintToString(sequence) << " at "
+                        << at << " of " << total;
+                }
+            }
+        }
+    }
+
+    // 标量实现本身：序列截断在块末尾时无效，补齐后有效
+    std::string data(64, 'a');
+    data.replace(62, 2, "\xe4\xb8");
+    EXPECT_FALSE(json::validate_utf8(data, json::SimdLevel::Scalar));
+    data += '\xad';
+    EXPECT_TRUE(json::validate_utf8(data, json::SimdLevel::Scalar));
+}
+
+namespace {
+
+struct HostCommand {
+    std::string host;
+};
+JSON_BIND(HostCommand, host)
+
+} // namespace
+
+TEST(JsonBindTest, SkippedValuesAreValidated) {
+    HostCommand command;
+    std::string error;
+    ASSERT_TRUE(json::from_json(
+        R"({"zz":[1,-2.5e3,{"a":"é\n","b":[]},true,false,null],)"
+        R"("host":"a","yy":{}})",
+        command, &error))
+        << error;
+    EXPECT_EQ(command.host, "a");
+
+    const std::vector<std::pair<std::string, std::string>> invalid = {
+        {R"({"host":"a","zz":[1 2 ,, tru]})", "Expected ',' or ']' in array"},
+        {R"({"zz":{"a" "b" : }})", "Expected ':' after object key"},
+        {R"({"zz":"\q"})", "Invalid escape sequence: \\q"},
+        {R"({"zz":01})", "Leading zero in number is not allowed"},
+        {R"({"zz":[1,]})", "Unexpected character: ]"},
+        {R"({"zz":[tru]})", "Expect 'true'"},
+        {R"({"zz":{"a":1,}})", "Expected '\"' at start of object key"},
+        {R"({"zz":{"a":}})", "Unexpected character: }"},
+        {R"({"zz":"\ud800"})", "Invalid Unicode surrogate pair"},
+        {R"({"zz":1.})", "Invalid number format after decimal point"},
+    };
+    for (const auto &[body, message] : invalid) {
+        error.clear();
+        EXPECT_FALSE(json::from_json(body, command, &error)) << body;
+        EXPECT_EQ(error, message) << body;
+
+        // 批量上传的路径：先按元素切分再逐条绑定
+        size_t rejected = 0;
+        JsonElementSplitter splitter([&](std::string_view element) {
+            HostCommand c;
+            rejected += !json::from_json(element, c);
+        });
+        splitter.feed("[" + body + "," + body + "]");
+        splitter.finish();
+        EXPECT_EQ(rejected, 2u) << body;
+    }
+
+    // 嵌套过深的跳过值
+    std::string deep = R"({"zz":)" + std::string(2000, '[') +
+                       std::string(2000, ']') + "}";
+    EXPECT_FALSE(json::from_json(deep, command, &error));
+    EXPECT_EQ(error, "JSON nesting too deep");
+}
+
+namespace {
+
+void ignore_signal(int) {}
+
+} // namespace
+
+TEST(ResponseWriteTest, ResumesPartialWrites) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int buffer_size = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &buffer_size,
+               sizeof(buffer_size));
+
+    std::string received;
+    std::thread reader([&] {
+        char buffer[1000];
+        while (true) {
+            ssize_t n = ::read(fds[1], buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            received.append(buffer, static_cast<size_t>(n));
+        }
+    });
+
+    // 不带 SA_RESTART 的信号打断阻塞的写入，产生 EINTR 与部分写入。
+    // 信号用 pthread_kill 只发给写入的线程，不会打断其他线程
+    struct sigaction action {};
+    struct sigaction previous {};
+    action.sa_handler = ignore_signal;
+    sigaction(SIGALRM, &action, &previous);
+    std::atomic<bool> writing{true};
+    pthread_t writer = pthread_self();
+    std::thread interrupter([&] {
+        while (writing.load()) {
+            pthread_kill(writer, SIGALRM);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    std::string body;
+    for (size_t i = 0; body.size() < (1 << 22); i++) {
+        body += std::to_string(i) + ',';
+    }
+    Response res(fds[0]);
+    res.send(body);
+    EXPECT_TRUE(res.complete());
+    uint64_t head = res.bytes_sent() - body.size();
+
+    res.reset();
+    res.begin_chunked();
+    for (size_t i = 0; i < body.size(); i += 300000) {
+        res.write_chunk(std::string_view(body).substr(i, 300000));
+    }
+    res.end_chunked();
+    EXPECT_TRUE(res.complete());
+
+    writing = false;
+    interrupter.join();
+    sigaction(SIGALRM, &previous, nullptr);
+    ::close(fds[0]);
+    reader.join();
+    ::close(fds[1]);
+
+    ASSERT_GT(received.size(), head + body.size());
+    EXPECT_EQ(received.compare(head, body.size(), body), 0);
+    // 解开分块编码后应与原文一致
+    std::string_view chunked =
+        std::string_view(received).substr(head + body.size());
+    chunked.remove_prefix(chunked.find("\r\n\r\n") + 4);
+    std::string decoded;
+    while (true) {
+        size_t line_end = chunked.find("\r\n");
+        ASSERT_NE(line_end, std::string_view::npos);
+        size_t size = std::stoul(std::string(chunked.substr(0, line_end)),
+                                 nullptr, 16);
+        chunked.remove_prefix(line_end + 2);
+        if (size == 0) {
+            break;
+        }
+        decoded.append(chunked.substr(0, size));
+        ASSERT_EQ(chunked.substr(size, 2), "\r\n");
+        chunked.remove_prefix(size + 2);
+    }
+    EXPECT_EQ(decoded, body);
+    EXPECT_EQ(chunked, "\r\n");
+}
+
+TEST(ResponseWriteTest, FailsWithoutSigpipe) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ::close(fds[1]);
+
+    // 对端已关闭，写入得到 EPIPE 而不是终止进程
+    Response res(fds[0]);
+    res.send("hello");
+    EXPECT_FALSE(res.complete());
+
+    res.reset();
+    res.begin_chunked();
+    res.write_chunk("data");
+    res.end_chunked();
+    EXPECT_FALSE(res.complete());
+    ::close(fds[0]);
+}
+
+TEST(RequestBodyTest, RejectsOversizedContentLength) {
+    Request req;
+    const std::string head = "POST /x HTTP/1.1\r\nContent-Length: ";
+    EXPECT_EQ(error_of([&] { parse_request(head + "101\r\n\r\n", req, 100); }),
+              "413 Content Too Large");
+    req.reset();
+    EXPECT_NO_THROW(parse_request(head + "100\r\n\r\n", req, 100));
+
+    // 没有上限时，声明的长度远大于实际收到的数据也不会预先分配
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_EQ(::write(fds[1], "def", 3), 3);
+    ::close(fds[1]);
+    Request streamed(fds[0]);
+    parse_request(head + "1125899906842624\r\n\r\nabc", streamed);
+    EXPECT_EQ(error_of([&] { streamed.body(); }), "400 Bad Request");
+    ::close(fds[0]);
+}
+
+namespace {
+
+// parse_request 抛出的 HttpError 的状态码，没有抛出时为 0
+int parse_status(std::string_view raw) {
+    Request req;
+    try {
+        parse_request(raw, req, 100);
+    } catch (const HttpError &e) {
+        return e.status();
+    }
+    return 0;
+}
+
+} // namespace
+
+TEST(HttpErrorTest, MapsExceptionsToStatus) {
+    EXPECT_EQ(error_status(HttpError(404)), 404);
+    EXPECT_EQ(error_status(HttpError(431, "Request header too large")), 431);
+    EXPECT_EQ(error_status(std::runtime_error("boom")), 500);
+    EXPECT_EQ(error_status(std::logic_error("boom")), 500);
+
+    EXPECT_STREQ(HttpError(415).what(), "415 Unsupported Media Type");
+    EXPECT_STREQ(HttpError(400, "Invalid Content-Length").what(),
+                 "Invalid Content-Length");
+    EXPECT_EQ(status_text(413), "413 Content Too Large");
+    EXPECT_EQ(status_text(405), "405 Method Not Allowed");
+}
+
+TEST(HttpErrorTest, ClientFramingErrorsAreNotServerErrors) {
+    const std::string head = "POST /x HTTP/1.1\r\n";
+    EXPECT_EQ(parse_status(head + "Content-Length: 12x\r\n\r\n"), 400);
+    EXPECT_EQ(parse_status(head + "Content-Length: -1\r\n\r\n"), 400);
+    EXPECT_EQ(parse_status(head + "Content-Length: \r\n\r\n"), 400);
+    EXPECT_EQ(parse_status(head + "Content-Length: 101\r\n\r\n"), 413);
+    EXPECT_EQ(parse_status(head + "Host: a\r\n"), 400);
+    EXPECT_EQ(parse_status(head + "Content-Length: 100\r\n\r\n"), 0);
+}
+
+TEST(HttpErrorTest, RejectsAmbiguousBodyFraming) {
+    const std::string head = "POST /x HTTP/1.1\r\n";
+    // 分块的请求体不会被当作下一个请求
+    EXPECT_EQ(parse_status(head + "Transfer-Encoding: chunked\r\n\r\n"
+                                  "5\r\nhello\r\n0\r\n\r\n"),
+              501);
+    EXPECT_EQ(parse_status(head + "transfer-encoding: Chunked\r\n"
+                                  "Content-Length: 5\r\n\r\nhello"),
+              501);
+    EXPECT_EQ(parse_status(head + "Transfer-Encoding: gzip, chunked\r\n\r\n"),
+              400);
+    EXPECT_EQ(parse_status(head + "Transfer-Encoding: identity\r\n\r\n"),
+              400);
+
+    EXPECT_EQ(parse_status(head + "Content-Length: 5\r\n"
+                                  "Content-Length: 6\r\n\r\nhello!"),
+              400);
+    EXPECT_EQ(parse_status(head + "Content-Length: 0\r\ncontent-length: 5"
+                                  "\r\n\r\nhello"),
+              400);
+    // 重复但取值相同的 Content-Length 可以接受
+    Request req;
+    const std::string raw =
+        head + "Content-Length: 5\r\nContent-Length: 5\r\n\r\nhelloGET";
+    EXPECT_EQ(parse_request(raw, req), raw.size() - 3);
+    EXPECT_EQ(req.body_str(), "hello");
+}
+
+TEST(RequestArenaTest, FormAndArenaBlocksAvoidTheHeap) {
+    Request req;
+    parse_post(req, "application/x-www-form-urlencoded",
+               "name=a+long+enough+value+to+leave+sso&tag=%E4%B8%AD&empty=");
+    EXPECT_EQ(count_allocations([&] { EXPECT_EQ(req.form().size(), 3u); }),
+              0u);
+    EXPECT_EQ(req.form()[0].second, "a long enough value to leave sso");
+
+    // 连接线程结束后，它用过的初始缓冲区由之后的连接继续使用，
+    // 新线程上的 Request 只分配 RequestArena 对象本身
+    { Request warm; }
+    size_t n = 0;
+    std::thread([&] { n = count_allocations([] { Request fresh; }); }).join();
+    EXPECT_EQ(n, 1u);
+}
+
+TEST(AccessLogTest, ExtensionMethodsAreNamedInTextLog) {
+    std::string path = (fs::temp_directory_path() /
+                        ("access-ext-" + std::to_string(::getpid())))
+                           .string();
+    {
+        AccessLog log(path, 64, AccessLog::Overflow::Block);
+        AccessRecord record;
+        record.time_us = 1700000000000000;
+        record.status = 405;
+        record.set_target("/a", "");
+        record.set_method(Method::Extension, "PURGE");
+        log.record(record);
+        record.set_method(Method::Extension, "");
+        log.record(record);
+        // 已知方法不保留扩展名
+        record.set_method(Method::Get, "PURGE");
+        log.record(record);
+    }
+
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_NE(lines[0].find(" PURGE /a 405 "), std::string::npos) << lines[0];
+    EXPECT_NE(lines[1].find(" - /a 405 "), std::string::npos) << lines[1];
+    EXPECT_NE(lines[2].find(" GET /a 405 "), std::string::npos) << lines[2];
+    fs::remove(path);
+
+    AccessRecord record;
+    record.set_method(Method::Extension, std::string(40, 'X'));
+    EXPECT_EQ(record.method_view(),
+              std::string(AccessRecord::kMaxExtension, 'X'));
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
@@ -0,0 +1,236 @@
+// 二进制访问日志的解码、过滤与汇总
+// 用法: access_log_tool [-s STATUS] [-p PREFIX] [-r ROUTE] [-g KEY] FILE...
+//   -s STATUS  只保留该状态码，如 404；4xx 表示一类
+//   -p PREFIX  只保留目标以 PREFIX 开头的记录
+//   -r ROUTE   只保留匹配该路由模式的记录，如 /api/v1/commands
+//   -g KEY     按 route、target、status 或 method 汇总，不逐条输出
+// FILE 为 - 时读标准输入。逐条输出的格式与文本访问日志相同，
+// 匹配了路由时行尾附加路由模式。
+
+#include "BinaryAccessLog.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string status; // "404" 或 "4xx"
+    std::string prefix;
+    std::string route;
+    std::string group;
+    std::vector<std::string> files;
+};
+
+// 延迟按 Metrics 的对数线性桶计数，每组内存固定；分位数取桶上界，
+// 相对误差不超过 1/Metrics::kSubBuckets
+struct Group {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t total_us = 0;
+    uint32_t max_us = 0;
+    std::array<uint64_t, Metrics::kBuckets + 1> buckets{};
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: access_log_tool [-s STATUS] [-p PREFIX] [-r ROUTE] "
+                 "[-g route|target|status|method] FILE...\n");
+    std::exit(2);
+}
+
+bool parse_options(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+            std::string value = argv[++i];
+            switch (arg[1]) {
+            case 's':
+                options.status = value;
+                break;
+            case 'p':
+                options.prefix = value;
+                break;
+            case 'r':
+                options.route = value;
+                break;
+            case 'g':
+                if (value != "route" && value != "target" &&
+                    value != "status" && value != "method") {
+                    return false;
+                }
+                options.group = value;
+                break;
+            default:
+                return false;
+            }
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    return !options.files.empty();
+}
+
+bool status_matches(const std::string &filter, uint16_t status) {
+    if (filter.empty()) {
+        return true;
+    }
+    std::string code = std::to_string(status);
+    if (filter.size() != code.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < code.size(); i++) {
+        if (filter[i] != 'x' && filter[i] != 'X' && filter[i] != code[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 二进制记录不带扩展方法的原文，与文本日志一样写 "-"
+std::string_view method_text(Method method) {
+    return method == Method::Extension ? "-" : method_name(method);
+}
+
+void print_record(const access_log::DecodedRecord &record) {
+    time_t second = static_cast<time_t>(record.time_us / 1000000);
+    tm local{};
+    localtime_r(&second, &local);
+    char time_text[32];
+    std::strftime(time_text, sizeof(time_text), "%Y-%m-%d %H:%M:%S", &local);
+
+    std::string method(method_text(record.method));
+    std::string target(record.target);
+    std::printf("%s.%03d %s %s %u %llu %uus", time_text,
+                static_cast<int>(record.time_us / 1000 % 1000),
+                method.c_str(), target.c_str(), record.status,
+                static_cast<unsigned long long>(record.bytes),
+                record.latency_us);
+    if (!record.route.empty()) {
+        std::printf(" %.*s", static_cast<int>(record.route.size()),
+                    record.route.data());
+    }
+    std::printf("\n");
+}
+
+uint64_t percentile(const Group &group, double p) {
+    uint64_t rank = static_cast<uint64_t>(p * (group.count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Metrics::kBuckets; i++) {
+        seen += group.buckets[i];
+        if (seen >= rank) {
+            return std::min<uint64_t>(Metrics::bucket_upper_bound(i),
+                                      group.max_us);
+        }
+    }
+    // 落在溢出桶里，没有更好的上界
+    return group.max_us;
+}
+
+void print_groups(std::map<std::string, Group> &groups) {
+    std::vector<std::pair<const std::string, Group> *> sorted;
+    for (auto &entry : groups) {
+        sorted.push_back(&entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto *a, auto *b) {
+        return a->second.count > b->second.count;
+    });
+
+    std::printf("%10s %14s %10s %10s %10s %10s  %s\n", "count", "bytes",
+                "avg_us", "p50_us", "p99_us", "max_us", "key");
+    for (auto *entry : sorted) {
+        const Group &group = entry->second;
+        std::printf("%10llu %14llu %10llu %10llu %10llu %10u  %s\n",
+                    static_cast<unsigned long long>(group.count),
+                    static_cast<unsigned long long>(group.bytes),
+                    static_cast<unsigned long long>(group.total_us /
+                                                    group.count),
+                    static_cast<unsigned long long>(percentile(group, 0.5)),
+                    static_cast<unsigned long long>(percentile(group, 0.99)),
+                    group.max_us, entry->first.c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+    }
+
+    std::map<std::string, Group> groups;
+    uint64_t dropped = 0;
+
+    auto on_record = [&](const access_log::DecodedRecord &record) {
+        if (!status_matches(options.status, record.status) ||
+            record.target.substr(0, options.prefix.size()) != options.prefix ||
+            (!options.route.empty() && record.route != options.route)) {
+            return;
+        }
+        if (options.group.empty()) {
+            print_record(record);
+            return;
+        }
+
+        std::string key;
+        if (options.group == "route") {
+            key = record.route.empty() ? "-" : std::string(record.route);
+        } else if (options.group == "target") {
+            key = record.target;
+        } else if (options.group == "status") {
+            key = std::to_string(record.status);
+        } else {
+            key = method_text(record.method);
+        }
+        Group &group = groups[key];
+        group.count++;
+        group.bytes += record.bytes;
+        group.total_us += record.latency_us;
+        group.max_us = std::max(group.max_us, record.latency_us);
+        group.buckets[Metrics::bucket_index(record.latency_us)]++;
+    };
+
+    std::vector<char> buffer(1 << 20);
+    for (const std::string &file : options.files) {
+        FILE *in = file == "-" ? stdin : std::fopen(file.c_str(), "rb");
+        if (!in) {
+            std::fprintf(stderr, "%s: %s\n", file.c_str(),
+                         std::strerror(errno));
+            return 1;
+        }
+        access_log::BinaryDecoder decoder(
+            on_record, [&](uint64_t count) { dropped += count; });
+        try {
+            size_t n;
+            while ((n = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+                decoder.feed(std::string_view(buffer.data(), n));
+            }
+            decoder.finish();
+        } catch (const std::runtime_error &e) {
+            std::fprintf(stderr, "%s: %s\n", file.c_str(), e.what());
+            return 1;
+        }
+        if (in != stdin) {
+            std::fclose(in);
+        }
+    }
+
+    if (!options.group.empty()) {
+        print_groups(groups);
+    }
+    if (dropped > 0) {
+        std::fprintf(stderr, "%llu records were dropped while logging\n",
+                     static_cast<unsigned long long>(dropped));
+    }
+    return 0;
+}